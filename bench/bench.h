@@ -0,0 +1,275 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../include/allocator.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+Shared helpers for the bench/ programs: a monotonic clock, a counting
+Allocator wrapper, a latency histogram and a minimal JSON result writer.
+
+Every bench program writes one JSON document:
+
+    {"suite": "...", "version": "...", "results": [{...}, ...]}
+
+to the path given as argv[1], or to stdout when no path is given.
+*/
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+static inline uint64_t
+bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t
+bench_next_random(uint64_t *state)
+{
+    // xorshift64
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/*
+@brief:
+Read a size limit from the environment, falling back to fallback.
+*/
+static inline size_t
+bench_env_size(const char *name, size_t fallback)
+{
+    const char *value = getenv(name);
+    if(!value || !*value) return fallback;
+
+    char *end = NULL;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if(end == value) return fallback;
+
+    return (size_t)parsed;
+}
+
+/*
+Counting allocator: forwards to an inner Allocator and records bytes and
+calls. Single-threaded use only.
+*/
+typedef struct BenchCounter
+{
+    Allocator allocator;
+    const Allocator *inner;
+    uint64_t bytes_allocated;
+    uint64_t allocations;
+} BenchCounter;
+
+static inline void *
+bench_counter_allocate(void *context, size_t size)
+{
+    BenchCounter *counter = context;
+    counter->bytes_allocated += size;
+    ++counter->allocations;
+    return counter->inner->allocate(counter->inner->context, size);
+}
+
+static inline void *
+bench_counter_reallocate(void *context, void *pointer, size_t old_size,
+    size_t new_size)
+{
+    BenchCounter *counter = context;
+    if(new_size > old_size) counter->bytes_allocated += new_size - old_size;
+    ++counter->allocations;
+    return counter->inner->reallocate(counter->inner->context, pointer,
+        old_size, new_size);
+}
+
+static inline void
+bench_counter_deallocate(void *context, void *pointer, size_t size)
+{
+    BenchCounter *counter = context;
+    counter->inner->deallocate(counter->inner->context, pointer, size);
+}
+
+static inline void
+bench_counter_init(BenchCounter *counter, const Allocator *inner)
+{
+    counter->allocator.allocate = bench_counter_allocate;
+    counter->allocator.reallocate = bench_counter_reallocate;
+    counter->allocator.deallocate = bench_counter_deallocate;
+    counter->allocator.context = counter;
+    counter->inner = inner;
+    counter->bytes_allocated = 0;
+    counter->allocations = 0;
+}
+
+/*
+Log-linear latency histogram: 8 sub-buckets per power of two, so every
+recorded value is reported within 12.5% of its true value.
+*/
+enum
+{
+    BENCH_HISTOGRAM_SUB_BITS = 3,
+    BENCH_HISTOGRAM_BUCKETS = 64 << BENCH_HISTOGRAM_SUB_BITS,
+};
+
+typedef struct BenchHistogram
+{
+    uint64_t counts[BENCH_HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} BenchHistogram;
+
+static inline void
+bench_histogram_init(BenchHistogram *histogram)
+{
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+static inline size_t
+bench_histogram_bucket(uint64_t value)
+{
+    const uint64_t sub = (uint64_t)1 << BENCH_HISTOGRAM_SUB_BITS;
+    if(value < sub) return (size_t)value;
+
+    unsigned exponent = 63u - (unsigned)__builtin_clzll(value);
+    unsigned shift = exponent - BENCH_HISTOGRAM_SUB_BITS;
+
+    return ((size_t)(shift + 1) << BENCH_HISTOGRAM_SUB_BITS) +
+        (size_t)((value >> shift) & (sub - 1));
+}
+
+static inline uint64_t
+bench_histogram_bucket_value(size_t bucket)
+{
+    const uint64_t sub = (uint64_t)1 << BENCH_HISTOGRAM_SUB_BITS;
+    if(bucket < sub) return bucket;
+
+    unsigned shift = (unsigned)(bucket >> BENCH_HISTOGRAM_SUB_BITS) - 1;
+
+    return (sub + (bucket & (sub - 1))) << shift;
+}
+
+static inline void
+bench_histogram_record(BenchHistogram *histogram, uint64_t value)
+{
+    ++histogram->counts[bench_histogram_bucket(value)];
+    ++histogram->total;
+    if(value > histogram->max) histogram->max = value;
+}
+
+/*
+@brief:
+Lower bound of the bucket holding the given percentile (0..100).
+*/
+static inline uint64_t
+bench_histogram_percentile(const BenchHistogram *histogram, double percentile)
+{
+    if(histogram->total == 0) return 0;
+
+    uint64_t rank = (uint64_t)((double)histogram->total * percentile / 100.0);
+    if(rank >= histogram->total) rank = histogram->total - 1;
+
+    uint64_t seen = 0;
+    for(size_t i = 0; i < BENCH_HISTOGRAM_BUCKETS; ++i)
+    {
+        seen += histogram->counts[i];
+        if(seen > rank) return bench_histogram_bucket_value(i);
+    }
+
+    return histogram->max;
+}
+
+typedef struct BenchJson
+{
+    FILE *out;
+    bool first_result;
+    bool first_field;
+} BenchJson;
+
+static inline int
+bench_json_open(BenchJson *json, int argc, char **argv, const char *suite)
+{
+    json->out = stdout;
+    json->first_result = true;
+    json->first_field = true;
+
+    if(argc > 1)
+    {
+        json->out = fopen(argv[1], "w");
+        if(!json->out)
+        {
+            perror(argv[1]);
+            return -1;
+        }
+    }
+
+    fprintf(json->out, "{\"suite\": \"%s\", \"version\": \"%s\", "
+                       "\"results\": [",
+        suite, BENCH_VERSION);
+
+    return 0;
+}
+
+static inline void
+bench_json_begin(BenchJson *json)
+{
+    fprintf(json->out, "%s\n  {", json->first_result ? "" : ",");
+    json->first_result = false;
+    json->first_field = true;
+}
+
+static inline void
+bench_json_key(BenchJson *json, const char *key)
+{
+    fprintf(json->out, "%s\"%s\": ", json->first_field ? "" : ", ", key);
+    json->first_field = false;
+}
+
+static inline void
+bench_json_string(BenchJson *json, const char *key, const char *value)
+{
+    bench_json_key(json, key);
+    fprintf(json->out, "\"%s\"", value);
+}
+
+static inline void
+bench_json_u64(BenchJson *json, const char *key, uint64_t value)
+{
+    bench_json_key(json, key);
+    fprintf(json->out, "%llu", (unsigned long long)value);
+}
+
+static inline void
+bench_json_double(BenchJson *json, const char *key, double value)
+{
+    bench_json_key(json, key);
+    fprintf(json->out, "%.3f", value);
+}
+
+static inline void
+bench_json_end(BenchJson *json)
+{
+    fputc('}', json->out);
+    fflush(json->out);
+}
+
+static inline void
+bench_json_close(BenchJson *json)
+{
+    fprintf(json->out, "\n]}\n");
+
+    if(json->out != stdout) fclose(json->out);
+}
+
+#endif // !BENCH_H
@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+Compares allocator_default() (glibc malloc) with allocator_pool() on the
+allocation pattern of short-lived arrays: create, grow through every
+doubling, destroy. Each thread runs the same workload independently.
+*/
+
+static const size_t BENCH_ROUNDS = 20000;
+static const size_t BENCH_MAX_ELEMENTS = 512;
+static const size_t BENCH_THREADS[] = {1, 2, 4, 8};
+
+typedef struct BenchTask
+{
+    const Allocator *allocator;
+    uint64_t seed;
+    int error;
+} BenchTask;
+
+static void *
+bench_worker(void *argument)
+{
+    BenchTask *task = argument;
+    uint64_t state = task->seed;
+
+    for(size_t round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        Array *a = NULL;
+        if(array_create_with_allocator(&a, sizeof(uint64_t), task->allocator))
+        {
+            task->error = 1;
+            return NULL;
+        }
+
+        size_t n = (size_t)(bench_next_random(&state) % BENCH_MAX_ELEMENTS);
+        n += 1;
+        for(size_t i = 0; i < n; ++i)
+        {
+            uint64_t value = i;
+            if(array_push_back(a, &value))
+            {
+                task->error = 1;
+                break;
+            }
+        }
+
+        array_destroy(&a);
+    }
+
+    if(task->allocator == allocator_pool()) allocator_pool_thread_flush();
+
+    return NULL;
+}
+
+static double
+bench_run(const Allocator *allocator, size_t threads)
+{
+    pthread_t workers[8];
+    BenchTask tasks[8];
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < threads; ++i)
+    {
+        tasks[i].allocator = allocator;
+        tasks[i].seed = 0x9E3779B97F4A7C15u * (i + 1);
+        tasks[i].error = 0;
+        pthread_create(&workers[i], NULL, bench_worker, &tasks[i]);
+    }
+
+    int error = 0;
+    for(size_t i = 0; i < threads; ++i)
+    {
+        pthread_join(workers[i], NULL);
+        error |= tasks[i].error;
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if(error)
+    {
+        fprintf(stderr, "bench_allocator: allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return (double)elapsed / (double)(BENCH_ROUNDS * threads);
+}
+
+static void
+bench_report(BenchJson *json, const char *backend, size_t threads,
+    double ns_per_array)
+{
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "array_lifecycle");
+    bench_json_string(json, "backend", backend);
+    bench_json_u64(json, "threads", threads);
+    bench_json_u64(json, "ops", BENCH_ROUNDS * threads);
+    bench_json_double(json, "ns_per_op", ns_per_array);
+    bench_json_end(json);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "allocator")) return EXIT_FAILURE;
+
+    for(size_t t = 0; t < sizeof(BENCH_THREADS) / sizeof(BENCH_THREADS[0]);
+        ++t)
+    {
+        size_t threads = BENCH_THREADS[t];
+
+        double malloc_ns = bench_run(allocator_default(), threads);
+        double pool_ns = bench_run(allocator_pool(), threads);
+
+        bench_report(&json, "malloc", threads, malloc_ns);
+        bench_report(&json, "pool", threads, pool_ns);
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
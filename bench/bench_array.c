@@ -0,0 +1,430 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Microbenchmarks for the Array API.
+
+For every element size in BENCH_ELEMENT_SIZES and every array size
+10, 100, ..., 10^8 this measures ns/op and allocator traffic for:
+
+    push_back          grow an empty array to n elements
+    push_front         push_front + pop_back at size n
+    insert_{head,middle,tail} / erase_{head,middle,tail}
+                       k inserts then k erases at a fixed position
+    get / set          random access over n elements
+    reserve_growth     array_reserve through every doubling up to n
+    remove_if          drop every other element in one array_remove_if
+    apply_batch        n/100 evenly spread inserts and erases in one
+                       array_apply_batch
+
+Cases whose footprint exceeds BENCH_MAX_BYTES (default 256 MiB) are
+skipped, and O(n) operations are capped so each case moves at most
+BENCH_MOVE_BYTES (default 256 MiB). Both limits can be set in the
+environment.
+*/
+
+static const size_t BENCH_ELEMENT_SIZES[] = {1, 8, 64, 256};
+static const size_t BENCH_MAX_EXPONENT = 8;
+static const size_t BENCH_MAX_OPS = 100000;
+static const size_t BENCH_RANDOM_OPS = 1000000;
+
+typedef struct BenchCase
+{
+    BenchJson *json;
+    size_t element_size;
+    size_t size;
+    size_t move_bytes;
+    unsigned char *value;
+} BenchCase;
+
+static volatile unsigned char bench_sink;
+
+static void
+bench_report(const BenchCase *c, const char *name, uint64_t ops,
+    uint64_t elapsed_ns, const BenchCounter *counter)
+{
+    bench_json_begin(c->json);
+    bench_json_string(c->json, "benchmark", name);
+    bench_json_u64(c->json, "element_size", c->element_size);
+    bench_json_u64(c->json, "size", c->size);
+    bench_json_u64(c->json, "ops", ops);
+    bench_json_double(c->json, "ns_per_op",
+        ops ? (double)elapsed_ns / (double)ops : 0.0);
+    bench_json_u64(c->json, "bytes_allocated",
+        counter ? counter->bytes_allocated : 0);
+    bench_json_u64(c->json, "allocations", counter ? counter->allocations : 0);
+    bench_json_end(c->json);
+}
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_array: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+/*
+@brief:
+Create an array of c->size zero-filled elements through counter.
+*/
+static Array *
+bench_filled(const BenchCase *c, BenchCounter *counter)
+{
+    Array *a = NULL;
+    if(array_create_with_allocator(&a, c->element_size, &counter->allocator))
+    {
+        bench_fail("array_create");
+    }
+
+    if(array_reserve(a, c->size + 1)) bench_fail("array_reserve");
+
+    const size_t chunk = 4096;
+    unsigned char *zeros = calloc(chunk, c->element_size);
+    if(!zeros) bench_fail("calloc");
+
+    for(size_t done = 0; done < c->size;)
+    {
+        size_t n = c->size - done < chunk ? c->size - done : chunk;
+        if(array_push_back_n(a, zeros, n)) bench_fail("array_push_back_n");
+        done += n;
+    }
+
+    free(zeros);
+
+    return a;
+}
+
+/*
+@brief:
+Number of O(n) operations allowed at the current size.
+*/
+static size_t
+bench_linear_ops(const BenchCase *c, size_t moved_elements)
+{
+    size_t bytes = (moved_elements + 1) * c->element_size;
+    size_t ops = c->move_bytes / bytes;
+
+    if(ops < 1) ops = 1;
+    if(ops > BENCH_MAX_OPS) ops = BENCH_MAX_OPS;
+
+    return ops;
+}
+
+static void
+bench_push_back(const BenchCase *c)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = NULL;
+    if(array_create_with_allocator(&a, c->element_size, &counter.allocator))
+    {
+        bench_fail("array_create");
+    }
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < c->size; ++i)
+    {
+        if(array_push_back(a, c->value)) bench_fail("array_push_back");
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(c, "push_back", c->size, elapsed, &counter);
+
+    array_destroy(&a);
+}
+
+static void
+bench_push_front(const BenchCase *c)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = bench_filled(c, &counter);
+    size_t ops = bench_linear_ops(c, c->size);
+
+    counter.bytes_allocated = 0;
+    counter.allocations = 0;
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < ops; ++i)
+    {
+        if(array_push_front(a, c->value)) bench_fail("array_push_front");
+        array_pop_back(a);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(c, "push_front", ops, elapsed, &counter);
+
+    array_destroy(&a);
+}
+
+typedef enum BenchPosition
+{
+    BENCH_HEAD,
+    BENCH_MIDDLE,
+    BENCH_TAIL,
+} BenchPosition;
+
+static const char *const BENCH_POSITION_NAMES[] = {"head", "middle", "tail"};
+
+/*
+@brief:
+Index an insert (or erase) at the given position touches at size n.
+*/
+static size_t
+bench_position(BenchPosition where, size_t n, int erase)
+{
+    switch(where)
+    {
+        case BENCH_HEAD:
+            return 0;
+        case BENCH_MIDDLE:
+            return n / 2;
+        case BENCH_TAIL:
+        default:
+            return erase ? n - 1 : n;
+    }
+}
+
+static void
+bench_insert_erase(const BenchCase *c, BenchPosition where)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = bench_filled(c, &counter);
+
+    size_t moved = c->size - bench_position(where, c->size, 0);
+    size_t ops = bench_linear_ops(c, moved);
+    if(ops > c->size) ops = c->size ? c->size : 1;
+
+    counter.bytes_allocated = 0;
+    counter.allocations = 0;
+
+    // inserting k elements grows the array once; reserve it up front so
+    // the measurement is pure element movement
+    if(array_reserve(a, c->size + ops)) bench_fail("array_reserve");
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < ops; ++i)
+    {
+        size_t index = bench_position(where, array_size(a), 0);
+        if(array_insert(a, c->value, index)) bench_fail("array_insert");
+    }
+    uint64_t insert_elapsed = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(size_t i = 0; i < ops; ++i)
+    {
+        size_t index = bench_position(where, array_size(a), 1);
+        if(array_erase(a, index)) bench_fail("array_erase");
+    }
+    uint64_t erase_elapsed = bench_now_ns() - start;
+
+    char name[32];
+
+    snprintf(name, sizeof(name), "insert_%s", BENCH_POSITION_NAMES[where]);
+    bench_report(c, name, ops, insert_elapsed, &counter);
+
+    snprintf(name, sizeof(name), "erase_%s", BENCH_POSITION_NAMES[where]);
+    bench_report(c, name, ops, erase_elapsed, NULL);
+
+    array_destroy(&a);
+}
+
+static void
+bench_get_set(const BenchCase *c)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = bench_filled(c, &counter);
+
+    size_t ops = BENCH_RANDOM_OPS;
+    size_t *indices = malloc(ops * sizeof(*indices));
+    if(!indices) bench_fail("malloc");
+
+    uint64_t state = 0x2545F4914F6CDD1Du;
+    for(size_t i = 0; i < ops; ++i)
+    {
+        indices[i] = (size_t)(bench_next_random(&state) % c->size);
+    }
+
+    unsigned char *out = malloc(c->element_size);
+    if(!out) bench_fail("malloc");
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < ops; ++i)
+    {
+        if(array_get(a, indices[i], out)) bench_fail("array_get");
+        bench_sink ^= out[0];
+    }
+    uint64_t get_elapsed = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(size_t i = 0; i < ops; ++i)
+    {
+        if(array_set(a, indices[i], c->value)) bench_fail("array_set");
+    }
+    uint64_t set_elapsed = bench_now_ns() - start;
+
+    bench_report(c, "get", ops, get_elapsed, NULL);
+    bench_report(c, "set", ops, set_elapsed, NULL);
+
+    free(out);
+    free(indices);
+    array_destroy(&a);
+}
+
+static void
+bench_reserve_growth(const BenchCase *c)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = NULL;
+    if(array_create_with_allocator(&a, c->element_size, &counter.allocator))
+    {
+        bench_fail("array_create");
+    }
+
+    uint64_t ops = 0;
+    uint64_t start = bench_now_ns();
+    while(array_capacity(a) < c->size)
+    {
+        if(array_reserve(a, array_capacity(a) + 1))
+        {
+            bench_fail("array_reserve");
+        }
+        ++ops;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(c, "reserve_growth", ops, elapsed, &counter);
+
+    array_destroy(&a);
+}
+
+static bool
+bench_every_other(const void *element, void *context)
+{
+    (void)element;
+    size_t *index = context;
+    return (*index)++ % 2 == 0;
+}
+
+static void
+bench_remove_if(const BenchCase *c)
+{
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = bench_filled(c, &counter);
+
+    size_t index = 0;
+
+    uint64_t start = bench_now_ns();
+    if(array_remove_if(a, bench_every_other, &index))
+    {
+        bench_fail("array_remove_if");
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(c, "remove_if", c->size, elapsed, NULL);
+
+    array_destroy(&a);
+}
+
+static void
+bench_apply_batch(const BenchCase *c)
+{
+    size_t count = c->size / 100 ? c->size / 100 : 1;
+
+    ArrayEdit *edits = malloc(count * sizeof(*edits));
+    if(!edits) bench_fail("malloc");
+
+    // alternate insert/erase at evenly spaced, strictly increasing indices
+    for(size_t i = 0; i < count; ++i)
+    {
+        edits[i].index = i * (c->size / count);
+        edits[i].op = i % 2 ? ARRAY_EDIT_ERASE : ARRAY_EDIT_INSERT;
+        edits[i].value = c->value;
+    }
+
+    BenchCounter counter;
+    bench_counter_init(&counter, allocator_default());
+
+    Array *a = bench_filled(c, &counter);
+
+    uint64_t start = bench_now_ns();
+    if(array_apply_batch(a, edits, count)) bench_fail("array_apply_batch");
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(c, "apply_batch", count, elapsed, NULL);
+
+    array_destroy(&a);
+    free(edits);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t max_bytes = bench_env_size("BENCH_MAX_BYTES", (size_t)256 << 20);
+    size_t move_bytes = bench_env_size("BENCH_MOVE_BYTES", (size_t)256 << 20);
+
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "array")) return EXIT_FAILURE;
+
+    for(size_t e = 0;
+        e < sizeof(BENCH_ELEMENT_SIZES) / sizeof(BENCH_ELEMENT_SIZES[0]); ++e)
+    {
+        size_t element_size = BENCH_ELEMENT_SIZES[e];
+
+        unsigned char *value = malloc(element_size);
+        if(!value) bench_fail("malloc");
+        memset(value, 0xA5, element_size);
+
+        size_t size = 10;
+        for(size_t exponent = 1; exponent <= BENCH_MAX_EXPONENT; ++exponent)
+        {
+            // growth needs old and new buffer at the same time
+            if(size > max_bytes / element_size / 2) break;
+
+            BenchCase c = {
+                .json = &json,
+                .element_size = element_size,
+                .size = size,
+                .move_bytes = move_bytes,
+                .value = value,
+            };
+
+            bench_push_back(&c);
+            bench_push_front(&c);
+            bench_insert_erase(&c, BENCH_HEAD);
+            bench_insert_erase(&c, BENCH_MIDDLE);
+            bench_insert_erase(&c, BENCH_TAIL);
+            bench_get_set(&c);
+            bench_reserve_growth(&c);
+            bench_remove_if(&c);
+            bench_apply_batch(&c);
+
+            size *= 10;
+        }
+
+        free(value);
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/concurrent_array.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+Multi-producer append throughput: every thread appends BENCH_APPENDS
+8-byte values into one shared container.
+
+    mutex       array_push_back under one pthread mutex
+    concurrent  concurrent_array_push_back, no lock
+*/
+
+static const size_t BENCH_APPENDS = 1000000;
+static const size_t BENCH_THREADS[] = {1, 2, 4, 8, 16};
+
+enum
+{
+    BENCH_MAX_THREADS = 16
+};
+
+typedef struct BenchShared
+{
+    pthread_mutex_t lock;
+    Array *array;
+    ConcurrentArray *concurrent;
+} BenchShared;
+
+typedef struct BenchTask
+{
+    BenchShared *shared;
+    uint64_t id;
+    int error;
+} BenchTask;
+
+static void *
+bench_mutex_worker(void *argument)
+{
+    BenchTask *task = argument;
+
+    for(uint64_t i = 0; i < BENCH_APPENDS; ++i)
+    {
+        uint64_t value = task->id << 32 | i;
+
+        pthread_mutex_lock(&task->shared->lock);
+        if(array_push_back(task->shared->array, &value)) task->error = 1;
+        pthread_mutex_unlock(&task->shared->lock);
+    }
+
+    return NULL;
+}
+
+static void *
+bench_concurrent_worker(void *argument)
+{
+    BenchTask *task = argument;
+
+    for(uint64_t i = 0; i < BENCH_APPENDS; ++i)
+    {
+        uint64_t value = task->id << 32 | i;
+
+        if(concurrent_array_push_back(task->shared->concurrent, &value, NULL))
+        {
+            task->error = 1;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+bench_run(BenchJson *json, const char *backend, void *(*worker)(void *),
+    size_t threads)
+{
+    BenchShared shared;
+    pthread_mutex_init(&shared.lock, NULL);
+    shared.array = NULL;
+    shared.concurrent = NULL;
+
+    if(array_create(&shared.array, sizeof(uint64_t)) ||
+        concurrent_array_create(&shared.concurrent, sizeof(uint64_t)))
+    {
+        fprintf(stderr, "bench_concurrent_append: create failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_t workers[BENCH_MAX_THREADS];
+    BenchTask tasks[BENCH_MAX_THREADS];
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < threads; ++i)
+    {
+        tasks[i] = (BenchTask){&shared, i, 0};
+        pthread_create(&workers[i], NULL, worker, &tasks[i]);
+    }
+
+    int error = 0;
+    for(size_t i = 0; i < threads; ++i)
+    {
+        pthread_join(workers[i], NULL);
+        error |= tasks[i].error;
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if(error)
+    {
+        fprintf(stderr, "bench_concurrent_append: append failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t ops = BENCH_APPENDS * threads;
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "concurrent_append");
+    bench_json_string(json, "backend", backend);
+    bench_json_u64(json, "threads", threads);
+    bench_json_u64(json, "ops", ops);
+    bench_json_double(json, "ns_per_op", (double)elapsed / (double)ops);
+    bench_json_double(json, "mops_per_s",
+        (double)ops * 1e3 / (double)elapsed);
+    bench_json_end(json);
+
+    concurrent_array_destroy(&shared.concurrent);
+    array_destroy(&shared.array);
+    pthread_mutex_destroy(&shared.lock);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "concurrent_append"))
+    {
+        return EXIT_FAILURE;
+    }
+
+    for(size_t t = 0; t < sizeof(BENCH_THREADS) / sizeof(BENCH_THREADS[0]);
+        ++t)
+    {
+        bench_run(&json, "mutex", bench_mutex_worker, BENCH_THREADS[t]);
+        bench_run(&json, "concurrent", bench_concurrent_worker,
+            BENCH_THREADS[t]);
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/epoch_array.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+One writer appends 8-byte values (at most BENCH_APPENDS) while 1..16
+readers each fetch BENCH_READS random published elements; the writer
+stops when the readers are done.
+
+    rwlock  Array behind a pthread_rwlock_t: array_get under the read
+            lock, array_push_back under the write lock
+    epoch   EpochArray: epoch_array_get, epoch_array_push_back
+
+Reports the writer's ns per append and the readers' ns per get. A
+reader-preferring rwlock can starve the writer, which shows up as few
+appends.
+*/
+
+static const size_t BENCH_APPENDS = 20000000;
+static const size_t BENCH_READS = 1000000;
+static const size_t BENCH_READERS[] = {1, 2, 4, 8, 16};
+
+enum
+{
+    BENCH_MAX_READERS = 16
+};
+
+typedef struct BenchShared
+{
+    pthread_rwlock_t lock;
+    Array *array;
+    EpochArray *epoch;
+    atomic_size_t readers_left;
+    bool use_epoch;
+} BenchShared;
+
+typedef struct BenchReader
+{
+    BenchShared *shared;
+    uint64_t seed;
+    uint64_t reads;
+    uint64_t elapsed;
+    int error;
+} BenchReader;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_epoch_array: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void *
+bench_reader(void *argument)
+{
+    BenchReader *r = argument;
+    BenchShared *s = r->shared;
+    uint64_t state = r->seed;
+
+    EpochArrayReader *handle = NULL;
+    if(s->use_epoch && epoch_array_reader_acquire(s->epoch, &handle))
+    {
+        r->error = 1;
+        return NULL;
+    }
+
+    uint64_t start = bench_now_ns();
+
+    while(r->reads < BENCH_READS)
+    {
+        uint64_t value = 0;
+        int error;
+
+        if(s->use_epoch)
+        {
+            size_t size = epoch_array_size(s->epoch);
+            if(!size) continue;
+            error = epoch_array_get(handle,
+                (size_t)(bench_next_random(&state) % size), &value);
+        }
+        else
+        {
+            pthread_rwlock_rdlock(&s->lock);
+            size_t size = array_size(s->array);
+            error = size ? array_get(s->array,
+                               (size_t)(bench_next_random(&state) % size),
+                               &value)
+                         : 0;
+            pthread_rwlock_unlock(&s->lock);
+        }
+
+        r->error |= error;
+        ++r->reads;
+    }
+
+    r->elapsed = bench_now_ns() - start;
+    atomic_fetch_sub(&s->readers_left, 1);
+
+    epoch_array_reader_release(&handle);
+
+    return NULL;
+}
+
+static void
+bench_run(BenchJson *json, bool use_epoch, size_t readers)
+{
+    BenchShared s;
+    pthread_rwlock_init(&s.lock, NULL);
+    s.array = NULL;
+    s.epoch = NULL;
+    atomic_init(&s.readers_left, readers);
+    s.use_epoch = use_epoch;
+
+    if(array_create(&s.array, sizeof(uint64_t))) bench_fail("array_create");
+    if(epoch_array_create(&s.epoch, sizeof(uint64_t), BENCH_MAX_READERS))
+    {
+        bench_fail("epoch_array_create");
+    }
+
+    pthread_t threads[BENCH_MAX_READERS];
+    BenchReader tasks[BENCH_MAX_READERS];
+
+    for(size_t i = 0; i < readers; ++i)
+    {
+        tasks[i] = (BenchReader){&s, 0x9E3779B97F4A7C15u * (i + 1), 0, 0, 0};
+        pthread_create(&threads[i], NULL, bench_reader, &tasks[i]);
+    }
+
+    uint64_t appends = 0;
+    uint64_t start = bench_now_ns();
+    for(uint64_t i = 0; i < BENCH_APPENDS && atomic_load(&s.readers_left);
+        ++i)
+    {
+        int error;
+        if(use_epoch)
+        {
+            error = epoch_array_push_back(s.epoch, &i);
+        }
+        else
+        {
+            pthread_rwlock_wrlock(&s.lock);
+            error = array_push_back(s.array, &i);
+            pthread_rwlock_unlock(&s.lock);
+        }
+        if(error) bench_fail("push_back");
+        ++appends;
+    }
+    uint64_t writer = bench_now_ns() - start;
+
+    uint64_t reads = 0;
+    uint64_t read_ns = 0;
+    for(size_t i = 0; i < readers; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        if(tasks[i].error) bench_fail("get");
+        reads += tasks[i].reads;
+        read_ns += tasks[i].elapsed;
+    }
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "single_writer_readers");
+    bench_json_string(json, "backend", use_epoch ? "epoch" : "rwlock");
+    bench_json_u64(json, "readers", readers);
+    bench_json_u64(json, "appends", appends);
+    bench_json_double(json, "write_ns_per_op",
+        appends ? (double)writer / (double)appends : 0.0);
+    bench_json_u64(json, "reads", reads);
+    bench_json_double(json, "read_ns_per_op",
+        reads ? (double)read_ns / (double)reads : 0.0);
+    bench_json_end(json);
+
+    epoch_array_destroy(&s.epoch);
+    array_destroy(&s.array);
+    pthread_rwlock_destroy(&s.lock);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "epoch_array"))
+    {
+        return EXIT_FAILURE;
+    }
+
+    for(size_t r = 0; r < sizeof(BENCH_READERS) / sizeof(BENCH_READERS[0]);
+        ++r)
+    {
+        bench_run(&json, false, BENCH_READERS[r]);
+        bench_run(&json, true, BENCH_READERS[r]);
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
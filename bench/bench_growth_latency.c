@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+#include "../include/mmap_allocator.h"
+#include "../include/segmented_array.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Per-call latency of array_push_back while an array grows from empty to
+the largest size that fits BENCH_MAX_BYTES (default 256 MiB; about
+12 GiB reaches 10^8 elements), for:
+
+    malloc          allocator_default(): every doubling goes through realloc
+    mmap            mmap_allocator: doublings above the threshold use mremap
+    mmap_hugepage   as mmap, with 2 MiB-aligned MADV_HUGEPAGE mappings
+                    from 2 MiB up
+    incremental     allocator_default() with policy.incremental_step: each
+                    growth is drained BENCH_INCREMENTAL_STEP elements per
+                    push
+    segmented       SegmentedArray on allocator_default(): growth appends a
+                    chunk and copies nothing
+
+Reports p50/p99/p99.9/max of all pushes and the slowest growth step, plus
+one push_back_latency_window row per decade of size (pushes that took the
+array from 10^(k-1) to 10^k elements) to show whether the tail stays flat
+as the array grows.
+*/
+
+static const size_t BENCH_ELEMENT_SIZE = 64;
+static const size_t BENCH_MMAP_THRESHOLD = (size_t)1 << 20;
+static const size_t BENCH_INCREMENTAL_STEP = 16;
+static const size_t BENCH_FIRST_WINDOW = 1000;
+
+typedef struct BenchLatency
+{
+    BenchHistogram all;
+    BenchHistogram window;
+    size_t window_end;
+    uint64_t growths;
+    uint64_t growth_max;
+} BenchLatency;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_growth_latency: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void
+bench_latency_init(BenchLatency *latency)
+{
+    bench_histogram_init(&latency->all);
+    bench_histogram_init(&latency->window);
+    latency->window_end = BENCH_FIRST_WINDOW;
+    latency->growths = 0;
+    latency->growth_max = 0;
+}
+
+/*
+@brief:
+Record the push that made the array size elements long.
+*/
+static void
+bench_latency_record(BenchJson *json, const char *backend,
+    BenchLatency *latency, size_t size, uint64_t elapsed, bool grew)
+{
+    bench_histogram_record(&latency->all, elapsed);
+    bench_histogram_record(&latency->window, elapsed);
+
+    if(grew)
+    {
+        ++latency->growths;
+        if(elapsed > latency->growth_max) latency->growth_max = elapsed;
+    }
+
+    if(size != latency->window_end) return;
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "push_back_latency_window");
+    bench_json_string(json, "backend", backend);
+    bench_json_u64(json, "window_end", size);
+    bench_json_u64(json, "p99_ns",
+        bench_histogram_percentile(&latency->window, 99));
+    bench_json_u64(json, "p999_ns",
+        bench_histogram_percentile(&latency->window, 99.9));
+    bench_json_u64(json, "max_ns", latency->window.max);
+    bench_json_end(json);
+
+    bench_histogram_init(&latency->window);
+    latency->window_end *= 10;
+}
+
+static void
+bench_report(BenchJson *json, const char *backend, size_t size,
+    uint64_t total, const BenchLatency *latency)
+{
+    const BenchHistogram *histogram = &latency->all;
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "push_back_latency");
+    bench_json_string(json, "backend", backend);
+    bench_json_u64(json, "element_size", BENCH_ELEMENT_SIZE);
+    bench_json_u64(json, "size", size);
+    bench_json_double(json, "ns_per_op", (double)total / (double)size);
+    bench_json_u64(json, "p50_ns", bench_histogram_percentile(histogram, 50));
+    bench_json_u64(json, "p99_ns", bench_histogram_percentile(histogram, 99));
+    bench_json_u64(json, "p999_ns",
+        bench_histogram_percentile(histogram, 99.9));
+    bench_json_u64(json, "max_ns", histogram->max);
+    bench_json_u64(json, "growths", latency->growths);
+    bench_json_u64(json, "growth_max_ns", latency->growth_max);
+    bench_json_end(json);
+}
+
+static void
+bench_run(BenchJson *json, const char *backend, const Allocator *allocator,
+    const ArrayGrowthPolicy *policy, size_t size)
+{
+    static BenchLatency latency;
+    bench_latency_init(&latency);
+
+    Array *a = NULL;
+    if(array_create_with_allocator(&a, BENCH_ELEMENT_SIZE, allocator))
+    {
+        bench_fail("array_create");
+    }
+    if(array_set_growth_policy(a, policy))
+    {
+        bench_fail("array_set_growth_policy");
+    }
+
+    unsigned char value[BENCH_ELEMENT_SIZE];
+    memset(value, 0xA5, sizeof(value));
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < size; ++i)
+    {
+        size_t capacity = array_capacity(a);
+
+        uint64_t before = bench_now_ns();
+        if(array_push_back(a, value)) bench_fail("array_push_back");
+        uint64_t elapsed = bench_now_ns() - before;
+
+        bench_latency_record(json, backend, &latency, i + 1, elapsed,
+            array_capacity(a) != capacity);
+    }
+    uint64_t total = bench_now_ns() - start;
+
+    bench_report(json, backend, size, total, &latency);
+
+    array_destroy(&a);
+}
+
+static void
+bench_run_segmented(BenchJson *json, size_t size)
+{
+    static BenchLatency latency;
+    bench_latency_init(&latency);
+
+    SegmentedArray *a = NULL;
+    if(segmented_array_create(&a, BENCH_ELEMENT_SIZE))
+    {
+        bench_fail("segmented_array_create");
+    }
+
+    unsigned char value[BENCH_ELEMENT_SIZE];
+    memset(value, 0xA5, sizeof(value));
+
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < size; ++i)
+    {
+        size_t capacity = segmented_array_capacity(a);
+
+        uint64_t before = bench_now_ns();
+        if(segmented_array_push_back(a, value))
+        {
+            bench_fail("segmented_array_push_back");
+        }
+        uint64_t elapsed = bench_now_ns() - before;
+
+        bench_latency_record(json, "segmented", &latency, i + 1, elapsed,
+            segmented_array_capacity(a) != capacity);
+    }
+    uint64_t total = bench_now_ns() - start;
+
+    bench_report(json, "segmented", size, total, &latency);
+
+    segmented_array_destroy(&a);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t max_bytes = bench_env_size("BENCH_MAX_BYTES", (size_t)256 << 20);
+
+    // realloc may need the old and the new buffer at the same time
+    size_t size = max_bytes / BENCH_ELEMENT_SIZE / 2;
+    if(size == 0) size = 1;
+
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "growth_latency"))
+    {
+        return EXIT_FAILURE;
+    }
+
+    bench_run(&json, "malloc", allocator_default(), NULL, size);
+
+    MmapAllocator *m = NULL;
+    if(mmap_allocator_create(&m, BENCH_MMAP_THRESHOLD, 0))
+    {
+        bench_fail("mmap_allocator_create");
+    }
+    bench_run(&json, "mmap", mmap_allocator(m), NULL, size);
+    mmap_allocator_destroy(&m);
+
+    if(mmap_allocator_create(&m, BENCH_MMAP_THRESHOLD,
+           MMAP_ALLOCATOR_HUGE_PAGES))
+    {
+        bench_fail("mmap_allocator_create");
+    }
+    bench_run(&json, "mmap_hugepage", mmap_allocator(m), NULL, size);
+    mmap_allocator_destroy(&m);
+
+    const ArrayGrowthPolicy incremental = {
+        .factor_numerator = 2,
+        .factor_denominator = 1,
+        .incremental_step = BENCH_INCREMENTAL_STEP,
+    };
+    bench_run(&json, "incremental", allocator_default(), &incremental, size);
+
+    bench_run_segmented(&json, size);
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/mpmc_queue.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+Fan-in/fan-out throughput and stress check: N producers push
+BENCH_ITEMS values in total through one queue of BENCH_DEPTH slots to N
+consumers, for N = 1..32 (2..64 threads).
+
+    mutex_array  array_push_back / array_pop_front under one mutex, with
+                 not-full and not-empty condition variables
+    mpmc         mpmc_push / mpmc_pop (futex sleep when full or empty)
+    mpmc_try     mpmc_try_push / mpmc_try_pop, sched_yield on EAGAIN
+
+Consumers check that the values they receive sum to the values pushed.
+*/
+
+static const size_t BENCH_ITEMS = 1 << 21;
+static const size_t BENCH_DEPTH = 1024;
+static const size_t BENCH_SIDES[] = {1, 2, 4, 8, 16, 32};
+
+enum
+{
+    BENCH_MAX_SIDE = 32
+};
+
+typedef enum BenchBackend
+{
+    BENCH_MUTEX,
+    BENCH_MPMC,
+    BENCH_MPMC_TRY,
+} BenchBackend;
+
+typedef struct BenchShared
+{
+    BenchBackend backend;
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+    Array *array;
+    MpmcQueue *queue;
+    size_t per_thread;
+} BenchShared;
+
+typedef struct BenchTask
+{
+    BenchShared *shared;
+    uint64_t first;
+    uint64_t sum;
+} BenchTask;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_mpmc: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void
+bench_push(BenchShared *s, uint64_t value)
+{
+    switch(s->backend)
+    {
+    case BENCH_MUTEX:
+        pthread_mutex_lock(&s->lock);
+        while(array_size(s->array) >= BENCH_DEPTH)
+        {
+            pthread_cond_wait(&s->not_full, &s->lock);
+        }
+        if(array_push_back(s->array, &value)) bench_fail("array_push_back");
+        pthread_cond_signal(&s->not_empty);
+        pthread_mutex_unlock(&s->lock);
+        break;
+
+    case BENCH_MPMC:
+        if(mpmc_push(s->queue, &value)) bench_fail("mpmc_push");
+        break;
+
+    case BENCH_MPMC_TRY:
+        while(mpmc_try_push(s->queue, &value) == EAGAIN) sched_yield();
+        break;
+    }
+}
+
+static uint64_t
+bench_pop(BenchShared *s)
+{
+    uint64_t value = 0;
+
+    switch(s->backend)
+    {
+    case BENCH_MUTEX:
+        pthread_mutex_lock(&s->lock);
+        while(array_size(s->array) == 0)
+        {
+            pthread_cond_wait(&s->not_empty, &s->lock);
+        }
+        array_get(s->array, 0, &value);
+        array_pop_front(s->array);
+        pthread_cond_signal(&s->not_full);
+        pthread_mutex_unlock(&s->lock);
+        break;
+
+    case BENCH_MPMC:
+        if(mpmc_pop(s->queue, &value)) bench_fail("mpmc_pop");
+        break;
+
+    case BENCH_MPMC_TRY:
+        while(mpmc_try_pop(s->queue, &value) == EAGAIN) sched_yield();
+        break;
+    }
+
+    return value;
+}
+
+static void *
+bench_produce(void *argument)
+{
+    BenchTask *task = argument;
+
+    for(uint64_t i = 0; i < task->shared->per_thread; ++i)
+    {
+        uint64_t value = task->first + i;
+        bench_push(task->shared, value);
+        task->sum += value;
+    }
+
+    return NULL;
+}
+
+static void *
+bench_consume(void *argument)
+{
+    BenchTask *task = argument;
+
+    for(uint64_t i = 0; i < task->shared->per_thread; ++i)
+    {
+        task->sum += bench_pop(task->shared);
+    }
+
+    return NULL;
+}
+
+static void
+bench_run(BenchJson *json, const char *name, BenchBackend backend,
+    size_t side)
+{
+    BenchShared shared = {
+        .backend = backend,
+        .per_thread = BENCH_ITEMS / side,
+    };
+    pthread_mutex_init(&shared.lock, NULL);
+    pthread_cond_init(&shared.not_full, NULL);
+    pthread_cond_init(&shared.not_empty, NULL);
+
+    if(array_create(&shared.array, sizeof(uint64_t)) ||
+        mpmc_create(&shared.queue, sizeof(uint64_t), BENCH_DEPTH))
+    {
+        bench_fail("create");
+    }
+
+    pthread_t producers[BENCH_MAX_SIDE];
+    pthread_t consumers[BENCH_MAX_SIDE];
+    BenchTask pushed[BENCH_MAX_SIDE];
+    BenchTask popped[BENCH_MAX_SIDE];
+
+    uint64_t start = bench_now_ns();
+
+    for(size_t i = 0; i < side; ++i)
+    {
+        pushed[i] = (BenchTask){&shared, i * shared.per_thread, 0};
+        popped[i] = (BenchTask){&shared, 0, 0};
+        pthread_create(&consumers[i], NULL, bench_consume, &popped[i]);
+        pthread_create(&producers[i], NULL, bench_produce, &pushed[i]);
+    }
+
+    uint64_t in = 0;
+    uint64_t out = 0;
+    for(size_t i = 0; i < side; ++i)
+    {
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], NULL);
+        in += pushed[i].sum;
+        out += popped[i].sum;
+    }
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if(in != out) bench_fail("checksum");
+
+    uint64_t ops = shared.per_thread * side;
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "fan_in_out");
+    bench_json_string(json, "backend", name);
+    bench_json_u64(json, "producers", side);
+    bench_json_u64(json, "consumers", side);
+    bench_json_u64(json, "ops", ops);
+    bench_json_double(json, "ns_per_op", (double)elapsed / (double)ops);
+    bench_json_double(json, "mops_per_s",
+        (double)ops * 1e3 / (double)elapsed);
+    bench_json_end(json);
+
+    mpmc_destroy(&shared.queue);
+    array_destroy(&shared.array);
+    pthread_cond_destroy(&shared.not_empty);
+    pthread_cond_destroy(&shared.not_full);
+    pthread_mutex_destroy(&shared.lock);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "mpmc")) return EXIT_FAILURE;
+
+    for(size_t i = 0; i < sizeof(BENCH_SIDES) / sizeof(BENCH_SIDES[0]); ++i)
+    {
+        bench_run(&json, "mutex_array", BENCH_MUTEX, BENCH_SIDES[i]);
+        bench_run(&json, "mpmc", BENCH_MPMC, BENCH_SIDES[i]);
+        bench_run(&json, "mpmc_try", BENCH_MPMC_TRY, BENCH_SIDES[i]);
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
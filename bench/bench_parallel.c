@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/array_parallel.h"
+#include "../include/thread_pool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+Scans over n uint64_t, n = 10^4 .. 10^8 (capped by BENCH_MAX_BYTES,
+default 256 MiB), on the calling thread and on thread_pool_default():
+
+    serial_sum      plain loop
+    reduce_sum      array_parallel_reduce
+    serial_scale    plain loop, v[i] = v[i] * 3 + 1
+    for_scale       array_parallel_for with the default grain
+
+Reports ns per element and the number of pool workers.
+*/
+
+static const size_t BENCH_MAX_EXPONENT = 8;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_parallel: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void
+bench_add(void *accumulator, const void *value, void *context)
+{
+    (void)context;
+    *(uint64_t *)accumulator += *(const uint64_t *)value;
+}
+
+static void
+bench_scale(void *elements, size_t count, size_t first, void *context)
+{
+    uint64_t *v = elements;
+    (void)first;
+    (void)context;
+
+    for(size_t i = 0; i < count; ++i) v[i] = v[i] * 3 + 1;
+}
+
+static void
+bench_report(BenchJson *json, const char *name, size_t count,
+    uint64_t elapsed, uint64_t check)
+{
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", name);
+    bench_json_u64(json, "size", count);
+    bench_json_u64(json, "workers", thread_pool_size(thread_pool_default()));
+    bench_json_double(json, "ns_per_element",
+        (double)elapsed / (double)count);
+    bench_json_u64(json, "check", check);
+    bench_json_end(json);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t max_bytes = bench_env_size("BENCH_MAX_BYTES", (size_t)256 << 20);
+
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "parallel")) return EXIT_FAILURE;
+
+    if(!thread_pool_default()) bench_fail("thread_pool_default");
+
+    size_t count = 10000;
+    for(size_t exponent = 4; exponent <= BENCH_MAX_EXPONENT; ++exponent)
+    {
+        if(count > max_bytes / sizeof(uint64_t)) break;
+
+        Array *a = NULL;
+        uint64_t *v = NULL;
+        if(array_create(&a, sizeof(uint64_t))) bench_fail("array_create");
+        if(array_push_back_uninit(a, count, (void **)&v))
+        {
+            bench_fail("array_push_back_uninit");
+        }
+        for(size_t i = 0; i < count; ++i) v[i] = i;
+
+        uint64_t sum = 0;
+        uint64_t start = bench_now_ns();
+        for(size_t i = 0; i < count; ++i) sum += v[i];
+        bench_report(&json, "serial_sum", count, bench_now_ns() - start, sum);
+
+        uint64_t zero = 0;
+        start = bench_now_ns();
+        if(array_parallel_reduce(a, &zero, &sum, bench_add, NULL))
+        {
+            bench_fail("array_parallel_reduce");
+        }
+        bench_report(&json, "reduce_sum", count, bench_now_ns() - start, sum);
+
+        start = bench_now_ns();
+        bench_scale(v, count, 0, NULL);
+        bench_report(&json, "serial_scale", count, bench_now_ns() - start,
+            v[count - 1]);
+
+        start = bench_now_ns();
+        if(array_parallel_for(a, 0, bench_scale, NULL))
+        {
+            bench_fail("array_parallel_for");
+        }
+        bench_report(&json, "for_scale", count, bench_now_ns() - start,
+            v[count - 1]);
+
+        array_destroy(&a);
+
+        count *= 10;
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/array_sort.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Sorting n random keys, n = 10^3 .. 10^7 (capped by BENCH_MAX_BYTES,
+default 256 MiB), with:
+
+    qsort           libc qsort on the array buffer
+    array_sort      comparison introsort
+    array_sort_u64  LSD radix sort
+    parallel        array_sort_parallel on every online CPU
+    parallel_stable array_sort_parallel with ARRAY_SORT_STABLE
+    by_key          array_sort_by_key on 16-byte records keyed by a u64
+
+Every run sorts a fresh copy of the same input and reports ns per
+element.
+*/
+
+static const size_t BENCH_MAX_EXPONENT = 7;
+
+typedef struct BenchRecord
+{
+    uint64_t key;
+    uint64_t payload;
+} BenchRecord;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_sort: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static int
+bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t
+bench_record_key(const void *element, void *context)
+{
+    (void)context;
+    return ((const BenchRecord *)element)->key;
+}
+
+static Array *
+bench_copy(const void *input, size_t element_size, size_t count)
+{
+    Array *a = NULL;
+    if(array_create(&a, element_size)) bench_fail("array_create");
+    if(array_push_back_n(a, input, count)) bench_fail("array_push_back_n");
+
+    return a;
+}
+
+static void
+bench_report(BenchJson *json, const char *name, size_t count,
+    uint64_t elapsed)
+{
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", name);
+    bench_json_u64(json, "size", count);
+    bench_json_double(json, "ns_per_element",
+        (double)elapsed / (double)count);
+    bench_json_end(json);
+}
+
+static void
+bench_sizes(BenchJson *json, size_t count)
+{
+    uint64_t state = 0x9E3779B97F4A7C15u;
+
+    uint64_t *keys = malloc(count * sizeof(*keys));
+    BenchRecord *records = malloc(count * sizeof(*records));
+    if(!keys || !records) bench_fail("malloc");
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        keys[i] = bench_next_random(&state);
+        records[i].key = keys[i];
+        records[i].payload = i;
+    }
+
+    Array *a = bench_copy(keys, sizeof(*keys), count);
+    uint64_t start = bench_now_ns();
+    qsort(array_data(a), count, sizeof(*keys), bench_cmp_u64);
+    bench_report(json, "qsort", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    a = bench_copy(keys, sizeof(*keys), count);
+    start = bench_now_ns();
+    if(array_sort(a, bench_cmp_u64)) bench_fail("array_sort");
+    bench_report(json, "array_sort", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    a = bench_copy(keys, sizeof(*keys), count);
+    start = bench_now_ns();
+    if(array_sort_parallel(a, bench_cmp_u64, 0, 0))
+    {
+        bench_fail("array_sort_parallel");
+    }
+    bench_report(json, "parallel", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    a = bench_copy(keys, sizeof(*keys), count);
+    start = bench_now_ns();
+    if(array_sort_parallel(a, bench_cmp_u64, 0, ARRAY_SORT_STABLE))
+    {
+        bench_fail("array_sort_parallel");
+    }
+    bench_report(json, "parallel_stable", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    a = bench_copy(keys, sizeof(*keys), count);
+    start = bench_now_ns();
+    if(array_sort_u64(a)) bench_fail("array_sort_u64");
+    bench_report(json, "array_sort_u64", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    a = bench_copy(records, sizeof(*records), count);
+    start = bench_now_ns();
+    if(array_sort_by_key(a, bench_record_key, NULL))
+    {
+        bench_fail("array_sort_by_key");
+    }
+    bench_report(json, "by_key", count, bench_now_ns() - start);
+    array_destroy(&a);
+
+    free(records);
+    free(keys);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t max_bytes = bench_env_size("BENCH_MAX_BYTES", (size_t)256 << 20);
+
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "sort")) return EXIT_FAILURE;
+
+    size_t count = 1000;
+    for(size_t exponent = 3; exponent <= BENCH_MAX_EXPONENT; ++exponent)
+    {
+        // records, their copy and the by_key scratch pairs
+        if(count > max_bytes / (4 * sizeof(BenchRecord) + sizeof(uint64_t)))
+        {
+            break;
+        }
+
+        bench_sizes(&json, count);
+
+        count *= 10;
+    }
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+
+#include "../include/array.h"
+#include "../include/spsc_ring.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+Stage-to-stage throughput: one producer thread hands BENCH_RECORDS
+16-byte records to one consumer thread through a queue of BENCH_DEPTH
+slots.
+
+    mutex_array  array_push_back / array_get + array_pop_front under one
+                 pthread mutex
+    spsc         spsc_push / spsc_pop
+    spsc_batch   spsc_push_n / spsc_pop_n, BENCH_BATCH records per call
+
+Either side yields when the queue is full (or empty).
+*/
+
+static const size_t BENCH_RECORDS = 2000000;
+static const size_t BENCH_DEPTH = 1024;
+
+enum
+{
+    BENCH_BATCH = 64
+};
+
+typedef struct BenchRecord
+{
+    uint64_t sequence;
+    uint64_t payload;
+} BenchRecord;
+
+typedef struct BenchQueue
+{
+    pthread_mutex_t lock;
+    Array *array;
+    SpscRing *ring;
+    size_t batch;
+    uint64_t checksum;
+} BenchQueue;
+
+static void
+bench_fail(const char *what)
+{
+    fprintf(stderr, "bench_spsc: %s failed\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void *
+bench_mutex_produce(void *argument)
+{
+    BenchQueue *q = argument;
+
+    for(uint64_t i = 0; i < BENCH_RECORDS;)
+    {
+        BenchRecord record = {i, i * 3};
+
+        pthread_mutex_lock(&q->lock);
+        bool full = array_size(q->array) >= BENCH_DEPTH;
+        if(!full && array_push_back(q->array, &record)) bench_fail("push");
+        pthread_mutex_unlock(&q->lock);
+
+        if(full) sched_yield();
+        else ++i;
+    }
+
+    return NULL;
+}
+
+static void
+bench_mutex_consume(BenchQueue *q)
+{
+    for(uint64_t i = 0; i < BENCH_RECORDS;)
+    {
+        BenchRecord record;
+
+        pthread_mutex_lock(&q->lock);
+        bool empty = array_size(q->array) == 0;
+        if(!empty)
+        {
+            array_get(q->array, 0, &record);
+            array_pop_front(q->array);
+        }
+        pthread_mutex_unlock(&q->lock);
+
+        if(empty)
+        {
+            sched_yield();
+            continue;
+        }
+
+        if(record.sequence != i) bench_fail("order");
+        q->checksum += record.payload;
+        ++i;
+    }
+}
+
+static void *
+bench_spsc_produce(void *argument)
+{
+    BenchQueue *q = argument;
+    BenchRecord batch[BENCH_BATCH];
+
+    for(uint64_t i = 0; i < BENCH_RECORDS;)
+    {
+        size_t count = BENCH_RECORDS - i;
+        if(count > q->batch) count = q->batch;
+
+        for(size_t j = 0; j < count; ++j)
+        {
+            batch[j] = (BenchRecord){i + j, (i + j) * 3};
+        }
+
+        size_t pushed = 0;
+        int error = q->batch == 1
+            ? spsc_push(q->ring, batch)
+            : spsc_push_n(q->ring, batch, count, &pushed);
+        if(q->batch == 1 && !error) pushed = 1;
+
+        if(error == EAGAIN) sched_yield();
+        else if(error) bench_fail("spsc_push");
+
+        i += pushed;
+    }
+
+    return NULL;
+}
+
+static void
+bench_spsc_consume(BenchQueue *q)
+{
+    BenchRecord batch[BENCH_BATCH];
+
+    for(uint64_t i = 0; i < BENCH_RECORDS;)
+    {
+        size_t popped = 0;
+        int error = q->batch == 1
+            ? spsc_pop(q->ring, batch)
+            : spsc_pop_n(q->ring, batch, q->batch, &popped);
+        if(q->batch == 1 && !error) popped = 1;
+
+        if(error == EAGAIN)
+        {
+            sched_yield();
+            continue;
+        }
+        if(error) bench_fail("spsc_pop");
+
+        for(size_t j = 0; j < popped; ++j, ++i)
+        {
+            if(batch[j].sequence != i) bench_fail("order");
+            q->checksum += batch[j].payload;
+        }
+    }
+}
+
+static void
+bench_run(BenchJson *json, const char *backend, size_t batch)
+{
+    BenchQueue q = {.batch = batch};
+    pthread_mutex_init(&q.lock, NULL);
+
+    if(array_create(&q.array, sizeof(BenchRecord)) ||
+        spsc_create(&q.ring, sizeof(BenchRecord), BENCH_DEPTH))
+    {
+        bench_fail("create");
+    }
+
+    bool mutex = batch == 0;
+
+    uint64_t start = bench_now_ns();
+
+    pthread_t producer;
+    pthread_create(&producer, NULL,
+        mutex ? bench_mutex_produce : bench_spsc_produce, &q);
+
+    if(mutex) bench_mutex_consume(&q);
+    else bench_spsc_consume(&q);
+
+    pthread_join(producer, NULL);
+
+    uint64_t elapsed = bench_now_ns() - start;
+
+    // sum of 3 * i over every sequence number
+    if(q.checksum != 3 * (BENCH_RECORDS * (BENCH_RECORDS - 1) / 2))
+    {
+        bench_fail("checksum");
+    }
+
+    bench_json_begin(json);
+    bench_json_string(json, "benchmark", "stage_handoff");
+    bench_json_string(json, "backend", backend);
+    bench_json_u64(json, "batch", mutex ? 1 : batch);
+    bench_json_u64(json, "records", BENCH_RECORDS);
+    bench_json_double(json, "ns_per_op",
+        (double)elapsed / (double)BENCH_RECORDS);
+    bench_json_double(json, "mops_per_s",
+        (double)BENCH_RECORDS * 1e3 / (double)elapsed);
+    bench_json_end(json);
+
+    spsc_destroy(&q.ring);
+    array_destroy(&q.array);
+    pthread_mutex_destroy(&q.lock);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchJson json;
+    if(bench_json_open(&json, argc, argv, "spsc")) return EXIT_FAILURE;
+
+    bench_run(&json, "mutex_array", 0);
+    bench_run(&json, "spsc", 1);
+    bench_run(&json, "spsc_batch", BENCH_BATCH);
+
+    bench_json_close(&json);
+
+    return 0;
+}
@@ -1,10 +1,52 @@
-#ifndef ALLOCATOR_H
-#define ALLOCATOR_H
-
-#include <stddef.h>
-
-void *memory_allocator(size_t size);
-void *memory_reallocator(void *pointer, size_t size);
-void memory_free(void *pointer);
-
-#endif // ALLOCATOR_H
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+enum
+{
+    ALLOCATOR_TRACE_REPORT_AT_EXIT = 1u << 0,
+};
+
+typedef struct Allocator
+{
+    void *(*allocate)(void *context, size_t size);
+    void *(*reallocate)(void *context, void *pointer, size_t old_size,
+        size_t new_size);
+    void (*deallocate)(void *context, void *pointer, size_t size);
+    void *context;
+} Allocator;
+
+void *memory_allocator(size_t size);
+void *memory_reallocator(void *pointer, size_t size);
+void memory_free(void *pointer);
+
+/*
+Counters of allocator_trace_start() .. allocator_trace_stop(); see
+allocator_trace_report().
+*/
+typedef struct AllocatorTraceStats
+{
+    uint64_t allocations;
+    uint64_t reallocations;
+    uint64_t frees;
+    uint64_t untracked;
+    uint64_t live_blocks;
+    uint64_t live_bytes;
+    uint64_t peak_blocks;
+    uint64_t peak_bytes;
+} AllocatorTraceStats;
+
+int allocator_trace_start(unsigned flags);
+void allocator_trace_stop(void);
+int allocator_trace_stats(AllocatorTraceStats *out);
+void allocator_trace_report(FILE *out);
+
+const Allocator *allocator_default(void);
+
+const Allocator *allocator_pool(void);
+void allocator_pool_thread_flush(void);
+
+#endif // ALLOCATOR_H
@@ -0,0 +1,20 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct Arena Arena;
+
+int arena_create(Arena **out, size_t block_size);
+void arena_destroy(Arena **arena);
+
+void arena_reset(Arena *arena);
+
+const Allocator *arena_allocator(Arena *arena);
+
+size_t arena_bytes_used(const Arena *arena);
+size_t arena_bytes_reserved(const Arena *arena);
+
+#endif // !ARENA_H
@@ -1,34 +1,169 @@
 #ifndef ARRAY_H
 #define ARRAY_H
 
+#include "allocator.h"
+
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+
+/*
+Bytes reserved for the Array header in caller-provided storage; see
+array_init_inplace(). Every byte past the header holds inline elements.
+Builds with -DARRAY_STATS carry the instrumentation counters in the header.
+*/
+#ifdef ARRAY_STATS
+#define ARRAY_HEADER_SIZE ((size_t)192)
+#else
+#define ARRAY_HEADER_SIZE ((size_t)128)
+#endif
+#define ARRAY_INPLACE_BYTES(element_size, count)                               \
+    (ARRAY_HEADER_SIZE + (size_t)(element_size) * (size_t)(count))
 
 typedef struct Array Array;
 
+enum
+{
+    ARRAY_MAPPED_READ_ONLY = 1u << 0,
+    ARRAY_MAPPED_CREATE = 1u << 1,
+    ARRAY_MAPPED_TRUNCATE = 1u << 2,
+};
+
+typedef size_t (*ArrayGrowthCallback)(size_t capacity, size_t min_capacity,
+    void *context);
+
+typedef bool (*ArrayPredicate)(const void *element, void *context);
+
+typedef struct ArrayGrowthPolicy
+{
+    size_t factor_numerator;
+    size_t factor_denominator;
+    size_t linear_threshold;
+    size_t linear_step;
+    ArrayGrowthCallback callback;
+    void *context;
+    size_t shrink_divisor;
+    size_t incremental_step;
+} ArrayGrowthPolicy;
+
+/*
+Instrumentation counters; see array_stats_get(). Only maintained in builds
+with -DARRAY_STATS.
+*/
+typedef struct ArrayStats
+{
+    uint64_t reallocations;
+    uint64_t bytes_moved;
+    uint64_t bytes_allocated;
+    uint64_t bytes_freed;
+    uint64_t peak_capacity;
+    uint64_t peak_size;
+} ArrayStats;
+
+typedef enum ArrayEditOp
+{
+    ARRAY_EDIT_INSERT,
+    ARRAY_EDIT_ERASE,
+} ArrayEditOp;
+
+typedef struct ArrayEdit
+{
+    size_t index;
+    ArrayEditOp op;
+    const void *value;
+} ArrayEdit;
+
+typedef struct ArraySpan
+{
+    void *ptr;
+    size_t len;
+    size_t elem_size;
+} ArraySpan;
+
+typedef struct ArrayIterator
+{
+    char *current;
+    char *end;
+    size_t step;
+} ArrayIterator;
+
 int add_safe(size_t a, size_t b, size_t *out);
 int sub_safe(size_t a, size_t b, size_t *out);
 int mul_safe(size_t a, size_t b, size_t *out);
 
+int array_storage_grow(void **data, size_t *capacity, size_t element_size,
+    size_t min_capacity, const Allocator *allocator);
+
 int array_create(Array **out, size_t element_size);
+int array_create_with_allocator(Array **out, size_t element_size,
+    const Allocator *allocator);
+int array_create_inline(Array **out, size_t element_size,
+    size_t inline_capacity, const Allocator *allocator);
+int array_init_inplace(Array **out, void *storage, size_t storage_size,
+    size_t element_size);
 void array_destroy(Array **object);
 
+int array_open_mapped(Array **out, const char *path, size_t element_size,
+    unsigned flags);
+int array_sync(Array *array);
+
 Array *array_init(size_t element_size);
 void array_delete(Array **a);
 
+int array_set_growth_policy(Array *array, const ArrayGrowthPolicy *policy);
+
+int array_reserve(Array *array, size_t min_capacity);
+int array_reserve_exact(Array *array, size_t capacity);
+int array_shrink_fit(Array *array);
+
 int array_insert(Array *array, const void *value, size_t index);
 int array_erase(Array *array, size_t index);
 
 int array_push_front(Array *array, const void *value);
 int array_push_back(Array *array, const void *value);
 
+int array_push_back_n(Array *array, const void *values, size_t count);
+int array_push_back_uninit(Array *array, size_t count, void **out);
+int array_insert_range(Array *array, const void *values, size_t count,
+    size_t index);
+int array_erase_range(Array *array, size_t index, size_t count);
+int array_assign(Array *array, const void *values, size_t count);
+int array_append_array(Array *dst, const Array *src);
+
+int array_apply_batch(Array *array, const ArrayEdit *edits, size_t count);
+
+int array_remove_if(Array *array, ArrayPredicate pred, void *context);
+int array_retain(Array *array, ArrayPredicate pred, void *context);
+int array_swap_remove(Array *array, size_t index);
+
 void array_pop_front(Array *array);
 void array_pop_back(Array *array);
 
 int array_get(const Array *a, size_t index, void *out_value);
 int array_set(Array *a, size_t index, const void *value);
 
+void *array_at(Array *array, size_t index);
+const void *array_at_const(const Array *array, size_t index);
+
+void *array_data(Array *array);
+const void *array_data_const(const Array *array);
+
+ArraySpan array_span(Array *array);
+int array_span_subspan(ArraySpan span, size_t offset, size_t count,
+    ArraySpan *out);
+void *array_span_at(ArraySpan span, size_t index);
+
+void array_iter_init(ArrayIterator *it, Array *array);
+void *array_iter_next(ArrayIterator *it);
+
 size_t array_capacity(const Array *array);
 size_t array_size(const Array *array);
+size_t array_element_size(const Array *array);
+const Allocator *array_allocator(const Array *array);
+
+int array_stats_get(const Array *array, ArrayStats *out);
+void array_stats_reset(Array *array);
+void array_stats_dump(const Array *array, FILE *out);
 
 #endif // !ARRAY_H
@@ -0,0 +1,30 @@
+#ifndef ARRAY_IO_H
+#define ARRAY_IO_H
+
+#include "array.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum
+{
+    ARRAY_IO_CHECKSUM = 1u << 0,
+};
+
+typedef struct ArrayWriter ArrayWriter;
+typedef struct ArrayReader ArrayReader;
+
+int array_write_fd(const Array *array, int fd, unsigned flags);
+int array_read_fd(Array *array, int fd);
+
+int array_writer_open(ArrayWriter **out, int fd, size_t element_size,
+    uint64_t count, unsigned flags);
+int array_writer_write(ArrayWriter *writer, const void *values, size_t count);
+int array_writer_close(ArrayWriter **writer);
+
+int array_reader_open(ArrayReader **out, int fd, size_t element_size);
+uint64_t array_reader_remaining(const ArrayReader *reader);
+int array_reader_read(ArrayReader *reader, void *values, size_t count);
+void array_reader_close(ArrayReader **reader);
+
+#endif // !ARRAY_IO_H
@@ -0,0 +1,37 @@
+#ifndef ARRAY_PARALLEL_H
+#define ARRAY_PARALLEL_H
+
+#include "array.h"
+#include "thread_pool.h"
+
+#include <stddef.h>
+
+/*
+Loop body over the contiguous elements [first, first + count) of an
+array; elements points at element first.
+*/
+typedef void (*ArrayParallelFn)(void *elements, size_t count, size_t first,
+    void *context);
+
+/*
+Write count transformed elements of the destination from count source
+elements.
+*/
+typedef void (*ArrayMapFn)(const void *src, void *dst, size_t count,
+    void *context);
+
+/*
+Fold value into accumulator; both have the array's element type. Must be
+associative, need not be commutative.
+*/
+typedef void (*ArrayCombineFn)(void *accumulator, const void *value,
+    void *context);
+
+int array_parallel_for(Array *array, size_t grain, ArrayParallelFn fn,
+    void *context);
+int array_parallel_map(const Array *src, Array *dst, ArrayMapFn fn,
+    void *context);
+int array_parallel_reduce(const Array *array, const void *init, void *out,
+    ArrayCombineFn combine, void *context);
+
+#endif // !ARRAY_PARALLEL_H
@@ -0,0 +1,36 @@
+#ifndef ARRAY_SORT_H
+#define ARRAY_SORT_H
+
+#include "array.h"
+
+#include <stdint.h>
+
+enum
+{
+    ARRAY_SORT_STABLE = 1u << 0,
+};
+
+/*
+qsort-compatible comparator: negative, zero or positive when *a orders
+before, equal to or after *b.
+*/
+typedef int (*ArrayComparator)(const void *a, const void *b);
+
+/*
+Unsigned radix key of an element; elements are ordered by ascending key.
+Map a signed field v to (uint64_t)v ^ ((uint64_t)1 << 63).
+*/
+typedef uint64_t (*ArraySortKey)(const void *element, void *context);
+
+int array_sort(Array *array, ArrayComparator cmp);
+int array_sort_parallel(Array *array, ArrayComparator cmp, size_t threads,
+    unsigned flags);
+
+int array_sort_u32(Array *array);
+int array_sort_u64(Array *array);
+int array_sort_i64(Array *array);
+int array_sort_f64(Array *array);
+
+int array_sort_by_key(Array *array, ArraySortKey key, void *context);
+
+#endif // !ARRAY_SORT_H
@@ -0,0 +1,148 @@
+#ifndef ARRAY_TYPED_H
+#define ARRAY_TYPED_H
+
+#include "allocator.h"
+#include "array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Type-specialized dynamic arrays.
+
+ARRAY_DEFINE(name, T) generates a transparent struct `name` and static
+inline operations `name_*` whose element size is sizeof(T), so element
+access compiles to plain indexed loads and stores. Growth goes through
+array_storage_grow(), which applies Array's default policy (start at 8,
+then double). Growth policies, stats and incremental growth are Array
+only.
+
+    ARRAY_DEFINE(I64Array, int64_t)
+
+    I64Array a;
+    I64Array_init(&a);
+    I64Array_push_back(&a, 42);
+    int64_t x = I64Array_get(&a, 0);
+    I64Array_destroy(&a);
+
+Unchecked accessors (name_get, name_set) assert the index in debug builds
+only; name_at is the checked variant and returns NULL when out of range.
+*/
+
+#define ARRAY_DECLARE(name, T)                                                 \
+    typedef struct name                                                        \
+    {                                                                          \
+        T *data;                                                               \
+        size_t size;                                                           \
+        size_t capacity;                                                       \
+        const Allocator *allocator;                                            \
+    } name;
+
+#define ARRAY_DEFINE(name, T)                                                  \
+    ARRAY_DECLARE(name, T)                                                     \
+                                                                               \
+    static inline void name##_init_with_allocator(name *a,                     \
+        const Allocator *allocator)                                            \
+    {                                                                          \
+        a->data = NULL;                                                        \
+        a->size = 0;                                                           \
+        a->capacity = 0;                                                       \
+        a->allocator = allocator;                                              \
+    }                                                                          \
+                                                                               \
+    static inline void name##_init(name *a)                                    \
+    {                                                                          \
+        name##_init_with_allocator(a, allocator_default());                    \
+    }                                                                          \
+                                                                               \
+    static inline void name##_destroy(name *a)                                 \
+    {                                                                          \
+        if(!a) return;                                                         \
+        if(a->data)                                                            \
+        {                                                                      \
+            a->allocator->deallocate(a->allocator->context, a->data,           \
+                a->capacity * sizeof(T));                                      \
+        }                                                                      \
+        a->data = NULL;                                                        \
+        a->size = 0;                                                           \
+        a->capacity = 0;                                                       \
+    }                                                                          \
+                                                                               \
+    static inline int name##_reserve(name *a, size_t min_capacity)             \
+    {                                                                          \
+        if(min_capacity <= a->capacity) return 0;                              \
+        void *data = a->data;                                                  \
+        int error = array_storage_grow(&data, &a->capacity, sizeof(T),         \
+            min_capacity, a->allocator);                                       \
+        a->data = data;                                                        \
+        return error;                                                          \
+    }                                                                          \
+                                                                               \
+    static inline int name##_push_back(name *a, T value)                       \
+    {                                                                          \
+        if(a->size == a->capacity)                                             \
+        {                                                                      \
+            if(a->size == SIZE_MAX) return EOVERFLOW;                          \
+            int error = name##_reserve(a, a->size + 1);                        \
+            if(error) return error;                                            \
+        }                                                                      \
+        a->data[a->size++] = value;                                            \
+        return 0;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline int name##_push_back_n(name *a, const T *values,             \
+        size_t count)                                                          \
+    {                                                                          \
+        if(count > SIZE_MAX - a->size) return EOVERFLOW;                       \
+        int error = name##_reserve(a, a->size + count);                        \
+        if(error) return error;                                                \
+        for(size_t i = 0; i < count; ++i) a->data[a->size + i] = values[i];    \
+        a->size += count;                                                      \
+        return 0;                                                              \
+    }                                                                          \
+                                                                               \
+    static inline void name##_pop_back(name *a)                                \
+    {                                                                          \
+        if(a->size) --a->size;                                                 \
+    }                                                                          \
+                                                                               \
+    static inline T name##_get(const name *a, size_t index)                    \
+    {                                                                          \
+        assert(index < a->size);                                               \
+        return a->data[index];                                                 \
+    }                                                                          \
+                                                                               \
+    static inline void name##_set(name *a, size_t index, T value)              \
+    {                                                                          \
+        assert(index < a->size);                                               \
+        a->data[index] = value;                                                \
+    }                                                                          \
+                                                                               \
+    static inline T *name##_at(name *a, size_t index)                          \
+    {                                                                          \
+        return index < a->size ? &a->data[index] : NULL;                       \
+    }                                                                          \
+                                                                               \
+    static inline T *name##_data(name *a)                                      \
+    {                                                                          \
+        return a->data;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline void name##_clear(name *a)                                   \
+    {                                                                          \
+        a->size = 0;                                                           \
+    }                                                                          \
+                                                                               \
+    static inline size_t name##_size(const name *a)                            \
+    {                                                                          \
+        return a->size;                                                        \
+    }                                                                          \
+                                                                               \
+    static inline size_t name##_capacity(const name *a)                        \
+    {                                                                          \
+        return a->capacity;                                                    \
+    }
+
+#endif // !ARRAY_TYPED_H
@@ -0,0 +1,25 @@
+#ifndef CONCURRENT_ARRAY_H
+#define CONCURRENT_ARRAY_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct ConcurrentArray ConcurrentArray;
+
+int concurrent_array_create(ConcurrentArray **out, size_t element_size);
+int concurrent_array_create_with_allocator(ConcurrentArray **out,
+    size_t element_size, const Allocator *allocator);
+void concurrent_array_destroy(ConcurrentArray **array);
+
+int concurrent_array_push_back(ConcurrentArray *array, const void *value,
+    size_t *out_index);
+
+int concurrent_array_get(const ConcurrentArray *array, size_t index,
+    void *out_value);
+const void *concurrent_array_at(const ConcurrentArray *array, size_t index);
+
+size_t concurrent_array_size(const ConcurrentArray *array);
+size_t concurrent_array_element_size(const ConcurrentArray *array);
+
+#endif // !CONCURRENT_ARRAY_H
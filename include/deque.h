@@ -0,0 +1,32 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct Deque Deque;
+
+int deque_create(Deque **out, size_t element_size);
+int deque_create_with_allocator(Deque **out, size_t element_size,
+    const Allocator *allocator);
+void deque_destroy(Deque **object);
+
+int deque_reserve(Deque *deque, size_t min_capacity);
+
+int deque_insert(Deque *deque, const void *value, size_t index);
+int deque_erase(Deque *deque, size_t index);
+
+int deque_push_front(Deque *deque, const void *value);
+int deque_push_back(Deque *deque, const void *value);
+
+void deque_pop_front(Deque *deque);
+void deque_pop_back(Deque *deque);
+
+int deque_get(const Deque *deque, size_t index, void *out_value);
+int deque_set(Deque *deque, size_t index, const void *value);
+
+size_t deque_capacity(const Deque *deque);
+size_t deque_size(const Deque *deque);
+
+#endif // !DEQUE_H
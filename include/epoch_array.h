@@ -0,0 +1,36 @@
+#ifndef EPOCH_ARRAY_H
+#define EPOCH_ARRAY_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct EpochArray EpochArray;
+typedef struct EpochArrayReader EpochArrayReader;
+
+int epoch_array_create(EpochArray **out, size_t element_size,
+    size_t max_readers);
+int epoch_array_create_with_allocator(EpochArray **out, size_t element_size,
+    size_t max_readers, const Allocator *allocator);
+void epoch_array_destroy(EpochArray **array);
+
+// writer side: one thread at a time
+int epoch_array_reserve(EpochArray *array, size_t min_capacity);
+int epoch_array_push_back(EpochArray *array, const void *value);
+int epoch_array_push_back_n(EpochArray *array, const void *values,
+    size_t count);
+size_t epoch_array_collect(EpochArray *array);
+
+// reader side: any number of threads, one handle each
+int epoch_array_reader_acquire(EpochArray *array, EpochArrayReader **out);
+void epoch_array_reader_release(EpochArrayReader **reader);
+
+const void *epoch_array_read_begin(EpochArrayReader *reader,
+    size_t *out_size);
+void epoch_array_read_end(EpochArrayReader *reader);
+int epoch_array_get(EpochArrayReader *reader, size_t index, void *out_value);
+
+size_t epoch_array_size(const EpochArray *array);
+size_t epoch_array_element_size(const EpochArray *array);
+
+#endif // !EPOCH_ARRAY_H
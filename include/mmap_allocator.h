@@ -0,0 +1,21 @@
+#ifndef MMAP_ALLOCATOR_H
+#define MMAP_ALLOCATOR_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+enum
+{
+    MMAP_ALLOCATOR_HUGE_PAGES = 1u << 0,
+};
+
+typedef struct MmapAllocator MmapAllocator;
+
+int mmap_allocator_create(MmapAllocator **out, size_t threshold,
+    unsigned flags);
+void mmap_allocator_destroy(MmapAllocator **allocator);
+
+const Allocator *mmap_allocator(MmapAllocator *allocator);
+
+#endif // !MMAP_ALLOCATOR_H
@@ -0,0 +1,27 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct MpmcQueue MpmcQueue;
+
+int mpmc_create(MpmcQueue **out, size_t element_size, size_t capacity);
+int mpmc_create_with_allocator(MpmcQueue **out, size_t element_size,
+    size_t capacity, const Allocator *allocator);
+void mpmc_destroy(MpmcQueue **queue);
+
+// non-blocking: EAGAIN when full (or empty)
+int mpmc_try_push(MpmcQueue *queue, const void *value);
+int mpmc_try_pop(MpmcQueue *queue, void *out_value);
+
+// blocking: sleep until there is room (or an element)
+int mpmc_push(MpmcQueue *queue, const void *value);
+int mpmc_pop(MpmcQueue *queue, void *out_value);
+
+size_t mpmc_size(const MpmcQueue *queue);
+size_t mpmc_capacity(const MpmcQueue *queue);
+size_t mpmc_element_size(const MpmcQueue *queue);
+
+#endif // !MPMC_QUEUE_H
@@ -0,0 +1,43 @@
+#ifndef SEGMENTED_ARRAY_H
+#define SEGMENTED_ARRAY_H
+
+#include "allocator.h"
+#include "array.h"
+
+#include <stddef.h>
+
+typedef struct SegmentedArray SegmentedArray;
+
+int segmented_array_create(SegmentedArray **out, size_t element_size);
+int segmented_array_create_with_allocator(SegmentedArray **out,
+    size_t element_size, const Allocator *allocator);
+void segmented_array_destroy(SegmentedArray **array);
+
+int segmented_array_reserve(SegmentedArray *array, size_t min_capacity);
+int segmented_array_shrink_fit(SegmentedArray *array);
+
+int segmented_array_push_back(SegmentedArray *array, const void *value);
+int segmented_array_push_back_n(SegmentedArray *array, const void *values,
+    size_t count);
+void segmented_array_pop_back(SegmentedArray *array);
+void segmented_array_clear(SegmentedArray *array);
+
+int segmented_array_get(const SegmentedArray *array, size_t index,
+    void *out_value);
+int segmented_array_set(SegmentedArray *array, size_t index,
+    const void *value);
+
+void *segmented_array_at(SegmentedArray *array, size_t index);
+const void *segmented_array_at_const(const SegmentedArray *array,
+    size_t index);
+
+void *segmented_array_chunk(SegmentedArray *array, size_t chunk,
+    size_t *out_count);
+
+int segmented_array_flatten(const SegmentedArray *array, Array *out);
+
+size_t segmented_array_capacity(const SegmentedArray *array);
+size_t segmented_array_size(const SegmentedArray *array);
+size_t segmented_array_element_size(const SegmentedArray *array);
+
+#endif // !SEGMENTED_ARRAY_H
@@ -0,0 +1,29 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "allocator.h"
+
+#include <stddef.h>
+
+typedef struct SpscRing SpscRing;
+
+int spsc_create(SpscRing **out, size_t element_size, size_t capacity);
+int spsc_create_with_allocator(SpscRing **out, size_t element_size,
+    size_t capacity, const Allocator *allocator);
+void spsc_destroy(SpscRing **ring);
+
+// producer side: one thread at a time
+int spsc_push(SpscRing *ring, const void *value);
+int spsc_push_n(SpscRing *ring, const void *values, size_t count,
+    size_t *out_pushed);
+
+// consumer side: one thread at a time
+int spsc_pop(SpscRing *ring, void *out_value);
+int spsc_pop_n(SpscRing *ring, void *out_values, size_t count,
+    size_t *out_popped);
+
+size_t spsc_size(const SpscRing *ring);
+size_t spsc_capacity(const SpscRing *ring);
+size_t spsc_element_size(const SpscRing *ring);
+
+#endif // !SPSC_RING_H
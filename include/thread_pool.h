@@ -0,0 +1,23 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+typedef struct ThreadPool ThreadPool;
+
+/*
+Body of a parallel loop: handles the iterations [begin, end).
+*/
+typedef void (*ThreadPoolRangeFn)(void *context, size_t begin, size_t end);
+
+int thread_pool_create(ThreadPool **out, size_t threads);
+void thread_pool_destroy(ThreadPool **pool);
+
+int thread_pool_for(ThreadPool *pool, size_t count, size_t grain,
+    ThreadPoolRangeFn fn, void *context);
+
+size_t thread_pool_size(const ThreadPool *pool);
+
+ThreadPool *thread_pool_default(void);
+
+#endif // !THREAD_POOL_H
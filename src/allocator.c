@@ -1,21 +1,906 @@
-#include "allocator.h"
-
-#include <stdlib.h>
-
-void *
-memory_allocator(size_t size)
-{
-    return malloc(size);
-}
-
-void *
-memory_reallocator(void *pointer, size_t size)
-{
-    return realloc(pointer, size);
-}
-
-void
-memory_free(void *pointer)
-{
-    free(pointer);
-}
+#include "allocator.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/*
+Allocation tracing.
+
+While tracing is on, memory_allocator/memory_reallocator/memory_free record
+every live block in a pointer-keyed hash table together with its size and
+the number of times it grew. Blocks allocated before allocator_trace_start()
+are not tracked. The table itself is allocated with malloc directly so that
+tracing never observes its own bookkeeping. When tracing is off the cost is
+one relaxed atomic load per call.
+*/
+#define TRACE_HISTOGRAM_BUCKETS 48
+#define TRACE_CHAIN_BUCKETS 16
+#define TRACE_REPORT_LEAKS 16
+
+typedef struct TraceEntry
+{
+    void *pointer;
+    size_t size;
+    size_t grows;
+} TraceEntry;
+
+typedef struct Trace
+{
+    pthread_mutex_t lock;
+    TraceEntry *slots;
+    size_t capacity;
+    AllocatorTraceStats stats;
+    uint64_t size_histogram[TRACE_HISTOGRAM_BUCKETS];
+    uint64_t chain_histogram[TRACE_CHAIN_BUCKETS];
+    bool exit_report;
+} Trace;
+
+static atomic_bool trace_enabled;
+static Trace trace = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+static size_t
+trace_hash(const void *pointer, size_t capacity)
+{
+    uint64_t h = (uint64_t)(uintptr_t)pointer * 0x9E3779B97F4A7C15u;
+    return (size_t)(h >> 32) & (capacity - 1);
+}
+
+/*
+@brief:
+Power-of-two size bucket: bucket b holds sizes in [2^(b-1), 2^b).
+*/
+static size_t
+trace_size_bucket(size_t size)
+{
+    size_t bucket = 0;
+    while(size && bucket + 1 < TRACE_HISTOGRAM_BUCKETS)
+    {
+        size >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+static TraceEntry *
+trace_find(void *pointer)
+{
+    size_t i = trace_hash(pointer, trace.capacity);
+
+    while(trace.slots[i].pointer)
+    {
+        if(trace.slots[i].pointer == pointer) return &trace.slots[i];
+        i = (i + 1) & (trace.capacity - 1);
+    }
+
+    return NULL;
+}
+
+static bool
+trace_grow_table(void)
+{
+    size_t capacity = trace.capacity * 2;
+
+    TraceEntry *slots = calloc(capacity, sizeof(*slots));
+    if(!slots) return false;
+
+    for(size_t i = 0; i < trace.capacity; ++i)
+    {
+        if(!trace.slots[i].pointer) continue;
+
+        size_t j = trace_hash(trace.slots[i].pointer, capacity);
+        while(slots[j].pointer) j = (j + 1) & (capacity - 1);
+
+        slots[j] = trace.slots[i];
+    }
+
+    free(trace.slots);
+    trace.slots = slots;
+    trace.capacity = capacity;
+
+    return true;
+}
+
+/*
+@brief:
+Record a live block.
+
+@pre:
+    - trace.lock is held and trace.slots != NULL
+*/
+static void
+trace_insert(void *pointer, size_t size, size_t grows)
+{
+    if(2 * (trace.stats.live_blocks + 1) > trace.capacity &&
+        !trace_grow_table())
+    {
+        ++trace.stats.untracked;
+        return;
+    }
+
+    size_t i = trace_hash(pointer, trace.capacity);
+    while(trace.slots[i].pointer) i = (i + 1) & (trace.capacity - 1);
+
+    trace.slots[i] = (TraceEntry){pointer, size, grows};
+
+    ++trace.stats.live_blocks;
+    trace.stats.live_bytes += size;
+
+    if(trace.stats.live_blocks > trace.stats.peak_blocks)
+    {
+        trace.stats.peak_blocks = trace.stats.live_blocks;
+    }
+    if(trace.stats.live_bytes > trace.stats.peak_bytes)
+    {
+        trace.stats.peak_bytes = trace.stats.live_bytes;
+    }
+}
+
+/*
+@brief:
+Forget a live block, keeping the probe sequences of the others intact.
+
+@pre:
+    - trace.lock is held and trace.slots != NULL
+    - entry was returned by trace_find()
+*/
+static void
+trace_remove(TraceEntry *entry)
+{
+    --trace.stats.live_blocks;
+    trace.stats.live_bytes -= entry->size;
+
+    size_t mask = trace.capacity - 1;
+    size_t hole = (size_t)(entry - trace.slots);
+    size_t i = hole;
+
+    // backward-shift deletion for linear probing
+    for(;;)
+    {
+        i = (i + 1) & mask;
+        if(!trace.slots[i].pointer) break;
+
+        size_t home = trace_hash(trace.slots[i].pointer, trace.capacity);
+        if(((i - home) & mask) >= ((i - hole) & mask))
+        {
+            trace.slots[hole] = trace.slots[i];
+            hole = i;
+        }
+    }
+
+    trace.slots[hole].pointer = NULL;
+}
+
+static void
+trace_allocate(void *pointer, size_t size)
+{
+    pthread_mutex_lock(&trace.lock);
+
+    if(trace.slots)
+    {
+        ++trace.stats.allocations;
+        ++trace.size_histogram[trace_size_bucket(size)];
+        trace_insert(pointer, size, 0);
+    }
+
+    pthread_mutex_unlock(&trace.lock);
+}
+
+/*
+@brief:
+Take the entry of a block that is about to be passed to realloc out of
+the table, so that no other thread can find it once realloc has freed
+the address and malloc handed it out again.
+
+@post:
+    - returns true and fills *out when pointer was tracked
+*/
+static bool
+trace_reallocate_begin(void *pointer, TraceEntry *out)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&trace.lock);
+
+    TraceEntry *entry = trace.slots ? trace_find(pointer) : NULL;
+    if(entry)
+    {
+        *out = *entry;
+        trace_remove(entry);
+        found = true;
+    }
+
+    pthread_mutex_unlock(&trace.lock);
+
+    return found;
+}
+
+/*
+@brief:
+Record the outcome of a realloc whose old entry (if any) was taken by
+trace_reallocate_begin(): the new block on success, the old entry back
+on failure.
+*/
+static void
+trace_reallocate_end(const TraceEntry *old, void *new_pointer,
+    size_t new_size)
+{
+    pthread_mutex_lock(&trace.lock);
+
+    if(trace.slots)
+    {
+        if(new_pointer)
+        {
+            size_t grows = old ? old->grows + (new_size > old->size) : 0;
+
+            ++trace.stats.reallocations;
+            ++trace.size_histogram[trace_size_bucket(new_size)];
+            trace_insert(new_pointer, new_size, grows);
+        }
+        else if(old)
+        {
+            trace_insert(old->pointer, old->size, old->grows);
+        }
+    }
+
+    pthread_mutex_unlock(&trace.lock);
+}
+
+static void
+trace_free(void *pointer)
+{
+    pthread_mutex_lock(&trace.lock);
+
+    if(trace.slots)
+    {
+        TraceEntry *entry = trace_find(pointer);
+        if(entry)
+        {
+            ++trace.stats.frees;
+
+            size_t chain = entry->grows < TRACE_CHAIN_BUCKETS - 1
+                ? entry->grows
+                : TRACE_CHAIN_BUCKETS - 1;
+            ++trace.chain_histogram[chain];
+
+            trace_remove(entry);
+        }
+    }
+
+    pthread_mutex_unlock(&trace.lock);
+}
+
+void *
+memory_allocator(size_t size)
+{
+    void *pointer = malloc(size);
+
+    if(pointer && atomic_load_explicit(&trace_enabled, memory_order_relaxed))
+    {
+        trace_allocate(pointer, size);
+    }
+
+    return pointer;
+}
+
+void *
+memory_reallocator(void *pointer, size_t size)
+{
+    if(!atomic_load_explicit(&trace_enabled, memory_order_relaxed))
+    {
+        return realloc(pointer, size);
+    }
+
+    TraceEntry old;
+    bool tracked = pointer && trace_reallocate_begin(pointer, &old);
+
+    void *tmp = realloc(pointer, size);
+
+    trace_reallocate_end(tracked ? &old : NULL, tmp, size);
+
+    return tmp;
+}
+
+void
+memory_free(void *pointer)
+{
+    if(pointer && atomic_load_explicit(&trace_enabled, memory_order_relaxed))
+    {
+        trace_free(pointer);
+    }
+
+    free(pointer);
+}
+
+static void
+trace_exit_report(void)
+{
+    allocator_trace_report(stderr);
+}
+
+/*
+@brief:
+Start recording every block that goes through memory_allocator,
+memory_reallocator and memory_free.
+
+@note:
+Thread-safe. ALLOCATOR_TRACE_REPORT_AT_EXIT prints allocator_trace_report()
+to stderr when the process exits.
+
+@post:
+    On success:
+        - return 0
+        - counters and histograms start from zero
+
+    On failure:
+        - return EINVAL (unknown flag), EBUSY (already tracing) or ENOMEM
+*/
+int
+allocator_trace_start(unsigned flags)
+{
+    if(flags & ~(unsigned)ALLOCATOR_TRACE_REPORT_AT_EXIT) return EINVAL;
+
+    pthread_mutex_lock(&trace.lock);
+
+    if(trace.slots)
+    {
+        pthread_mutex_unlock(&trace.lock);
+        return EBUSY;
+    }
+
+    trace.capacity = 1024;
+    trace.slots = calloc(trace.capacity, sizeof(*trace.slots));
+    if(!trace.slots)
+    {
+        pthread_mutex_unlock(&trace.lock);
+        return ENOMEM;
+    }
+
+    memset(&trace.stats, 0, sizeof(trace.stats));
+    memset(trace.size_histogram, 0, sizeof(trace.size_histogram));
+    memset(trace.chain_histogram, 0, sizeof(trace.chain_histogram));
+
+    if((flags & ALLOCATOR_TRACE_REPORT_AT_EXIT) && !trace.exit_report)
+    {
+        trace.exit_report = atexit(trace_exit_report) == 0;
+    }
+
+    atomic_store_explicit(&trace_enabled, true, memory_order_relaxed);
+
+    pthread_mutex_unlock(&trace.lock);
+
+    return 0;
+}
+
+/*
+@brief:
+Stop tracing and drop the table of live blocks.
+
+@note:
+Function is idempotent. Counters stay readable until the next start.
+*/
+void
+allocator_trace_stop(void)
+{
+    pthread_mutex_lock(&trace.lock);
+
+    atomic_store_explicit(&trace_enabled, false, memory_order_relaxed);
+
+    free(trace.slots);
+    trace.slots = NULL;
+    trace.capacity = 0;
+
+    pthread_mutex_unlock(&trace.lock);
+}
+
+/*
+@post:
+    On success:
+        - return 0
+        - *out holds the counters of the current (or last) trace
+
+    On failure:
+        - return EINVAL
+*/
+int
+allocator_trace_stats(AllocatorTraceStats *out)
+{
+    if(!out) return EINVAL;
+
+    pthread_mutex_lock(&trace.lock);
+    *out = trace.stats;
+    pthread_mutex_unlock(&trace.lock);
+
+    return 0;
+}
+
+/*
+@brief:
+Print counters, high-water marks, the size and realloc-chain histograms,
+internal fragmentation of the live blocks and the first live blocks
+(leaks, when called at exit).
+
+@note:
+Internal fragmentation compares requested sizes with
+malloc_usable_size() and is only reported on glibc.
+*/
+void
+allocator_trace_report(FILE *out)
+{
+    if(!out) return;
+
+    pthread_mutex_lock(&trace.lock);
+
+    const AllocatorTraceStats *st = &trace.stats;
+
+    fprintf(out,
+        "allocator trace:\n"
+        "  allocations %llu, reallocations %llu, frees %llu, untracked %llu\n"
+        "  live   %llu blocks, %llu bytes\n"
+        "  peak   %llu blocks, %llu bytes\n",
+        (unsigned long long)st->allocations,
+        (unsigned long long)st->reallocations, (unsigned long long)st->frees,
+        (unsigned long long)st->untracked,
+        (unsigned long long)st->live_blocks, (unsigned long long)st->live_bytes,
+        (unsigned long long)st->peak_blocks,
+        (unsigned long long)st->peak_bytes);
+
+    fprintf(out, "  size histogram (allocations, bytes in [low, 2 * low)):\n");
+    for(size_t b = 0; b < TRACE_HISTOGRAM_BUCKETS; ++b)
+    {
+        if(!trace.size_histogram[b]) continue;
+
+        size_t low = b ? (size_t)1 << (b - 1) : 0;
+        fprintf(out, "    %12zu  %llu\n", low,
+            (unsigned long long)trace.size_histogram[b]);
+    }
+
+    fprintf(out, "  realloc chains (freed blocks by times grown):\n");
+    for(size_t c = 0; c < TRACE_CHAIN_BUCKETS; ++c)
+    {
+        if(!trace.chain_histogram[c]) continue;
+
+        fprintf(out, "    %2zu%s  %llu\n", c,
+            c == TRACE_CHAIN_BUCKETS - 1 ? "+" : " ",
+            (unsigned long long)trace.chain_histogram[c]);
+    }
+
+#ifdef __GLIBC__
+    size_t usable = 0;
+    for(size_t i = 0; i < trace.capacity; ++i)
+    {
+        if(trace.slots[i].pointer)
+        {
+            usable += malloc_usable_size(trace.slots[i].pointer);
+        }
+    }
+
+    if(usable)
+    {
+        size_t slack = usable - (size_t)st->live_bytes;
+        fprintf(out,
+            "  fragmentation: %zu usable bytes, %zu slack (%.1f%%)\n",
+            usable, slack, 100.0 * (double)slack / (double)usable);
+    }
+#endif
+
+    size_t listed = 0;
+    for(size_t i = 0; i < trace.capacity && listed < TRACE_REPORT_LEAKS; ++i)
+    {
+        const TraceEntry *entry = &trace.slots[i];
+        if(!entry->pointer) continue;
+
+        if(listed++ == 0) fprintf(out, "  live blocks:\n");
+
+        fprintf(out, "    %p  %zu bytes, grew %zu times\n", entry->pointer,
+            entry->size, entry->grows);
+    }
+
+    if(st->live_blocks > listed)
+    {
+        fprintf(out, "    ... %llu more\n",
+            (unsigned long long)(st->live_blocks - listed));
+    }
+
+    pthread_mutex_unlock(&trace.lock);
+}
+
+static void *
+default_allocate(void *context, size_t size)
+{
+    (void)context;
+    return memory_allocator(size);
+}
+
+static void *
+default_reallocate(void *context, void *pointer, size_t old_size,
+    size_t new_size)
+{
+    (void)context;
+    (void)old_size;
+    return memory_reallocator(pointer, new_size);
+}
+
+static void
+default_deallocate(void *context, void *pointer, size_t size)
+{
+    (void)context;
+    (void)size;
+    memory_free(pointer);
+}
+
+static const Allocator default_allocator = {
+    .allocate = default_allocate,
+    .reallocate = default_reallocate,
+    .deallocate = default_deallocate,
+    .context = NULL,
+};
+
+/*
+@brief:
+Return the process-wide allocator backed by memory_allocator,
+memory_reallocator and memory_free.
+
+@post:
+    - return != NULL
+    - returned object has static storage duration
+*/
+const Allocator *
+allocator_default(void)
+{
+    return &default_allocator;
+}
+
+/*
+Size-class pool allocator.
+
+Requests up to POOL_MAX_CLASS bytes are rounded up to a size class
+(powers of two interleaved with their 1.5x midpoints, all multiples of
+16 bytes) and served from per-thread free lists. A thread cache that runs
+dry refills a batch from the global per-class list, which is in turn fed
+by carving POOL_SLAB_SIZE slabs. Oversized requests fall through to
+memory_allocator.
+
+Blocks carry no header: the size passed to reallocate/deallocate selects
+the class, which is why the pool is only reachable through the Allocator
+interface.
+*/
+
+#define POOL_CLASS_COUNT 22
+#define POOL_MIN_CLASS ((size_t)16)
+#define POOL_MAX_CLASS ((size_t)32768)
+#define POOL_SLAB_SIZE ((size_t)65536)
+
+static const size_t pool_class_size[POOL_CLASS_COUNT] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+    3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768};
+
+typedef struct PoolBlock
+{
+    struct PoolBlock *next;
+} PoolBlock;
+
+typedef struct PoolClass
+{
+    pthread_mutex_t lock;
+    PoolBlock *head;
+    size_t count;
+} PoolClass;
+
+typedef struct PoolCache
+{
+    PoolBlock *head[POOL_CLASS_COUNT];
+    size_t count[POOL_CLASS_COUNT];
+    bool registered;
+} PoolCache;
+
+static PoolClass pool_global[POOL_CLASS_COUNT];
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t pool_key;
+
+static _Thread_local PoolCache pool_cache;
+
+/*
+@brief:
+Map a request size to its size class.
+
+@pre:
+    - 0 < size <= POOL_MAX_CLASS
+
+@post:
+    - pool_class_size[return] >= size
+    - pool_class_size[return - 1] < size (when return > 0)
+*/
+static size_t
+pool_class_index(size_t size)
+{
+    if(size <= POOL_MIN_CLASS) return 0;
+    if(size <= 2 * POOL_MIN_CLASS) return 1;
+
+    size_t s = size - 1;
+    size_t k = (sizeof(unsigned long long) * CHAR_BIT - 1) -
+        (size_t)__builtin_clzll((unsigned long long)s);
+
+    // 2^k < size <= 2^(k + 1)
+    if(size <= ((size_t)3 << (k - 1))) return 2 * (k - 5) + 2;
+
+    return 2 * (k - 4) + 1;
+}
+
+/*
+@brief:
+Number of blocks moved between a thread cache and the global list at once.
+*/
+static size_t
+pool_batch(size_t class_index)
+{
+    size_t batch = (POOL_SLAB_SIZE / 4) / pool_class_size[class_index];
+
+    if(batch < 2) return 2;
+    if(batch > 64) return 64;
+
+    return batch;
+}
+
+static void
+pool_flush_class(PoolCache *cache, size_t class_index, size_t keep)
+{
+    if(cache->count[class_index] <= keep) return;
+
+    PoolBlock *first = cache->head[class_index];
+    PoolBlock *last = first;
+    size_t moved = cache->count[class_index] - keep;
+
+    for(size_t i = 1; i < moved; ++i) last = last->next;
+
+    cache->head[class_index] = last->next;
+    cache->count[class_index] = keep;
+
+    PoolClass *global = &pool_global[class_index];
+
+    pthread_mutex_lock(&global->lock);
+    last->next = global->head;
+    global->head = first;
+    global->count += moved;
+    pthread_mutex_unlock(&global->lock);
+}
+
+static void
+pool_thread_exit(void *value)
+{
+    PoolCache *cache = value;
+
+    for(size_t i = 0; i < POOL_CLASS_COUNT; ++i) pool_flush_class(cache, i, 0);
+}
+
+static void
+pool_init_once(void)
+{
+    for(size_t i = 0; i < POOL_CLASS_COUNT; ++i)
+    {
+        pthread_mutex_init(&pool_global[i].lock, NULL);
+        pool_global[i].head = NULL;
+        pool_global[i].count = 0;
+    }
+
+    pthread_key_create(&pool_key, pool_thread_exit);
+}
+
+/*
+@brief:
+Make sure the calling thread's cache is flushed when the thread exits.
+*/
+static void
+pool_register_thread(void)
+{
+    if(pool_cache.registered) return;
+
+    pthread_once(&pool_once, pool_init_once);
+    pthread_setspecific(pool_key, &pool_cache);
+    pool_cache.registered = true;
+}
+
+/*
+@brief:
+Refill the calling thread's cache for one class.
+
+@note:
+Takes a batch from the global list; carves a new slab when the global
+list is empty. Slabs stay owned by the pool for the process lifetime.
+
+@post:
+    On success:
+        - return 0
+        - pool_cache.head[class_index] != NULL
+
+    On failure:
+        - return ENOMEM
+*/
+static int
+pool_refill(size_t class_index)
+{
+    pool_register_thread();
+
+    PoolClass *global = &pool_global[class_index];
+    size_t batch = pool_batch(class_index);
+
+    pthread_mutex_lock(&global->lock);
+
+    if(global->count == 0)
+    {
+        unsigned char *slab = memory_allocator(POOL_SLAB_SIZE);
+        if(!slab)
+        {
+            pthread_mutex_unlock(&global->lock);
+            return ENOMEM;
+        }
+
+        size_t block_size = pool_class_size[class_index];
+        size_t blocks = POOL_SLAB_SIZE / block_size;
+
+        for(size_t i = 0; i < blocks; ++i)
+        {
+            PoolBlock *block = (PoolBlock *)(slab + i * block_size);
+            block->next = global->head;
+            global->head = block;
+        }
+
+        global->count += blocks;
+    }
+
+    PoolBlock *first = global->head;
+    PoolBlock *last = first;
+    size_t taken = 1;
+
+    while(taken < batch && last->next)
+    {
+        last = last->next;
+        ++taken;
+    }
+
+    global->head = last->next;
+    global->count -= taken;
+
+    pthread_mutex_unlock(&global->lock);
+
+    last->next = pool_cache.head[class_index];
+    pool_cache.head[class_index] = first;
+    pool_cache.count[class_index] += taken;
+
+    return 0;
+}
+
+static void *
+pool_allocate(void *context, size_t size)
+{
+    (void)context;
+
+    if(size == 0) size = 1;
+    if(size > POOL_MAX_CLASS) return memory_allocator(size);
+
+    size_t class_index = pool_class_index(size);
+
+    if(!pool_cache.head[class_index])
+    {
+        if(pool_refill(class_index)) return NULL;
+    }
+
+    PoolBlock *block = pool_cache.head[class_index];
+    pool_cache.head[class_index] = block->next;
+    --pool_cache.count[class_index];
+
+    return block;
+}
+
+static void
+pool_deallocate(void *context, void *pointer, size_t size)
+{
+    (void)context;
+
+    if(!pointer) return;
+
+    if(size == 0) size = 1;
+    if(size > POOL_MAX_CLASS)
+    {
+        memory_free(pointer);
+        return;
+    }
+
+    pool_register_thread();
+
+    size_t class_index = pool_class_index(size);
+
+    PoolBlock *block = pointer;
+    block->next = pool_cache.head[class_index];
+    pool_cache.head[class_index] = block;
+    ++pool_cache.count[class_index];
+
+    size_t batch = pool_batch(class_index);
+    if(pool_cache.count[class_index] > 2 * batch)
+    {
+        pool_flush_class(&pool_cache, class_index, batch);
+    }
+}
+
+static void *
+pool_reallocate(void *context, void *pointer, size_t old_size,
+    size_t new_size)
+{
+    if(!pointer) return pool_allocate(context, new_size);
+
+    if(old_size == 0) old_size = 1;
+    if(new_size == 0) new_size = 1;
+
+    if(old_size > POOL_MAX_CLASS && new_size > POOL_MAX_CLASS)
+    {
+        return memory_reallocator(pointer, new_size);
+    }
+
+    if(old_size <= POOL_MAX_CLASS && new_size <= POOL_MAX_CLASS &&
+        pool_class_index(old_size) == pool_class_index(new_size))
+    {
+        return pointer; // same class, block already large enough
+    }
+
+    void *tmp = pool_allocate(context, new_size);
+    if(!tmp) return NULL;
+
+    memcpy(tmp, pointer, old_size < new_size ? old_size : new_size);
+    pool_deallocate(context, pointer, old_size);
+
+    return tmp;
+}
+
+static const Allocator pool_allocator = {
+    .allocate = pool_allocate,
+    .reallocate = pool_reallocate,
+    .deallocate = pool_deallocate,
+    .context = NULL,
+};
+
+/*
+@brief:
+Return the process-wide size-class pool allocator.
+
+@note:
+Thread-safe. Blocks up to 32 KiB are aligned to 16 bytes; blocks may be
+released from a different thread than the one that allocated them.
+
+@post:
+    - return != NULL
+    - returned object has static storage duration
+*/
+const Allocator *
+allocator_pool(void)
+{
+    return &pool_allocator;
+}
+
+/*
+@brief:
+Return every block cached by the calling thread to the global lists.
+
+@note:
+Called automatically at thread exit for threads that used the pool.
+*/
+void
+allocator_pool_thread_flush(void)
+{
+    if(!pool_cache.registered) return;
+
+    for(size_t i = 0; i < POOL_CLASS_COUNT; ++i)
+    {
+        pool_flush_class(&pool_cache, i, 0);
+    }
+}
@@ -0,0 +1,294 @@
+#include "../include/arena.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+static const size_t ARENA_MIN_BLOCK = 256;
+static const size_t ARENA_ALIGN = alignof(max_align_t);
+
+/*
+@invariant:
+    - block->used <= block->size
+    - block->data is aligned to ARENA_ALIGN
+*/
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+} ArenaBlock;
+
+/*
+@invariant:
+    - arena->head is the block currently bumped into (or NULL)
+    - arena->last is the most recent allocation inside arena->head (or NULL)
+    - arena->used counts bytes handed out since the last reset
+*/
+struct Arena
+{
+    Allocator allocator;
+    ArenaBlock *head;
+    void *last;
+    size_t block_size;
+    size_t used;
+    size_t reserved;
+};
+
+static size_t
+arena_align_up(size_t size)
+{
+    return (size + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+static ArenaBlock *
+arena_block_new(Arena *arena, size_t min_size)
+{
+    size_t size = arena->block_size;
+    if(size < min_size) size = min_size;
+
+    size_t bytes;
+    if(add_safe(sizeof(ArenaBlock), size, &bytes)) return NULL;
+
+    ArenaBlock *block = memory_allocator(bytes);
+    if(!block) return NULL;
+
+    block->next = arena->head;
+    block->size = size;
+    block->used = 0;
+
+    arena->head = block;
+    arena->reserved += size;
+
+    return block;
+}
+
+/*
+@brief:
+Bump-allocate size bytes aligned to max_align_t.
+
+@note:
+Opens a new block when the current one is exhausted. Blocks are never
+revisited after a newer block has been opened until arena_reset().
+*/
+static void *
+arena_allocate(void *context, size_t size)
+{
+    Arena *arena = context;
+
+    if(size == 0) size = 1;
+    if(size > SIZE_MAX - ARENA_ALIGN) return NULL;
+
+    size_t aligned = arena_align_up(size);
+
+    ArenaBlock *block = arena->head;
+    if(!block || block->size - block->used < aligned)
+    {
+        block = arena_block_new(arena, aligned);
+        if(!block) return NULL;
+    }
+
+    void *pointer = block->data + block->used;
+    block->used += aligned;
+
+    arena->last = pointer;
+    arena->used += aligned;
+
+    return pointer;
+}
+
+/*
+@brief:
+Resize an arena allocation.
+
+@note:
+The most recent allocation is grown or shrunk in place when the current
+block has room. Any other allocation is copied into fresh arena memory and
+the old bytes stay reserved until arena_reset().
+*/
+static void *
+arena_reallocate(void *context, void *pointer, size_t old_size,
+    size_t new_size)
+{
+    Arena *arena = context;
+
+    if(!pointer) return arena_allocate(context, new_size);
+
+    if(new_size == 0) new_size = 1;
+    if(new_size > SIZE_MAX - ARENA_ALIGN) return NULL;
+
+    ArenaBlock *block = arena->head;
+    if(block && pointer == arena->last)
+    {
+        size_t offset = (size_t)((unsigned char *)pointer - block->data);
+        size_t aligned = arena_align_up(new_size);
+
+        if(aligned <= block->size - offset)
+        {
+            arena->used -= block->used - offset;
+            arena->used += aligned;
+            block->used = offset + aligned;
+            return pointer;
+        }
+    }
+
+    void *tmp = arena_allocate(context, new_size);
+    if(!tmp) return NULL;
+
+    memcpy(tmp, pointer, old_size < new_size ? old_size : new_size);
+
+    return tmp;
+}
+
+/*
+@brief:
+Release an arena allocation.
+
+@note:
+Only the most recent allocation is actually returned to the arena; all
+other memory is reclaimed by arena_reset() or arena_destroy().
+*/
+static void
+arena_deallocate(void *context, void *pointer, size_t size)
+{
+    (void)size;
+
+    Arena *arena = context;
+
+    ArenaBlock *block = arena->head;
+    if(!pointer || !block || pointer != arena->last) return;
+
+    size_t offset = (size_t)((unsigned char *)pointer - block->data);
+
+    arena->used -= block->used - offset;
+    block->used = offset;
+    arena->last = NULL;
+}
+
+/*
+@brief:
+Create a bump-pointer arena.
+
+@pre:
+    - out != NULL
+    - block_size is the preferred block size in bytes (0 selects a default)
+
+@ownership:
+    - caller must release arena with arena_destroy()
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+        - no block is allocated until the first allocation
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+arena_create(Arena **out, size_t block_size)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(block_size < ARENA_MIN_BLOCK) block_size = ARENA_MIN_BLOCK;
+    if(block_size > SIZE_MAX - ARENA_ALIGN) return EOVERFLOW;
+
+    Arena *tmp = memory_allocator(sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->allocator.allocate = arena_allocate;
+    tmp->allocator.reallocate = arena_reallocate;
+    tmp->allocator.deallocate = arena_deallocate;
+    tmp->allocator.context = tmp;
+    tmp->head = NULL;
+    tmp->last = NULL;
+    tmp->block_size = arena_align_up(block_size);
+    tmp->used = 0;
+    tmp->reserved = 0;
+
+    *out = tmp;
+
+    return 0;
+}
+
+/*
+@brief:
+Release the arena and every allocation made from it.
+
+@note:
+Function is null-safe and idempotent.
+*/
+void
+arena_destroy(Arena **arena)
+{
+    if(!arena || !*arena) return;
+
+    ArenaBlock *block = (*arena)->head;
+    while(block)
+    {
+        ArenaBlock *next = block->next;
+        memory_free(block);
+        block = next;
+    }
+
+    memory_free(*arena);
+    *arena = NULL;
+}
+
+/*
+@brief:
+Release every allocation made from the arena in one step.
+
+@note:
+The most recently opened block is kept for reuse, older blocks are freed.
+Objects allocated from the arena (including Array objects) must not be used
+after this call.
+*/
+void
+arena_reset(Arena *arena)
+{
+    if(!arena) return;
+
+    ArenaBlock *keep = arena->head;
+    if(keep)
+    {
+        ArenaBlock *block = keep->next;
+        while(block)
+        {
+            ArenaBlock *next = block->next;
+            arena->reserved -= block->size;
+            memory_free(block);
+            block = next;
+        }
+
+        keep->next = NULL;
+        keep->used = 0;
+    }
+
+    arena->last = NULL;
+    arena->used = 0;
+}
+
+const Allocator *
+arena_allocator(Arena *arena)
+{
+    return arena ? &arena->allocator : NULL;
+}
+
+size_t
+arena_bytes_used(const Arena *arena)
+{
+    return arena ? arena->used : 0;
+}
+
+size_t
+arena_bytes_reserved(const Arena *arena)
+{
+    return arena ? arena->reserved : 0;
+}
@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include "../include/array.h"
 
 #include "../include/allocator.h"
@@ -5,12 +7,29 @@
 #include <assert.h>
 #include <errno.h>
 #include <memory.h>
+#include <stdalign.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 static const size_t ARR_INIT_CAP = 8;
-static const size_t ARR_GROWTH_FACTOR = 2;
+
+// default growth: x2, never shrink automatically
+static const ArrayGrowthPolicy ARR_DEFAULT_POLICY = {
+    .factor_numerator = 2,
+    .factor_denominator = 1,
+    .linear_threshold = 0,
+    .linear_step = 0,
+    .callback = NULL,
+    .context = NULL,
+    .shrink_divisor = 0,
+    .incremental_step = 0,
+};
 
 /*
 @invariant:
@@ -21,6 +40,14 @@ static const size_t ARR_GROWTH_FACTOR = 2;
     - a->size <= a->capacity
     - a->size / a->element_size <= SIZE_MAX
     - a->capacity / a->element_size <= SIZE_MAX
+    - a->allocator != NULL
+    - a->policy != NULL
+    - a->data == a->inline_data implies a->capacity == a->inline_capacity
+    - a->inline_capacity == 0 implies a->data != a->inline_data
+    - a->mapping != NULL implies a->inline_capacity == 0
+    - a->old_data != NULL (incremental growth in progress) implies
+      a->migrated < a->old_count <= a->size and
+      a->old_count <= a->old_capacity < a->capacity
 */
 struct Array
 {
@@ -28,8 +55,308 @@ struct Array
     void *data;
     size_t element_size;
     size_t size;
+    const Allocator *allocator;
+    const ArrayGrowthPolicy *policy;
+    size_t inline_capacity;
+    unsigned flags;
+    struct ArrayMapping *mapping;
+    void *old_data;      // buffer being drained by incremental growth
+    size_t old_capacity; // its capacity in elements
+    size_t old_count;    // elements [migrated, old_count) still live there
+    size_t migrated;
+#ifdef ARRAY_STATS
+    ArrayStats stats;
+#endif
+    alignas(max_align_t) unsigned char inline_data[];
+};
+
+enum
+{
+    ARRAY_FLAG_OWNS_HEADER = 1u << 0,
 };
 
+static_assert(sizeof(struct Array) <= ARRAY_HEADER_SIZE,
+    "ARRAY_HEADER_SIZE must cover the Array header");
+
+static inline bool
+array_is_inline(const Array *a)
+{
+    return a->data == (const void *)a->inline_data;
+}
+
+/*
+Instrumentation counters, compiled in with -DARRAY_STATS only. Every
+update goes to the array and, with relaxed atomics, to the process-wide
+totals. Without the flag the hooks are empty and the counters take no
+space in the header.
+*/
+#ifdef ARRAY_STATS
+static struct
+{
+    _Atomic uint64_t reallocations;
+    _Atomic uint64_t bytes_moved;
+    _Atomic uint64_t bytes_allocated;
+    _Atomic uint64_t bytes_freed;
+    _Atomic uint64_t peak_capacity;
+    _Atomic uint64_t peak_size;
+} array_stats_global;
+
+static inline void
+array_stats_max(_Atomic uint64_t *peak, uint64_t value)
+{
+    uint64_t seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while(seen < value &&
+        !atomic_compare_exchange_weak_explicit(peak, &seen, value,
+            memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+/*
+@brief:
+Raise the peaks to the current capacity and size, for arrays that got
+them without growing (inline or initial capacity, mapped files).
+*/
+static inline void
+array_stats_peaks(Array *a)
+{
+    if(a->capacity > a->stats.peak_capacity)
+    {
+        a->stats.peak_capacity = a->capacity;
+        array_stats_max(&array_stats_global.peak_capacity, a->capacity);
+    }
+
+    if(a->size > a->stats.peak_size)
+    {
+        a->stats.peak_size = a->size;
+        array_stats_max(&array_stats_global.peak_size, a->size);
+    }
+}
+
+static inline void
+array_stats_init(Array *a)
+{
+    memset(&a->stats, 0, sizeof(a->stats));
+    array_stats_peaks(a);
+}
+
+static inline void
+array_stats_moved(Array *a, size_t bytes)
+{
+    a->stats.bytes_moved += bytes;
+    atomic_fetch_add_explicit(&array_stats_global.bytes_moved, bytes,
+        memory_order_relaxed);
+}
+
+static inline void
+array_stats_allocated(Array *a, size_t bytes)
+{
+    a->stats.bytes_allocated += bytes;
+    atomic_fetch_add_explicit(&array_stats_global.bytes_allocated, bytes,
+        memory_order_relaxed);
+}
+
+static inline void
+array_stats_freed(Array *a, size_t bytes)
+{
+    a->stats.bytes_freed += bytes;
+    atomic_fetch_add_explicit(&array_stats_global.bytes_freed, bytes,
+        memory_order_relaxed);
+}
+
+static inline void
+array_stats_resized(Array *a)
+{
+    ++a->stats.reallocations;
+    atomic_fetch_add_explicit(&array_stats_global.reallocations, 1,
+        memory_order_relaxed);
+
+    if(a->capacity > a->stats.peak_capacity)
+    {
+        a->stats.peak_capacity = a->capacity;
+        array_stats_max(&array_stats_global.peak_capacity, a->capacity);
+    }
+}
+
+static inline void
+array_stats_size(Array *a)
+{
+    if(a->size > a->stats.peak_size)
+    {
+        a->stats.peak_size = a->size;
+        array_stats_max(&array_stats_global.peak_size, a->size);
+    }
+}
+#else
+static inline void
+array_stats_peaks(Array *a)
+{
+    (void)a;
+}
+
+static inline void
+array_stats_init(Array *a)
+{
+    (void)a;
+}
+
+static inline void
+array_stats_moved(Array *a, size_t bytes)
+{
+    (void)a;
+    (void)bytes;
+}
+
+static inline void
+array_stats_allocated(Array *a, size_t bytes)
+{
+    (void)a;
+    (void)bytes;
+}
+
+static inline void
+array_stats_freed(Array *a, size_t bytes)
+{
+    (void)a;
+    (void)bytes;
+}
+
+static inline void
+array_stats_resized(Array *a)
+{
+    (void)a;
+}
+
+static inline void
+array_stats_size(Array *a)
+{
+    (void)a;
+}
+#endif // ARRAY_STATS
+
+/*
+Incremental growth (policy->incremental_step != 0).
+
+Growing heap storage allocates the new buffer but leaves the elements in
+the old one; every later array_push_back() then moves at most
+incremental_step of them, front to back, like incremental rehashing.
+Until the old buffer is drained, elements [migrated, old_count) are read
+and written in place there and every other index lives in data. A push
+never pays for more than one step of copying, instead of the O(size)
+copy of a realloc.
+
+Mutating operations that need the elements contiguous (array_data(),
+spans, iterators, inserts, erases, ...) finish the migration first.
+Functions taking a const Array never move elements, so readers sharing
+one array stay safe: they read through array_slot(), and
+array_data_const() returns NULL until the migration is done.
+*/
+
+/*
+@brief:
+Address of element index, in whichever buffer currently holds it.
+*/
+static inline char *
+array_slot(const Array *a, size_t index)
+{
+    const void *base = a->old_data && index >= a->migrated &&
+            index < a->old_count
+        ? a->old_data
+        : a->data;
+
+    return (char *)base + index * a->element_size;
+}
+
+/*
+@brief:
+Move up to count elements from the old buffer and free it once empty.
+*/
+static void
+array_migrate(Array *a, size_t count)
+{
+    size_t left = a->old_count - a->migrated;
+    if(count > left) count = left;
+
+    size_t offset = a->migrated * a->element_size;
+    size_t bytes = count * a->element_size;
+
+    memcpy((char *)a->data + offset, (char *)a->old_data + offset, bytes);
+    array_stats_moved(a, bytes);
+
+    a->migrated += count;
+    if(a->migrated < a->old_count) return;
+
+    size_t old_bytes = a->old_capacity * a->element_size;
+    a->allocator->deallocate(a->allocator->context, a->old_data, old_bytes);
+    array_stats_freed(a, old_bytes);
+
+    a->old_data = NULL;
+    a->old_capacity = 0;
+    a->old_count = 0;
+    a->migrated = 0;
+}
+
+/*
+@brief:
+Finish a pending migration so that data holds every element.
+*/
+static inline void
+array_settle(Array *a)
+{
+    if(a->old_data) array_migrate(a, SIZE_MAX);
+}
+
+/*
+@brief:
+Copy count elements starting at index into dst without settling, for
+read-only callers: the range may span the migrated prefix, the old
+buffer and the tail past old_count.
+*/
+static void
+array_copy_out(const Array *a, size_t index, size_t count, void *dst)
+{
+    char *out = dst;
+    size_t es = a->element_size;
+
+    while(count)
+    {
+        size_t run = count;
+
+        // split where array_slot() switches buffers
+        if(a->old_data)
+        {
+            if(index < a->migrated && a->migrated - index < run)
+            {
+                run = a->migrated - index;
+            }
+            else if(index >= a->migrated && index < a->old_count &&
+                a->old_count - index < run)
+            {
+                run = a->old_count - index;
+            }
+        }
+
+        memcpy(out, array_slot(a, index), run * es);
+
+        out += run * es;
+        index += run;
+        count -= run;
+    }
+}
+
+/*
+@brief:
+Forget old-buffer elements at or past a size that just shrank.
+*/
+static inline void
+array_drop_migrated_tail(Array *a)
+{
+    if(!a->old_data || a->old_count <= a->size) return;
+
+    a->old_count = a->size > a->migrated ? a->size : a->migrated;
+    array_migrate(a, 0); // frees the old buffer if nothing is left in it
+}
+
 int
 array_invariant_validation(const Array *array)
 {
@@ -47,8 +374,26 @@ array_invariant_validation(const Array *array)
 
     if(array->element_size == 0) return EINVAL;
 
+    if(array->allocator == NULL) return EINVAL;
+
+    if(array->policy == NULL) return EINVAL;
+
     if(array->size > array->capacity) return EINVAL;
 
+    if(array_is_inline(array))
+    {
+        if(array->inline_capacity == 0) return EINVAL;
+        if(array->capacity != array->inline_capacity) return EINVAL;
+    }
+
+    if(array->old_data)
+    {
+        if(array->migrated >= array->old_count) return EINVAL;
+        if(array->old_count > array->size) return EINVAL;
+        if(array->old_count > array->old_capacity) return EINVAL;
+        if(array->old_capacity >= array->capacity) return EINVAL;
+    }
+
     return 0;
 }
 
@@ -247,6 +592,7 @@ Creates a dynamic array object and allocates initial storage.
 
 @note:
 Returned object satisfies all Array invariants.
+Header and the first ARR_INIT_CAP elements share one allocation.
 
 @pre:
     - out != NULL
@@ -272,383 +618,1825 @@ Returned object satisfies all Array invariants.
 int
 array_create(Array **object, size_t element_size)
 {
-    if(!object || !element_size) return EINVAL;
-
-    *object = NULL;
-
-    size_t new_bytes;
-    if(mul_safe(ARR_INIT_CAP, element_size, &new_bytes)) return EOVERFLOW;
-
-    Array *tmp = memory_allocator(sizeof(*tmp));
-    if(!tmp) return ENOMEM;
-
-    tmp->data = memory_allocator(new_bytes);
-    if(!tmp->data)
-    {
-        memory_free(tmp);
-        return ENOMEM;
-    }
-
-    tmp->capacity = ARR_INIT_CAP;
-    tmp->element_size = element_size;
-    tmp->size = 0;
-
-    *object = tmp;
-
-    return 0;
+    return array_create_with_allocator(object, element_size,
+        allocator_default());
 }
 
-/*
-API
-
-@responsibility
-Releases array object and all owned resources.
-
-@ownership
-Consumes ownership of array *object.
-Destroyed object lifetime ends after successful call.
-Function is null-safe and idempotent.
-
-@lifetime
-Ends object lifetime.
-*/
-
 /*
 Contract
 
+@brief
+Creates a dynamic array object whose header and storage are obtained from
+the given allocator.
+
 @pre:
-    - object may be NULL
-    - *object may be NULL
+    - out != NULL
+    - element_size > 0
+    - allocator != NULL
+    - allocator outlives the array object
 
 @post:
-    - owned internal buffer released
-    - owned object released
-    - *object == NULL if object != NULL
-    - no memory leaked
+    Same as array_create(), additionally:
+        - every later allocation of the object goes through allocator
 */
-void
-array_destroy(Array **object)
+int
+array_create_with_allocator(Array **object, size_t element_size,
+    const Allocator *allocator)
 {
-    if(object && *object)
-    {
-        memory_free((*object)->data);
-        memory_free(*object);
-        *object = NULL;
-    }
+    if(!object || !element_size || !allocator) return EINVAL;
+
+    *object = NULL;
+
+    return array_create_inline(object, element_size, ARR_INIT_CAP,
+        allocator);
 }
 
 /*
-@brief:
-Initialize a dynamic array.
+Contract
+
+@brief
+Creates a dynamic array object with room for inline_capacity elements
+inside the object itself.
 
 @note:
-Returned object satisfies all Array invariants.
+Header and inline elements are obtained with a single allocation. Storage
+only moves to a separate block once the array outgrows inline_capacity.
+inline_capacity == 0 creates an array without inline storage.
 
 @pre:
+    - out != NULL
     - element_size > 0
+    - allocator != NULL
 
 @post:
-    On success (return != NULL):
-        - a->capacity == ARR_INIT_CAP
-        - a->data != NULL
-        - a->element_size == element_size
-        - a->size == 0
-        - ARR_INIT_CAP * element_size did not overflow
+    On success (return == 0):
+        - *out != NULL
+        - array_capacity(*out) == inline_capacity
+        - array_size(*out) == 0
 
-    On failure: (return == NULL)
+    On failure (return != 0):
+        - *out == NULL
         - no memory is leaked
 */
-Array *
-array_init(size_t element_size)
+int
+array_create_inline(Array **object, size_t element_size,
+    size_t inline_capacity, const Allocator *allocator)
 {
-    if(element_size == 0) return NULL;
+    if(!object || !element_size || !allocator) return EINVAL;
 
-    size_t new_bytes;
-    if(mul_safe(ARR_INIT_CAP, element_size, &new_bytes)) return NULL;
+    *object = NULL;
 
-    Array *tmp = calloc(1, sizeof(*tmp));
-    if(!tmp) return NULL;
+    size_t inline_bytes;
+    if(mul_safe(inline_capacity, element_size, &inline_bytes))
+    {
+        return EOVERFLOW;
+    }
 
-    void *data = malloc(new_bytes);
-    if(!data)
+    size_t total_bytes;
+    if(add_safe(offsetof(Array, inline_data), inline_bytes, &total_bytes))
     {
-        free(tmp);
-        return NULL;
+        return EOVERFLOW;
     }
 
-    tmp->data = data;
+    Array *tmp = allocator->allocate(allocator->context, total_bytes);
+    if(!tmp) return ENOMEM;
+
+    tmp->data = inline_capacity ? tmp->inline_data : NULL;
+    tmp->capacity = inline_capacity;
     tmp->element_size = element_size;
     tmp->size = 0;
-    tmp->capacity = ARR_INIT_CAP;
+    tmp->allocator = allocator;
+    tmp->policy = &ARR_DEFAULT_POLICY;
+    tmp->inline_capacity = inline_capacity;
+    tmp->flags = ARRAY_FLAG_OWNS_HEADER;
+    tmp->mapping = NULL;
+    tmp->old_data = NULL;
+    tmp->old_capacity = 0;
+    tmp->old_count = 0;
+    tmp->migrated = 0;
+    array_stats_init(tmp);
+    array_stats_allocated(tmp, total_bytes);
 
-    return tmp;
+    *object = tmp;
+
+    return 0;
 }
 
 /*
-@brief:
-Delete the dynamic array and releases owned memory
+Contract
 
-@pre:
-    - *a may be NULL
-    - a may be NULL
+@brief
+Constructs an array inside caller-provided storage (e.g. on the stack).
 
-@post:
-    - no memory is leaked
+@note:
+Every byte of storage past the header is used for inline elements; use
+ARRAY_INPLACE_BYTES() to size the buffer. array_destroy() releases heap
+storage acquired by growth but never the caller's buffer.
 
-    if a != NULL && *a != NULL:
-        - (*a)->data is freed
-        - *a is freed
-        - *a is set to NULL
+@pre:
+    - out != NULL
+    - storage != NULL and aligned to max_align_t
+    - storage_size >= ARRAY_HEADER_SIZE
+    - element_size > 0
+    - storage outlives the array object
 
-    if a == NULL || *a == NULL:
-        - no action
+@post:
+    On success (return == 0):
+        - *out == storage
+        - array_capacity(*out) ==
+          (storage_size - header size) / element_size
 
-@note:
-Function is idempotent
+    On failure (return != 0):
+        - *out == NULL
 */
-void
-array_delete(Array **a)
+int
+array_init_inplace(Array **object, void *storage, size_t storage_size,
+    size_t element_size)
 {
-    if(!a) return;
+    if(!object) return EINVAL;
 
-    if(*a)
-    {
-        free((*a)->data);
-        free(*a);
-        *a = NULL;
-    }
-}
+    *object = NULL;
 
-int
-array_reserve(Array *a, size_t min_capacity)
-{
-    if(!a) return EINVAL;
+    if(!storage || !element_size) return EINVAL;
+    if(storage_size < ARRAY_HEADER_SIZE) return EINVAL;
+    if((uintptr_t)storage % alignof(max_align_t)) return EINVAL;
 
-    assert(array_invariant_validation(a) == 0);
+    Array *tmp = storage;
 
-    if(min_capacity <= a->capacity) return 0; // enough capacity
+    size_t inline_capacity =
+        (storage_size - offsetof(Array, inline_data)) / element_size;
 
-    size_t new_capacity = a->capacity ? a->capacity : ARR_INIT_CAP;
+    tmp->data = inline_capacity ? tmp->inline_data : NULL;
+    tmp->capacity = inline_capacity;
+    tmp->element_size = element_size;
+    tmp->size = 0;
+    tmp->allocator = allocator_default();
+    tmp->policy = &ARR_DEFAULT_POLICY;
+    tmp->inline_capacity = inline_capacity;
+    tmp->flags = 0;
+    tmp->mapping = NULL;
+    tmp->old_data = NULL;
+    tmp->old_capacity = 0;
+    tmp->old_count = 0;
+    tmp->migrated = 0;
+    array_stats_init(tmp);
 
-    while(new_capacity < min_capacity)
-    {
-        if(mul_safe(new_capacity, ARR_GROWTH_FACTOR, &new_capacity))
-        {
+    *object = tmp;
+
+    return 0;
+}
+
+/*
+File-backed arrays.
+
+The file starts with an ArrayFileHeader followed by the elements, so data
+points ARRAY_FILE_HEADER_SIZE bytes into a mapping of the whole file.
+Capacity is whatever the file size leaves room for; count is only written
+back by array_sync() and array_destroy(). Fields are stored in host byte
+order.
+*/
+#define ARRAY_FILE_MAGIC "ADSARRAY"
+
+enum
+{
+    ARRAY_FILE_VERSION = 1,
+    ARRAY_FILE_HEADER_SIZE = 64,
+};
+
+typedef struct ArrayFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t element_size;
+    uint64_t count;
+    unsigned char reserved[32];
+} ArrayFileHeader;
+
+static_assert(sizeof(ArrayFileHeader) == ARRAY_FILE_HEADER_SIZE,
+    "ArrayFileHeader must stay 64 bytes");
+
+struct ArrayMapping
+{
+    int fd;
+    void *base;
+    size_t map_bytes;
+    bool read_only;
+};
+
+static int
+array_mapped_bytes(size_t capacity, size_t element_size, size_t *out)
+{
+    size_t bytes;
+    if(mul_safe(capacity, element_size, &bytes)) return EOVERFLOW;
+
+    return add_safe(ARRAY_FILE_HEADER_SIZE, bytes, out);
+}
+
+/*
+@brief:
+Resize the file and its mapping to exactly new_capacity elements.
+
+@note:
+Growth extends the file with ftruncate before mremap so that every mapped
+page is backed; shrinking unmaps first. Mapped arrays keep room for at
+least one element.
+*/
+static int
+array_mapped_resize(Array *a, size_t new_capacity)
+{
+    struct ArrayMapping *m = a->mapping;
+
+    if(m->read_only) return EROFS;
+
+    if(new_capacity == 0) new_capacity = 1;
+
+    size_t new_bytes;
+    if(array_mapped_bytes(new_capacity, a->element_size, &new_bytes))
+    {
+        return EOVERFLOW;
+    }
+
+    if(new_bytes == m->map_bytes) return 0;
+
+    if(new_bytes > m->map_bytes && ftruncate(m->fd, (off_t)new_bytes))
+    {
+        return errno;
+    }
+
+    void *base = mremap(m->base, m->map_bytes, new_bytes, MREMAP_MAYMOVE);
+    if(base == MAP_FAILED)
+    {
+        int error = errno;
+        if(new_bytes > m->map_bytes)
+        {
+            (void)ftruncate(m->fd, (off_t)m->map_bytes);
+        }
+        return error;
+    }
+
+    // a failed shrink only leaves unused bytes at the end of the file
+    if(new_bytes < m->map_bytes) (void)ftruncate(m->fd, (off_t)new_bytes);
+
+    m->base = base;
+    m->map_bytes = new_bytes;
+
+    a->data = (char *)base + ARRAY_FILE_HEADER_SIZE;
+    a->capacity = new_capacity;
+
+    return 0;
+}
+
+static void
+array_mapped_close(Array *a)
+{
+    struct ArrayMapping *m = a->mapping;
+
+    if(!m->read_only)
+    {
+        ArrayFileHeader *header = m->base;
+        header->count = a->size;
+    }
+
+    munmap(m->base, m->map_bytes);
+    close(m->fd);
+    memory_free(m);
+
+    a->mapping = NULL;
+    a->data = NULL;
+    a->capacity = 0;
+}
+
+/*
+@brief:
+Validate the header of an existing file, or write a fresh one.
+
+@post:
+    On success:
+        - return 0
+        - *count is the element count stored in the file
+*/
+static int
+array_mapped_header(void *base, size_t map_bytes, size_t element_size,
+    bool fresh, size_t *count)
+{
+    ArrayFileHeader *header = base;
+
+    if(fresh)
+    {
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, ARRAY_FILE_MAGIC, sizeof(header->magic));
+        header->version = ARRAY_FILE_VERSION;
+        header->header_size = ARRAY_FILE_HEADER_SIZE;
+        header->element_size = element_size;
+        header->count = 0;
+
+        *count = 0;
+        return 0;
+    }
+
+    if(memcmp(header->magic, ARRAY_FILE_MAGIC, sizeof(header->magic)))
+    {
+        return EINVAL;
+    }
+    if(header->version != ARRAY_FILE_VERSION) return EINVAL;
+    if(header->header_size != ARRAY_FILE_HEADER_SIZE) return EINVAL;
+    if(header->element_size != element_size) return EINVAL;
+
+    size_t used;
+    if(header->count > SIZE_MAX) return EINVAL;
+    if(array_mapped_bytes((size_t)header->count, element_size, &used))
+    {
+        return EINVAL;
+    }
+    if(used > map_bytes) return EINVAL;
+
+    *count = (size_t)header->count;
+
+    return 0;
+}
+
+/*
+Contract
+
+@brief
+Opens a file as the storage of an array.
+
+@note:
+The whole file is mapped; elements are read and written in place and
+growth extends the file (ftruncate + mremap). An empty file, or one
+created through ARRAY_MAPPED_CREATE, starts with ARR_INIT_CAP elements of
+capacity. The element count is persisted by array_sync() and by
+array_destroy().
+
+ARRAY_MAPPED_READ_ONLY maps the file copy-on-write: the pages are shared
+with every other reader, modifications stay private to the process and
+any operation that needs to resize the file fails with EROFS.
+
+@pre:
+    - out != NULL
+    - path != NULL
+    - element_size > 0 and equal to the element size stored in the file
+    - flags is a combination of ARRAY_MAPPED_* flags; READ_ONLY cannot be
+      combined with CREATE or TRUNCATE
+
+@ownership:
+    - caller must release object with array_destroy(), which unmaps and
+      closes the file
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+        - array_size(*out) == element count stored in the file
+
+    On failure (return != 0):
+        - *out == NULL
+        - return EINVAL for a file that is not a compatible array file, or
+          the errno of the failed system call
+*/
+int
+array_open_mapped(Array **object, const char *path, size_t element_size,
+    unsigned flags)
+{
+    if(!object) return EINVAL;
+
+    *object = NULL;
+
+    if(!path || !element_size) return EINVAL;
+
+    const unsigned known = ARRAY_MAPPED_READ_ONLY | ARRAY_MAPPED_CREATE |
+        ARRAY_MAPPED_TRUNCATE;
+    if(flags & ~known) return EINVAL;
+
+    bool read_only = flags & ARRAY_MAPPED_READ_ONLY;
+    if(read_only && (flags & ~(unsigned)ARRAY_MAPPED_READ_ONLY)) return EINVAL;
+
+    int open_flags = (read_only ? O_RDONLY : O_RDWR) | O_CLOEXEC;
+    if(flags & ARRAY_MAPPED_CREATE) open_flags |= O_CREAT;
+    if(flags & ARRAY_MAPPED_TRUNCATE) open_flags |= O_TRUNC;
+
+    int fd = open(path, open_flags, 0644);
+    if(fd < 0) return errno;
+
+    int error = 0;
+    void *base = MAP_FAILED;
+    size_t map_bytes = 0;
+    Array *tmp = NULL;
+    struct ArrayMapping *mapping = NULL;
+
+    struct stat st;
+    if(fstat(fd, &st))
+    {
+        error = errno;
+        goto fail;
+    }
+
+    bool fresh = st.st_size == 0;
+
+    if(fresh)
+    {
+        if(read_only)
+        {
+            error = EINVAL;
+            goto fail;
+        }
+
+        error = array_mapped_bytes(ARR_INIT_CAP, element_size, &map_bytes);
+        if(error) goto fail;
+
+        if(ftruncate(fd, (off_t)map_bytes))
+        {
+            error = errno;
+            goto fail;
+        }
+    }
+    else
+    {
+        if((uintmax_t)st.st_size < ARRAY_FILE_HEADER_SIZE ||
+            (uintmax_t)st.st_size > SIZE_MAX)
+        {
+            error = EINVAL;
+            goto fail;
+        }
+
+        map_bytes = (size_t)st.st_size;
+    }
+
+    base = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE,
+        read_only ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED)
+    {
+        error = errno;
+        goto fail;
+    }
+
+    size_t count;
+    error = array_mapped_header(base, map_bytes, element_size, fresh, &count);
+    if(error) goto fail;
+
+    mapping = memory_allocator(sizeof(*mapping));
+    if(!mapping)
+    {
+        error = ENOMEM;
+        goto fail;
+    }
+
+    error = array_create_inline(&tmp, element_size, 0, allocator_default());
+    if(error) goto fail;
+
+    mapping->fd = fd;
+    mapping->base = base;
+    mapping->map_bytes = map_bytes;
+    mapping->read_only = read_only;
+
+    tmp->capacity = (map_bytes - ARRAY_FILE_HEADER_SIZE) / element_size;
+    tmp->data = tmp->capacity ? (char *)base + ARRAY_FILE_HEADER_SIZE : NULL;
+    tmp->size = count;
+    tmp->mapping = mapping;
+    array_stats_peaks(tmp);
+
+    *object = tmp;
+
+    return 0;
+
+fail:
+    memory_free(mapping);
+    if(base != MAP_FAILED) munmap(base, map_bytes);
+    close(fd);
+
+    return error;
+}
+
+/*
+@brief:
+Write the element count to the file header and flush the mapping to disk.
+
+@post:
+    On success:
+        - return 0
+        - reopening the file yields the current contents
+
+    On failure:
+        - return EINVAL for an array that is not file-backed, EROFS for a
+          read-only mapping, or the errno of msync
+*/
+int
+array_sync(Array *a)
+{
+    if(!a || !a->mapping) return EINVAL;
+
+    struct ArrayMapping *m = a->mapping;
+    if(m->read_only) return EROFS;
+
+    ArrayFileHeader *header = m->base;
+    header->count = a->size;
+
+    if(msync(m->base, m->map_bytes, MS_SYNC)) return errno;
+
+    return 0;
+}
+
+/*
+@brief:
+Return the storage and the header of an array to its allocator.
+
+@pre:
+    - a != NULL
+*/
+static void
+array_release(Array *a)
+{
+    const Allocator *allocator = a->allocator;
+
+    if(a->old_data)
+    {
+        array_stats_freed(a, a->old_capacity * a->element_size);
+        allocator->deallocate(allocator->context, a->old_data,
+            a->old_capacity * a->element_size);
+    }
+
+    if(a->mapping)
+    {
+        array_mapped_close(a);
+    }
+    else if(a->data && !array_is_inline(a))
+    {
+        array_stats_freed(a, a->capacity * a->element_size);
+        allocator->deallocate(allocator->context, a->data,
+            a->capacity * a->element_size);
+    }
+
+    if(a->flags & ARRAY_FLAG_OWNS_HEADER)
+    {
+        size_t header_bytes =
+            offsetof(Array, inline_data) + a->inline_capacity * a->element_size;
+
+        array_stats_freed(a, header_bytes);
+        allocator->deallocate(allocator->context, a, header_bytes);
+    }
+}
+
+/*
+API
+
+@responsibility
+Releases array object and all owned resources.
+
+@ownership
+Consumes ownership of array *object.
+Destroyed object lifetime ends after successful call.
+Function is null-safe and idempotent.
+
+@lifetime
+Ends object lifetime.
+*/
+
+/*
+Contract
+
+@pre:
+    - object may be NULL
+    - *object may be NULL
+
+@post:
+    - owned internal buffer released
+    - owned object released
+    - *object == NULL if object != NULL
+    - no memory leaked
+*/
+void
+array_destroy(Array **object)
+{
+    if(object && *object)
+    {
+        array_release(*object);
+        *object = NULL;
+    }
+}
+
+/*
+@brief:
+Initialize a dynamic array.
+
+@note:
+Returned object satisfies all Array invariants.
+
+@pre:
+    - element_size > 0
+
+@post:
+    On success (return != NULL):
+        - a->capacity == ARR_INIT_CAP
+        - a->data != NULL
+        - a->element_size == element_size
+        - a->size == 0
+        - ARR_INIT_CAP * element_size did not overflow
+
+    On failure: (return == NULL)
+        - no memory is leaked
+*/
+Array *
+array_init(size_t element_size)
+{
+    Array *tmp = NULL;
+
+    if(array_create(&tmp, element_size)) return NULL;
+
+    return tmp;
+}
+
+/*
+@brief:
+Delete the dynamic array and releases owned memory
+
+@pre:
+    - *a may be NULL
+    - a may be NULL
+
+@post:
+    - no memory is leaked
+
+    if a != NULL && *a != NULL:
+        - (*a)->data is freed
+        - *a is freed
+        - *a is set to NULL
+
+    if a == NULL || *a == NULL:
+        - no action
+
+@note:
+Function is idempotent
+*/
+void
+array_delete(Array **a)
+{
+    if(!a) return;
+
+    if(*a)
+    {
+        array_release(*a);
+        *a = NULL;
+    }
+}
+
+/*
+@brief:
+Compute the capacity the policy grows to when min_capacity elements are
+needed.
+
+@note:
+Geometric growth by factor_numerator / factor_denominator starting at
+ARR_INIT_CAP; once capacity reaches linear_threshold (when non-zero) it
+grows by linear_step instead. A callback replaces both rules.
+
+@post:
+    On success:
+        - return 0
+        - *out >= min_capacity
+
+    On failure:
+        - return EOVERFLOW or EINVAL (callback returned too little)
+        - *out is unchanged
+*/
+static int
+array_next_capacity(const ArrayGrowthPolicy *policy, size_t capacity,
+    size_t min_capacity, size_t *out)
+{
+    if(policy->callback)
+    {
+        size_t proposed = policy->callback(capacity, min_capacity,
+            policy->context);
+        if(proposed < min_capacity) return EINVAL;
+
+        *out = proposed;
+        return 0;
+    }
+
+    size_t new_capacity = capacity ? capacity : ARR_INIT_CAP;
+
+    while(new_capacity < min_capacity)
+    {
+        if(policy->linear_threshold && new_capacity >= policy->linear_threshold)
+        {
+            // jump straight to the first step boundary past min_capacity
+            size_t missing = min_capacity - new_capacity;
+            size_t steps = missing / policy->linear_step +
+                (missing % policy->linear_step != 0);
+
+            size_t grow;
+            if(mul_safe(steps, policy->linear_step, &grow)) return EOVERFLOW;
+            if(add_safe(new_capacity, grow, &new_capacity)) return EOVERFLOW;
+            break;
+        }
+
+        size_t scaled;
+        if(mul_safe(new_capacity, policy->factor_numerator, &scaled))
+        {
             return EOVERFLOW;
         }
+        scaled /= policy->factor_denominator;
+
+        // small capacities must still make progress with factors like 1.5
+        new_capacity = scaled > new_capacity ? scaled : new_capacity + 1;
+    }
+
+    *out = new_capacity;
+
+    return 0;
+}
+
+/*
+@brief:
+Grow a raw element buffer to hold at least min_capacity elements.
+
+@note:
+Growth path of the typed arrays generated by ARRAY_DEFINE. Array itself
+grows through array_resize_storage() instead. This path always uses the
+default policy: capacity starts at ARR_INIT_CAP and doubles until it is
+large enough. It has no growth policies, stats or incremental growth.
+
+@pre:
+    - data != NULL
+    - capacity != NULL
+    - *data was obtained from allocator for *capacity elements (or is NULL
+      with *capacity == 0)
+    - element_size > 0
+    - allocator != NULL
+
+@post:
+    On success:
+        - return 0
+        - *capacity >= min_capacity
+        - *data holds the previous contents
+
+    On failure:
+        - return error code
+        - *data and *capacity are unchanged
+*/
+int
+array_storage_grow(void **data, size_t *capacity, size_t element_size,
+    size_t min_capacity, const Allocator *allocator)
+{
+    if(!data || !capacity || !element_size || !allocator) return EINVAL;
+
+    if(min_capacity <= *capacity) return 0; // enough capacity
+
+    size_t new_capacity;
+    int error = array_next_capacity(&ARR_DEFAULT_POLICY, *capacity,
+        min_capacity, &new_capacity);
+    if(error) return error;
+
+    size_t new_bytes;
+    if(mul_safe(new_capacity, element_size, &new_bytes)) return EOVERFLOW;
+
+    void *tmp = allocator->reallocate(allocator->context, *data,
+        *capacity * element_size, new_bytes);
+    if(!tmp) return ENOMEM;
+
+    *data = tmp;
+    *capacity = new_capacity;
+
+    return 0;
+}
+
+/*
+@brief:
+Move the elements into storage of exactly new_capacity elements.
+
+@note:
+Handles every storage transition: heap -> heap goes through reallocate,
+inline -> heap allocates and copies once, heap -> inline (when
+new_capacity fits the inline buffer) copies back and frees the heap block.
+File-backed arrays resize the file and its mapping instead. With
+incremental growth, heap -> larger heap only allocates; see array_slot().
+
+@pre:
+    - a != NULL
+    - new_capacity >= a->size
+
+@post:
+    On success:
+        - return 0
+        - array_capacity(a) == new_capacity, or == a->inline_capacity when
+          the elements moved back inline
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
+static int
+array_resize_storage(Array *a, size_t new_capacity)
+{
+    // at most one buffer drains at a time
+    array_settle(a);
+
+    if(a->mapping)
+    {
+        int error = array_mapped_resize(a, new_capacity);
+        if(!error) array_stats_resized(a);
+        return error;
+    }
+
+    const Allocator *allocator = a->allocator;
+
+    if(new_capacity <= a->inline_capacity)
+    {
+        if(array_is_inline(a)) return 0; // inline bytes cannot be returned
+
+        void *heap = a->data;
+        size_t heap_bytes = a->capacity * a->element_size;
+
+        if(a->inline_capacity)
+        {
+            memcpy(a->inline_data, heap, a->size * a->element_size);
+            a->data = a->inline_data;
+        }
+        else
+        {
+            a->data = NULL;
+        }
+
+        a->capacity = a->inline_capacity;
+
+        allocator->deallocate(allocator->context, heap, heap_bytes);
+
+        array_stats_freed(a, heap_bytes);
+        array_stats_resized(a);
+
+        return 0;
+    }
+
+    size_t new_bytes;
+    if(mul_safe(new_capacity, a->element_size, &new_bytes)) return EOVERFLOW;
+
+    void *tmp;
+
+    if(array_is_inline(a))
+    {
+        // inline storage cannot be reallocated in place, copy it once
+        tmp = allocator->allocate(allocator->context, new_bytes);
+        if(!tmp) return ENOMEM;
+
+        memcpy(tmp, a->data, a->size * a->element_size);
+    }
+    else if(a->policy->incremental_step && a->size &&
+        new_capacity > a->capacity)
+    {
+        // elements stay put; pushes move them over a step at a time
+        tmp = allocator->allocate(allocator->context, new_bytes);
+        if(!tmp) return ENOMEM;
+
+        a->old_data = a->data;
+        a->old_capacity = a->capacity;
+        a->old_count = a->size;
+        a->migrated = 0;
+    }
+    else
+    {
+        tmp = allocator->reallocate(allocator->context, a->data,
+            a->capacity * a->element_size, new_bytes);
+        if(!tmp) return ENOMEM;
+
+        array_stats_freed(a, a->capacity * a->element_size);
+    }
+
+    a->data = tmp;
+    a->capacity = new_capacity;
+
+    array_stats_allocated(a, new_bytes);
+    array_stats_resized(a);
+
+    return 0;
+}
+
+/*
+@brief:
+Ensure room for at least min_capacity elements, growing by the array's
+growth policy.
+
+@post:
+    On success:
+        - return 0
+        - array_capacity(a) >= min_capacity
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
+int
+array_reserve(Array *a, size_t min_capacity)
+{
+    if(!a) return EINVAL;
+
+    assert(array_invariant_validation(a) == 0);
+
+    if(min_capacity <= a->capacity) return 0; // enough capacity
+
+    size_t new_capacity;
+    int error = array_next_capacity(a->policy, a->capacity, min_capacity,
+        &new_capacity);
+    if(error) return error;
+
+    return array_resize_storage(a, new_capacity);
+}
+
+/*
+@brief:
+Ensure room for at least capacity elements without rounding up by the
+growth policy.
+
+@post:
+    On success:
+        - return 0
+        - array_capacity(a) >= capacity
+        - array_capacity(a) == capacity if the array had to grow
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
+int
+array_reserve_exact(Array *a, size_t capacity)
+{
+    if(!a) return EINVAL;
+
+    assert(array_invariant_validation(a) == 0);
+
+    if(capacity <= a->capacity) return 0;
+
+    return array_resize_storage(a, capacity);
+}
+
+/*
+@brief:
+Release unused capacity.
+
+@note:
+Elements move back into the inline buffer when they fit, otherwise the
+heap block is reallocated to exactly array_size(a) elements.
+
+@post:
+    On success:
+        - return 0
+        - array_capacity(a) == array_size(a), or the inline capacity
+*/
+int
+array_shrink_fit(Array *a)
+{
+    if(!a) return EINVAL;
+
+    if(a->capacity == a->size) return 0; // enough memory
+
+    return array_resize_storage(a, a->size);
+}
+
+/*
+@brief:
+Shrink with hysteresis after elements were removed.
+
+@note:
+When the policy sets shrink_divisor, capacity is halved while
+size < capacity / shrink_divisor. The result keeps at least
+shrink_divisor / 2 times the live size, so a following push does not
+regrow immediately. Failure to shrink is not an error.
+*/
+static void
+array_auto_shrink(Array *a)
+{
+    size_t divisor = a->policy->shrink_divisor;
+    if(!divisor) return;
+
+    size_t floor = a->inline_capacity > ARR_INIT_CAP ? a->inline_capacity
+                                                     : ARR_INIT_CAP;
+
+    size_t target = a->capacity;
+    while(target / 2 >= floor && a->size < target / divisor) target /= 2;
+
+    if(target == a->capacity) return;
+
+    (void)array_resize_storage(a, target);
+}
+
+/*
+@brief:
+Select how the array grows and whether it shrinks automatically.
+
+@pre:
+    - a != NULL
+    - policy == NULL restores the default policy (x2, never shrink)
+    - policy outlives the array or the next call to this function
+    - without a callback: factor_numerator > factor_denominator > 0
+    - linear_threshold != 0 requires linear_step > 0
+    - shrink_divisor is 0 (disabled) or >= 2
+    - incremental_step is 0 (one-shot copy on growth) or the number of
+      elements each array_push_back() moves out of the previous buffer
+      of a heap array; to drain before the next growth it needs
+      incremental_step * (factor - 1) >= 1, otherwise that growth
+      copies the rest at once
+
+@post:
+    On success:
+        - return 0
+        - later growth and shrinking follow policy
+        - a pending incremental migration is finished when policy does
+          not grow incrementally
+
+    On failure:
+        - return EINVAL
+        - a is unchanged
+*/
+int
+array_set_growth_policy(Array *a, const ArrayGrowthPolicy *policy)
+{
+    if(!a) return EINVAL;
+
+    if(!policy)
+    {
+        array_settle(a);
+        a->policy = &ARR_DEFAULT_POLICY;
+        return 0;
+    }
+
+    if(!policy->callback)
+    {
+        if(policy->factor_denominator == 0) return EINVAL;
+        if(policy->factor_numerator <= policy->factor_denominator)
+        {
+            return EINVAL;
+        }
     }
 
-    size_t new_bytes;
-    if(mul_safe(new_capacity, a->element_size, &new_bytes)) return EOVERFLOW;
+    if(policy->linear_threshold && !policy->linear_step) return EINVAL;
+    if(policy->shrink_divisor == 1) return EINVAL;
 
-    void *tmp = realloc(a->data, new_bytes);
-    if(!tmp) return ENOMEM;
+    if(!policy->incremental_step) array_settle(a);
+
+    a->policy = policy;
+
+    return 0;
+}
+
+int
+array_size_safe_increment(Array *a)
+{
+    size_t new_size;
+    if(add_safe(a->size, 1, &new_size)) return EOVERFLOW;
+
+    a->size = new_size;
+    array_stats_size(a);
+
+    return 0;
+}
+
+int
+array_size_safe_decrement(Array *a)
+{
+    size_t new_size;
+    if(sub_safe(a->size, 1, &new_size)) return EOVERFLOW;
+
+    a->size = new_size;
+
+    return 0;
+}
+
+static inline int
+do_insert(Array *restrict a, const void *restrict value, size_t index)
+{
+    size_t insert_offset;
+    if(mul_safe(index, a->element_size, &insert_offset)) return EOVERFLOW;
+
+    size_t tail_bytes;
+    size_t tail_count = (a->size - index);
+    if(mul_safe(tail_count, a->element_size, &tail_bytes)) return EOVERFLOW;
+
+    char *base = (char *)a->data;
+
+    void *dst = base + insert_offset + a->element_size;
+    void *src = base + insert_offset;
+
+    memmove(dst, src, tail_bytes);
+    array_stats_moved(a, tail_bytes);
+
+    memcpy(src, value, a->element_size);
+
+    return 0;
+}
+
+int
+array_insert(Array *restrict a, const void *restrict value, size_t index)
+{
+    if(!a || !value || (index > a->size)) return EINVAL;
+
+    array_settle(a);
+
+    int error; // contain error code return from function.
+
+    error = array_reserve(a, a->size + 1);
+    if(error) return error;
+
+    error = do_insert(a, value, index);
+    if(error) return error;
+
+    error = array_size_safe_increment(a);
+    if(error) return error;
+
+    return 0;
+}
+
+static inline int
+do_erase(Array *a, size_t index)
+{
+    size_t tail;
+    if(sub_safe(a->size, (index + 1), &tail)) return EOVERFLOW;
+
+    if(tail > 0)
+    {
+        size_t bytes;
+        if(mul_safe(tail, a->element_size, &bytes)) return EOVERFLOW;
+
+        size_t dst_off;
+        if(mul_safe(index, a->element_size, &dst_off)) return EOVERFLOW;
+
+        size_t src_off;
+        if(mul_safe((index + 1), a->element_size, &src_off)) return EOVERFLOW;
+
+        char *base = (char *)a->data;
+
+        void *dst = base + dst_off;
+        void *src = base + src_off;
+
+        memmove(dst, src, bytes);
+        array_stats_moved(a, bytes);
+    }
+
+    return 0;
+}
+
+int
+array_erase(Array *a, size_t index)
+{
+    if(!a || (index >= a->size)) return EINVAL;
+
+    array_settle(a);
+
+    int error; // contain error code return from function.
+
+    error = do_erase(a, index);
+    if(error) return error;
+
+    error = array_size_safe_decrement(a);
+    if(error) return error;
+
+    array_auto_shrink(a);
+
+    return 0;
+}
+
+int
+do_push_front(Array *restrict a, const void *restrict value)
+{
+    size_t bytes;
+    if(mul_safe(a->size, a->element_size, &bytes)) return EOVERFLOW;
+
+    char *base = (char *)a->data;
+
+    void *dst = base + a->element_size;
+
+    memmove(dst, base, bytes);
+    array_stats_moved(a, bytes);
+    memcpy(base, value, a->element_size);
+
+    return 0;
+}
+
+int
+array_push_front(Array *restrict a, const void *restrict value)
+{
+    if(!a || !value) return EINVAL;
+
+    array_settle(a);
+
+    int error; // contain error code return from function.
+
+    error = array_reserve(a, a->size + 1);
+    if(error) return error;
+
+    error = do_push_front(a, value);
+    if(error) return error;
+
+    error = array_size_safe_increment(a);
+    if(error) return error;
+
+    return 0;
+}
+
+static inline int
+do_push_back(Array *a, const void *value)
+{
+    size_t dst_offset;
+    if(mul_safe(a->size, a->element_size, &dst_offset)) return EOVERFLOW;
 
-    a->data = tmp;
-    a->capacity = new_capacity;
+    char *base = (char *)a->data;
+    void *dst = base + dst_offset;
+    memcpy(dst, value, a->element_size);
 
     return 0;
 }
 
-static inline int
-array_shrink_fit(Array *a)
+int
+array_push_back(Array *a, const void *value)
 {
-    if(!a) return EINVAL;
+    if(!a || !value) return EINVAL;
 
-    if(a->capacity == a->size) return 0; // enough memory
+    int error;
 
-    if(a->size == 0)
-    {
-        free(a->data);
+    error = array_reserve(a, a->size + 1);
+    if(error) return error;
 
-        a->data = NULL;
-        a->capacity = 0;
+    error = do_push_back(a, value);
+    if(error) return error;
 
-        return 0;
-    }
+    error = array_size_safe_increment(a);
+    if(error) return error;
 
-    size_t _bytes;
-    if(mul_safe(a->size, a->element_size, &_bytes)) return EOVERFLOW;
+    if(a->old_data) array_migrate(a, a->policy->incremental_step);
 
-    void *tmp = realloc(a->data, _bytes);
-    if(!tmp) return ENOMEM;
+    return 0;
+}
 
-    a->data = tmp;
-    a->capacity = a->size;
+/*
+@brief:
+Append count elements stored contiguously at values.
 
-    return 0;
+@note:
+Storage grows at most once; elements are copied with a single memcpy.
+
+@pre:
+    - a != NULL
+    - values != NULL when count > 0
+    - values does not point into the storage of a
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) increased by count
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
+int
+array_push_back_n(Array *restrict a, const void *restrict values,
+    size_t count)
+{
+    return array_insert_range(a, values, count, a ? a->size : 0);
 }
 
+/*
+@brief:
+Append count uninitialized elements and return a pointer to the first.
+
+@note:
+Lets producers such as array_read_fd() write straight into the reserved
+tail of the storage. Storage grows at most once. The caller must fill all
+count elements (or erase them) before they are read.
+
+@pre:
+    - a != NULL
+    - out != NULL
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) increased by count
+        - *out points to the first new element (NULL when count == 0)
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
 int
-array_size_safe_increment(Array *a)
+array_push_back_uninit(Array *a, size_t count, void **out)
 {
+    if(!a || !out) return EINVAL;
+
+    *out = NULL;
+
+    if(count == 0) return 0;
+
     size_t new_size;
-    if(add_safe(a->size, 1, &new_size)) return EOVERFLOW;
+    if(add_safe(a->size, count, &new_size)) return EOVERFLOW;
+
+    // the caller gets one contiguous run
+    array_settle(a);
+
+    int error = array_reserve(a, new_size);
+    if(error) return error;
 
+    *out = (char *)a->data + a->size * a->element_size;
     a->size = new_size;
+    array_stats_size(a);
 
     return 0;
 }
 
+/*
+@brief:
+Insert count elements stored contiguously at values before index.
+
+@note:
+Storage grows at most once and the tail is moved by a single memmove, so
+the cost is O(size + count) instead of O(size * count).
+
+@pre:
+    - a != NULL
+    - values != NULL when count > 0
+    - index <= array_size(a)
+    - values does not point into the storage of a
+
+@post:
+    On success:
+        - return 0
+        - elements [index, index + count) equal values
+        - former elements [index, size) now start at index + count
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
 int
-array_size_safe_decrement(Array *a)
+array_insert_range(Array *restrict a, const void *restrict values,
+    size_t count, size_t index)
 {
+    if(!a || (!values && count) || (index > a->size)) return EINVAL;
+
+    if(count == 0) return 0;
+
+    array_settle(a);
+
     size_t new_size;
-    if(sub_safe(a->size, 1, &new_size)) return EOVERFLOW;
+    if(add_safe(a->size, count, &new_size)) return EOVERFLOW;
+
+    size_t insert_offset;
+    if(mul_safe(index, a->element_size, &insert_offset)) return EOVERFLOW;
+
+    size_t insert_bytes;
+    if(mul_safe(count, a->element_size, &insert_bytes)) return EOVERFLOW;
+
+    size_t tail_bytes;
+    if(mul_safe(a->size - index, a->element_size, &tail_bytes))
+    {
+        return EOVERFLOW;
+    }
+
+    int error = array_reserve(a, new_size);
+    if(error) return error;
+
+    char *base = (char *)a->data;
+
+    if(tail_bytes)
+    {
+        memmove(base + insert_offset + insert_bytes, base + insert_offset,
+            tail_bytes);
+        array_stats_moved(a, tail_bytes);
+    }
+
+    memcpy(base + insert_offset, values, insert_bytes);
 
     a->size = new_size;
+    array_stats_size(a);
 
     return 0;
 }
 
-static inline int
-do_insert(Array *restrict a, const void *restrict value, size_t index)
+/*
+@brief:
+Remove the elements [index, index + count).
+
+@note:
+The tail is moved by a single memmove. Capacity is unchanged.
+
+@pre:
+    - a != NULL
+    - index + count <= array_size(a)
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) decreased by count
+
+    On failure:
+        - return EINVAL
+        - a is unchanged
+*/
+int
+array_erase_range(Array *a, size_t index, size_t count)
 {
-    size_t insert_offset;
-    if(mul_safe(index, a->element_size, &insert_offset)) return EOVERFLOW;
+    if(!a || (index > a->size) || (count > a->size - index)) return EINVAL;
 
-    size_t tail_bytes;
-    size_t tail_count = (a->size - index);
-    if(mul_safe(tail_count, a->element_size, &tail_bytes)) return EOVERFLOW;
+    if(count == 0) return 0;
 
-    char *base = (char *)a->data;
+    array_settle(a);
 
-    void *dst = base + insert_offset + a->element_size;
-    void *src = base + insert_offset;
+    size_t tail_count = a->size - index - count;
 
-    memmove(dst, src, tail_bytes);
+    if(tail_count)
+    {
+        char *base = (char *)a->data;
 
-    memcpy(src, value, a->element_size);
+        memmove(base + index * a->element_size,
+            base + (index + count) * a->element_size,
+            tail_count * a->element_size);
+        array_stats_moved(a, tail_count * a->element_size);
+    }
+
+    a->size -= count;
+
+    array_auto_shrink(a);
 
     return 0;
 }
 
+/*
+@brief:
+Replace the whole contents of the array with count elements from values.
+
+@pre:
+    - a != NULL
+    - values != NULL when count > 0
+    - values does not point into the storage of a
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) == count
+
+    On failure:
+        - return error code
+        - a is unchanged
+*/
 int
-array_insert(Array *restrict a, const void *restrict value, size_t index)
+array_assign(Array *restrict a, const void *restrict values, size_t count)
 {
-    if(!a || !value || (index > a->size)) return EINVAL;
+    if(!a || (!values && count)) return EINVAL;
 
-    int error; // contain error code return from function.
+    size_t bytes;
+    if(mul_safe(count, a->element_size, &bytes)) return EOVERFLOW;
 
-    error = array_reserve(a, a->size + 1);
-    if(error) return error;
+    array_settle(a);
 
-    error = do_insert(a, value, index);
+    int error = array_reserve(a, count);
     if(error) return error;
 
-    error = array_size_safe_increment(a);
+    if(bytes) memcpy(a->data, values, bytes);
+
+    a->size = count;
+    array_stats_size(a);
+
+    return 0;
+}
+
+/*
+@brief:
+Append every element of src to dst.
+
+@pre:
+    - dst != NULL
+    - src != NULL
+    - dst and src have the same element size
+    - dst may be the same object as src
+
+@post:
+    On success:
+        - return 0
+        - array_size(dst) increased by the former array_size(src)
+
+    On failure:
+        - return error code
+        - dst is unchanged
+*/
+int
+array_append_array(Array *dst, const Array *src)
+{
+    if(!dst || !src) return EINVAL;
+    if(dst->element_size != src->element_size) return EINVAL;
+
+    size_t count = src->size;
+    if(count == 0) return 0;
+
+    size_t new_size;
+    if(add_safe(dst->size, count, &new_size)) return EOVERFLOW;
+
+    // settling dst also settles src when they are the same array
+    array_settle(dst);
+
+    int error = array_reserve(dst, new_size);
     if(error) return error;
 
+    // reserve may have moved src->data when dst == src
+    char *base = (char *)dst->data;
+
+    array_copy_out(src, 0, count, base + dst->size * dst->element_size);
+
+    dst->size = new_size;
+    array_stats_size(dst);
+
     return 0;
 }
 
-static inline int
-do_erase(Array *a, size_t index)
+/*
+@brief:
+Move the original elements [begin, end) to start at dest.
+*/
+static void
+array_batch_move(Array *a, size_t begin, size_t end, size_t dest)
 {
-    size_t tail;
-    if(sub_safe(a->size, (index + 1), &tail)) return EOVERFLOW;
+    if(begin == end || begin == dest) return;
 
-    if(tail > 0)
+    size_t bytes = (end - begin) * a->element_size;
+    char *base = (char *)a->data;
+
+    memmove(base + dest * a->element_size, base + begin * a->element_size,
+        bytes);
+    array_stats_moved(a, bytes);
+}
+
+/*
+@brief:
+Apply count inserts and erases in one pass over the array.
+
+@note:
+Every index refers to the array as it was before the call. Edits must be
+sorted by index; at the same index, inserts land before the original
+element in the order they are listed, and at most one erase removes that
+original element. Storage is reserved once for the final size.
+
+The original elements between two edit indices form a segment that moves
+by a fixed shift. Segments moving left are moved front to back, those
+moving right back to front, and inserted values are written last, so no
+element is overwritten before it moved and each moves at most once:
+O(size + count) in total instead of count tail memmoves.
+
+@pre:
+    - a != NULL
+    - edits != NULL when count > 0
+    - insert indices <= array_size(a), erase indices < array_size(a)
+    - insert values != NULL and do not point into the storage of a
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) == former size + inserts - erases
+
+    On failure:
+        - return EINVAL (unsorted, out of range, duplicate erase) or an
+          error of array_reserve()
+        - a is unchanged
+*/
+int
+array_apply_batch(Array *restrict a, const ArrayEdit *restrict edits,
+    size_t count)
+{
+    if(!a || (!edits && count)) return EINVAL;
+
+    size_t inserts = 0;
+    size_t erases = 0;
+
+    for(size_t e = 0; e < count; ++e)
     {
-        size_t bytes;
-        if(mul_safe(tail, a->element_size, &bytes)) return EOVERFLOW;
+        const ArrayEdit *edit = &edits[e];
 
-        size_t dst_off;
-        if(mul_safe(index, a->element_size, &dst_off)) return EOVERFLOW;
+        if(e && edit->index < edits[e - 1].index) return EINVAL;
 
-        size_t src_off;
-        if(mul_safe((index + 1), a->element_size, &src_off)) return EOVERFLOW;
+        if(edit->op == ARRAY_EDIT_INSERT)
+        {
+            if(edit->index > a->size || !edit->value) return EINVAL;
+            ++inserts;
+        }
+        else if(edit->op == ARRAY_EDIT_ERASE)
+        {
+            if(edit->index >= a->size) return EINVAL;
+
+            // at most one erase per original element
+            for(size_t p = e; p > 0 && edits[p - 1].index == edit->index; --p)
+            {
+                if(edits[p - 1].op == ARRAY_EDIT_ERASE) return EINVAL;
+            }
+
+            ++erases;
+        }
+        else
+        {
+            return EINVAL;
+        }
+    }
+
+    if(count == 0) return 0;
+
+    array_settle(a);
+
+    size_t new_size;
+    if(add_safe(a->size - erases, inserts, &new_size)) return EOVERFLOW;
+
+    int error = array_reserve(a, new_size);
+    if(error) return error;
+
+    // segments shifting left, front to back
+    size_t ins = 0;
+    size_t er = 0;
+
+    for(size_t e = 0; e < count;)
+    {
+        size_t index = edits[e].index;
+        size_t erased = 0;
+
+        for(; e < count && edits[e].index == index; ++e)
+        {
+            if(edits[e].op == ARRAY_EDIT_INSERT) ++ins;
+            else erased = 1;
+        }
+        er += erased;
+
+        size_t begin = index + erased;
+        size_t end = e < count ? edits[e].index : a->size;
+
+        if(ins < er) array_batch_move(a, begin, end, begin + ins - er);
+    }
+
+    // segments shifting right, back to front
+    for(size_t e = count; e > 0;)
+    {
+        size_t index = edits[e - 1].index;
+        size_t end = e < count ? edits[e].index : a->size;
+        size_t group_ins = 0;
+        size_t erased = 0;
+
+        for(; e > 0 && edits[e - 1].index == index; --e)
+        {
+            if(edits[e - 1].op == ARRAY_EDIT_INSERT) ++group_ins;
+            else erased = 1;
+        }
+
+        size_t begin = index + erased;
+
+        if(ins > er) array_batch_move(a, begin, end, begin + ins - er);
+
+        ins -= group_ins;
+        er -= erased;
+    }
+
+    // inserted values go into the gaps the moves left
+    char *base = (char *)a->data;
+    size_t group_er = 0;
 
-        char *base = (char *)a->data;
+    for(size_t e = 0; e < count; ++e)
+    {
+        const ArrayEdit *edit = &edits[e];
 
-        void *dst = base + dst_off;
-        void *src = base + src_off;
+        if(e && edit->index != edits[e - 1].index) group_er = er;
 
-        memmove(dst, src, bytes);
+        if(edit->op == ARRAY_EDIT_INSERT)
+        {
+            size_t dest = edit->index + ins - group_er;
+            memcpy(base + dest * a->element_size, edit->value,
+                a->element_size);
+            ++ins;
+        }
+        else
+        {
+            ++er;
+        }
     }
 
+    a->size = new_size;
+    array_stats_size(a);
+
+    array_auto_shrink(a);
+
     return 0;
 }
 
-int
-array_erase(Array *a, size_t index)
+/*
+@brief:
+Stable single-pass compaction: keep exactly the elements for which
+pred(element, context) == keep.
+
+@note:
+Runs of kept elements are moved with one memmove each, so the total cost
+is O(size) predicate calls and at most size element copies.
+*/
+static int
+array_filter(Array *a, ArrayPredicate pred, void *context, bool keep)
 {
-    if(!a || (index >= a->size)) return EINVAL;
+    if(!a || !pred) return EINVAL;
 
-    int error; // contain error code return from function.
+    array_settle(a);
 
-    error = do_erase(a, index);
-    if(error) return error;
+    size_t element_size = a->element_size;
+    char *base = (char *)a->data;
 
-    error = array_size_safe_decrement(a);
-    if(error) return error;
+    size_t write = 0; // next slot for a kept element
+    size_t run = 0;   // first element of the pending run of kept elements
 
-    return 0;
-}
+    for(size_t read = 0; read <= a->size; ++read)
+    {
+        if(read < a->size && pred(base + read * element_size, context) == keep)
+        {
+            continue;
+        }
 
-int
-do_push_front(Array *restrict a, const void *restrict value)
-{
-    size_t bytes;
-    if(mul_safe(a->size, a->element_size, &bytes)) return EOVERFLOW;
+        // element read is removed (or the end is reached): move the run
+        size_t count = read - run;
+        if(count && write != run)
+        {
+            memmove(base + write * element_size, base + run * element_size,
+                count * element_size);
+            array_stats_moved(a, count * element_size);
+        }
 
-    char *base = (char *)a->data;
+        write += count;
+        run = read + 1;
+    }
 
-    void *dst = base + a->element_size;
+    if(write == a->size) return 0;
 
-    memmove(dst, base, bytes);
-    memcpy(base, value, a->element_size);
+    a->size = write;
+
+    array_auto_shrink(a);
 
     return 0;
 }
 
-int
-array_push_front(Array *restrict a, const void *restrict value)
-{
-    if(!a || !value) return EINVAL;
+/*
+@brief:
+Remove every element for which pred(element, context) returns true.
 
-    int error; // contain error code return from function.
+@note:
+Order of the remaining elements is preserved. One linear pass instead of
+an O(size) memmove per removed element as with repeated array_erase().
+pred must not modify the array.
 
-    error = array_reserve(a, a->size + 1);
-    if(error) return error;
+@post:
+    On success:
+        - return 0
+        - no remaining element satisfies pred
 
-    error = do_push_front(a, value);
-    if(error) return error;
+    On failure:
+        - return EINVAL
+        - a is unchanged
+*/
+int
+array_remove_if(Array *a, ArrayPredicate pred, void *context)
+{
+    return array_filter(a, pred, context, false);
+}
 
-    error = array_size_safe_increment(a);
-    if(error) return error;
+/*
+@brief:
+Keep only the elements for which pred(element, context) returns true.
 
-    return 0;
+@note:
+Complement of array_remove_if(); same guarantees.
+*/
+int
+array_retain(Array *a, ArrayPredicate pred, void *context)
+{
+    return array_filter(a, pred, context, true);
 }
 
-static inline int
-do_push_back(Array *a, const void *value)
-{
-    size_t dst_offset;
-    if(mul_safe(a->size, a->element_size, &dst_offset)) return EOVERFLOW;
+/*
+@brief:
+Remove the element at index in O(1) by moving the last element into its
+place.
 
-    char *base = (char *)a->data;
-    void *dst = base + dst_offset;
-    memcpy(dst, value, a->element_size);
+@note:
+Does not preserve order.
 
-    return 0;
-}
+@post:
+    On success:
+        - return 0
+        - array_size(a) decreased by one
 
+    On failure:
+        - return EINVAL
+        - a is unchanged
+*/
 int
-array_push_back(Array *a, const void *value)
+array_swap_remove(Array *a, size_t index)
 {
-    if(!a || !value) return EINVAL;
+    if(!a || (index >= a->size)) return EINVAL;
 
-    int error;
+    size_t last = a->size - 1;
 
-    error = array_reserve(a, a->size + 1);
-    if(error) return error;
+    if(index != last)
+    {
+        memcpy(array_slot(a, index), array_slot(a, last), a->element_size);
+    }
 
-    error = do_push_back(a, value);
-    if(error) return error;
+    a->size = last;
+    array_drop_migrated_tail(a);
 
-    error = array_size_safe_increment(a);
-    if(error) return error;
+    array_auto_shrink(a);
 
     return 0;
 }
@@ -656,38 +2444,42 @@ array_push_back(Array *a, const void *value)
 void
 array_pop_front(Array *a)
 {
-    if(!a) return;
+    if(!a || a->size == 0) return;
 
     int error;
 
     size_t _bytes;
     if(mul_safe((a->size - 1), a->element_size, &_bytes)) return;
 
+    array_settle(a);
+
     char *base = (char *)a->data;
     void *dst = base;
     void *src = base + a->element_size;
     memmove(dst, src, _bytes);
+    array_stats_moved(a, _bytes);
 
     error = array_size_safe_decrement(a);
     if(error) return;
+    array_auto_shrink(a);
 }
 
 void
 array_pop_back(Array *a)
 {
-    if(!a) return;
+    if(!a || a->size == 0) return;
 
     int error;
 
     size_t bytes;
-    if(mul_safe(a->size, a->element_size, &bytes)) return;
+    if(mul_safe(a->size - 1, a->element_size, &bytes)) return;
 
-    char *base = (char *)a->data;
-    void *dst = base + bytes;
-    memset(dst, 0, a->element_size);
+    memset(array_slot(a, a->size - 1), 0, a->element_size);
 
     error = array_size_safe_decrement(a);
     if(error) return;
+    array_drop_migrated_tail(a);
+    array_auto_shrink(a);
 }
 
 int
@@ -696,9 +2488,7 @@ array_get(const Array *a, size_t index, void *value)
     if(!a || !value) return EINVAL;
     if(index >= a->size) return EINVAL;
 
-    const char *base = (const char *)a->data;
-
-    memcpy(value, base + index * a->element_size, a->element_size);
+    memcpy(value, array_slot(a, index), a->element_size);
 
     return 0;
 }
@@ -709,15 +2499,184 @@ array_set(Array *a, size_t index, const void *value)
     if(!a || !value) return EINVAL;
     if(index >= a->size) return EINVAL;
 
-    char *base = (char *)a->data;
+    memcpy(array_slot(a, index), value, a->element_size);
 
-    void *dst = base + index * a->element_size;
+    return 0;
+}
 
-    memcpy(dst, value, a->element_size);
+/*
+@brief:
+Return a pointer to the element at index without copying it.
+
+@note:
+The pointer is invalidated by any operation that may reallocate or move
+elements (insert, erase, push, reserve, ...).
+
+@post:
+    - return == NULL if a == NULL or index >= array_size(a)
+    - otherwise return points to element index inside the array storage
+*/
+void *
+array_at(Array *a, size_t index)
+{
+    if(!a || index >= a->size) return NULL;
+
+    return array_slot(a, index);
+}
+
+const void *
+array_at_const(const Array *a, size_t index)
+{
+    if(!a || index >= a->size) return NULL;
+
+    return array_slot(a, index);
+}
+
+/*
+@brief:
+Return the contiguous element storage.
+
+@note:
+array_size(a) elements of array_element_size(a) bytes each are valid.
+The pointer may be NULL when the array owns no storage.
+*/
+void *
+array_data(Array *a)
+{
+    if(!a) return NULL;
+
+    array_settle(a);
+
+    return a->data;
+}
+
+/*
+@note:
+Never moves elements, so concurrent readers of a shared const Array stay
+safe. While an incremental growth is still moving elements there is no
+contiguous storage and the result is NULL; array_data() finishes the
+move first.
+*/
+const void *
+array_data_const(const Array *a)
+{
+    if(!a || a->old_data) return NULL;
+
+    return a->data;
+}
+
+/*
+@brief:
+Return a non-owning view over every element of the array.
+
+@note:
+The span does not keep the array alive and is invalidated like array_at().
+
+@post:
+    - return.len == array_size(a)
+    - return.elem_size == array_element_size(a)
+    - return == {NULL, 0, 0} if a == NULL
+*/
+ArraySpan
+array_span(Array *a)
+{
+    ArraySpan span = {NULL, 0, 0};
+
+    if(!a) return span;
+
+    array_settle(a);
+
+    span.ptr = a->data;
+    span.len = a->size;
+    span.elem_size = a->element_size;
+
+    return span;
+}
+
+/*
+@brief:
+Narrow a span to elements [offset, offset + count).
+
+@post:
+    On success:
+        - return 0
+        - out->ptr points to element offset of span
+        - out->len == count
+
+    On failure:
+        - return EINVAL
+        - *out is unchanged
+*/
+int
+array_span_subspan(ArraySpan span, size_t offset, size_t count,
+    ArraySpan *out)
+{
+    if(!out) return EINVAL;
+    if(offset > span.len || count > span.len - offset) return EINVAL;
+
+    out->ptr = span.len ? (char *)span.ptr + offset * span.elem_size : NULL;
+    out->len = count;
+    out->elem_size = span.elem_size;
 
     return 0;
 }
 
+void *
+array_span_at(ArraySpan span, size_t index)
+{
+    if(index >= span.len) return NULL;
+
+    return (char *)span.ptr + index * span.elem_size;
+}
+
+/*
+@brief:
+Position a forward iterator on the first element of the array.
+
+@note:
+    ArrayIterator it;
+    array_iter_init(&it, a);
+    for(T *p; (p = array_iter_next(&it));) { ... }
+
+@pre:
+    - it != NULL
+    - array may be NULL (iterates nothing)
+*/
+void
+array_iter_init(ArrayIterator *it, Array *a)
+{
+    if(!it) return;
+
+    if(!a || a->size == 0)
+    {
+        it->current = NULL;
+        it->end = NULL;
+        it->step = 0;
+        return;
+    }
+
+    array_settle(a);
+
+    it->current = (char *)a->data;
+    it->end = it->current + a->size * a->element_size;
+    it->step = a->element_size;
+}
+
+/*
+@brief:
+Return the current element and advance, or NULL when exhausted.
+*/
+void *
+array_iter_next(ArrayIterator *it)
+{
+    if(!it || it->current == it->end) return NULL;
+
+    void *element = it->current;
+    it->current += it->step;
+
+    return element;
+}
+
 size_t
 array_size(const Array *a)
 {
@@ -729,3 +2688,136 @@ array_capacity(const Array *a)
 {
     return a ? a->capacity : 0;
 }
+
+size_t
+array_element_size(const Array *a)
+{
+    return a ? a->element_size : 0;
+}
+
+/*
+@note:
+Allocator for temporary buffers that belong with the array, e.g. sort
+scratch space.
+*/
+const Allocator *
+array_allocator(const Array *a)
+{
+    return a ? a->allocator : NULL;
+}
+
+/*
+@brief:
+Copy the instrumentation counters of a, or the process-wide totals when
+a == NULL.
+
+@note:
+Peaks are in elements; the global peaks are the largest values reached
+by any single array. Counters exist only in builds with -DARRAY_STATS.
+
+@post:
+    On success:
+        - return 0
+        - *out holds the counters
+
+    On failure:
+        - return EINVAL, or ENOTSUP when built without ARRAY_STATS
+*/
+int
+array_stats_get(const Array *a, ArrayStats *out)
+{
+    if(!out) return EINVAL;
+
+#ifdef ARRAY_STATS
+    if(a)
+    {
+        *out = a->stats;
+        return 0;
+    }
+
+    out->reallocations = atomic_load_explicit(
+        &array_stats_global.reallocations, memory_order_relaxed);
+    out->bytes_moved = atomic_load_explicit(&array_stats_global.bytes_moved,
+        memory_order_relaxed);
+    out->bytes_allocated = atomic_load_explicit(
+        &array_stats_global.bytes_allocated, memory_order_relaxed);
+    out->bytes_freed = atomic_load_explicit(&array_stats_global.bytes_freed,
+        memory_order_relaxed);
+    out->peak_capacity = atomic_load_explicit(
+        &array_stats_global.peak_capacity, memory_order_relaxed);
+    out->peak_size = atomic_load_explicit(&array_stats_global.peak_size,
+        memory_order_relaxed);
+
+    return 0;
+#else
+    (void)a;
+    return ENOTSUP;
+#endif
+}
+
+/*
+@brief:
+Zero the counters of a, or the process-wide totals when a == NULL.
+
+@note:
+Peaks restart from the current capacity and size of a.
+*/
+void
+array_stats_reset(Array *a)
+{
+#ifdef ARRAY_STATS
+    if(a)
+    {
+        array_stats_init(a);
+        return;
+    }
+
+    atomic_store_explicit(&array_stats_global.reallocations, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&array_stats_global.bytes_moved, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&array_stats_global.bytes_allocated, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&array_stats_global.bytes_freed, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&array_stats_global.peak_capacity, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&array_stats_global.peak_size, 0,
+        memory_order_relaxed);
+#else
+    (void)a;
+#endif
+}
+
+/*
+@brief:
+Print the counters of a (or the global totals when a == NULL) to out,
+one "name value" pair per line.
+*/
+void
+array_stats_dump(const Array *a, FILE *out)
+{
+    if(!out) return;
+
+    ArrayStats stats;
+    if(array_stats_get(a, &stats))
+    {
+        fprintf(out, "array stats: disabled (build with -DARRAY_STATS)\n");
+        return;
+    }
+
+    fprintf(out,
+        "array stats (%s):\n"
+        "  reallocations   %llu\n"
+        "  bytes_moved     %llu\n"
+        "  bytes_allocated %llu\n"
+        "  bytes_freed     %llu\n"
+        "  peak_capacity   %llu\n"
+        "  peak_size       %llu\n",
+        a ? "array" : "global", (unsigned long long)stats.reallocations,
+        (unsigned long long)stats.bytes_moved,
+        (unsigned long long)stats.bytes_allocated,
+        (unsigned long long)stats.bytes_freed,
+        (unsigned long long)stats.peak_capacity,
+        (unsigned long long)stats.peak_size);
+}
@@ -0,0 +1,847 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/array_io.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/*
+Stream format, all fields in host byte order:
+
+    header    ArrayStreamHeader (32 bytes)
+    payload   count * element_size bytes, elements in index order
+    trailer   uint64_t checksum of the payload, only with ARRAY_IO_CHECKSUM
+
+A reader never consumes bytes past the trailer, so several arrays can be
+stored back to back in one file, pipe or socket.
+*/
+#define ARRAY_STREAM_MAGIC "ADSARRIO"
+
+enum
+{
+    ARRAY_STREAM_VERSION = 1,
+    ARRAY_IO_BUFFER_SIZE = 64 * 1024,
+    ARRAY_IO_READ_BATCH = 16 * ARRAY_IO_BUFFER_SIZE,
+};
+
+typedef struct ArrayStreamHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t element_size;
+    uint64_t count;
+} ArrayStreamHeader;
+
+static_assert(sizeof(ArrayStreamHeader) == 32,
+    "ArrayStreamHeader must stay 32 bytes");
+
+/*
+Payload checksum: four independent multiply-rotate lanes over 32-byte
+stripes (the XXH64 round function), folded with the byte count and the
+last partial stripe at the end. Not bit-compatible with XXH64.
+*/
+typedef struct ArrayChecksum
+{
+    uint64_t lanes[4];
+    uint64_t total;
+    unsigned char stripe[32];
+    size_t stripe_used;
+} ArrayChecksum;
+
+static const uint64_t ARRAY_CHECKSUM_PRIME_1 = 0x9E3779B185EBCA87u;
+static const uint64_t ARRAY_CHECKSUM_PRIME_2 = 0xC2B2AE3D27D4EB4Fu;
+static const uint64_t ARRAY_CHECKSUM_PRIME_3 = 0x165667B19E3779F9u;
+
+static inline uint64_t
+array_checksum_rotl(uint64_t x, unsigned r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+array_checksum_round(uint64_t lane, uint64_t input)
+{
+    lane += input * ARRAY_CHECKSUM_PRIME_2;
+    lane = array_checksum_rotl(lane, 31);
+    return lane * ARRAY_CHECKSUM_PRIME_1;
+}
+
+static void
+array_checksum_init(ArrayChecksum *c)
+{
+    c->lanes[0] = ARRAY_CHECKSUM_PRIME_1 + ARRAY_CHECKSUM_PRIME_2;
+    c->lanes[1] = ARRAY_CHECKSUM_PRIME_2;
+    c->lanes[2] = 0;
+    c->lanes[3] = 0 - ARRAY_CHECKSUM_PRIME_1;
+    c->total = 0;
+    c->stripe_used = 0;
+}
+
+static void
+array_checksum_stripe(ArrayChecksum *c, const unsigned char *stripe)
+{
+    for(size_t i = 0; i < 4; ++i)
+    {
+        uint64_t word;
+        memcpy(&word, stripe + 8 * i, sizeof(word));
+        c->lanes[i] = array_checksum_round(c->lanes[i], word);
+    }
+}
+
+static void
+array_checksum_update(ArrayChecksum *c, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+
+    c->total += size;
+
+    if(c->stripe_used)
+    {
+        size_t take = sizeof(c->stripe) - c->stripe_used;
+        if(take > size) take = size;
+
+        memcpy(c->stripe + c->stripe_used, p, take);
+        c->stripe_used += take;
+        p += take;
+        size -= take;
+
+        if(c->stripe_used < sizeof(c->stripe)) return;
+
+        array_checksum_stripe(c, c->stripe);
+        c->stripe_used = 0;
+    }
+
+    for(; size >= sizeof(c->stripe); p += sizeof(c->stripe))
+    {
+        array_checksum_stripe(c, p);
+        size -= sizeof(c->stripe);
+    }
+
+    if(size) memcpy(c->stripe, p, size);
+    c->stripe_used = size;
+}
+
+static uint64_t
+array_checksum_final(const ArrayChecksum *c)
+{
+    uint64_t h = array_checksum_rotl(c->lanes[0], 1) +
+        array_checksum_rotl(c->lanes[1], 7) +
+        array_checksum_rotl(c->lanes[2], 12) +
+        array_checksum_rotl(c->lanes[3], 18);
+
+    h += c->total;
+
+    for(size_t i = 0; i < c->stripe_used; ++i)
+    {
+        h ^= c->stripe[i] * ARRAY_CHECKSUM_PRIME_3;
+        h = array_checksum_rotl(h, 11) * ARRAY_CHECKSUM_PRIME_1;
+    }
+
+    h ^= h >> 33;
+    h *= ARRAY_CHECKSUM_PRIME_2;
+    h ^= h >> 29;
+    h *= ARRAY_CHECKSUM_PRIME_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+/*
+@brief:
+Write every byte of iov, retrying on partial writes and EINTR.
+
+@note:
+iov is consumed: its entries are advanced past the written bytes.
+*/
+static int
+array_io_write_all(int fd, struct iovec *iov, int count)
+{
+    while(count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if(written < 0)
+        {
+            if(errno == EINTR) continue;
+            return errno;
+        }
+
+        size_t left = (size_t)written;
+        while(count > 0 && left >= iov->iov_len)
+        {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+
+        if(count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return 0;
+}
+
+/*
+@brief:
+One read() that returns at least one byte.
+
+@post:
+    On failure:
+        - return EIO at end of file, otherwise the errno of read()
+*/
+static int
+array_io_read_some(int fd, void *dst, size_t size, size_t *got)
+{
+    for(;;)
+    {
+        ssize_t n = read(fd, dst, size);
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            return errno;
+        }
+
+        if(n == 0) return EIO; // stream truncated
+
+        *got = (size_t)n;
+        return 0;
+    }
+}
+
+/*
+@invariant:
+    - w->buffered <= ARRAY_IO_BUFFER_SIZE
+    - w->remaining elements are still owed to the stream
+    - w->error != 0 once a write failed; every later call returns it
+*/
+struct ArrayWriter
+{
+    int fd;
+    size_t element_size;
+    uint64_t remaining;
+    unsigned flags;
+    int error;
+    ArrayChecksum checksum;
+    size_t buffered;
+    unsigned char buffer[ARRAY_IO_BUFFER_SIZE];
+};
+
+/*
+@brief:
+Append bytes to the stream.
+
+@note:
+Small writes are gathered in the buffer. A write of at least one buffer is
+issued together with the pending buffer as a single writev, without
+copying it.
+*/
+static int
+array_writer_put(ArrayWriter *w, const void *bytes, size_t size)
+{
+    if(size <= ARRAY_IO_BUFFER_SIZE - w->buffered)
+    {
+        if(size) memcpy(w->buffer + w->buffered, bytes, size);
+        w->buffered += size;
+        return 0;
+    }
+
+    struct iovec iov[2] = {
+        {.iov_base = w->buffer, .iov_len = w->buffered},
+        {.iov_base = (void *)bytes, .iov_len = size},
+    };
+
+    bool direct = size >= ARRAY_IO_BUFFER_SIZE;
+
+    int error = array_io_write_all(w->fd, iov, direct ? 2 : 1);
+    if(error) return error;
+
+    w->buffered = 0;
+
+    if(!direct)
+    {
+        memcpy(w->buffer, bytes, size);
+        w->buffered = size;
+    }
+
+    return 0;
+}
+
+static int
+array_writer_flush(ArrayWriter *w)
+{
+    if(w->buffered == 0) return 0;
+
+    struct iovec iov = {.iov_base = w->buffer, .iov_len = w->buffered};
+
+    int error = array_io_write_all(w->fd, &iov, 1);
+    if(error) return error;
+
+    w->buffered = 0;
+
+    return 0;
+}
+
+/*
+Contract
+
+@brief
+Starts a buffered stream of count elements on fd.
+
+@note:
+The header is written with the first flush, so nothing reaches fd before
+array_writer_write() fills the buffer or array_writer_close() is called.
+
+@pre:
+    - out != NULL
+    - fd is open for writing
+    - element_size > 0
+    - flags is 0 or ARRAY_IO_CHECKSUM
+
+@ownership:
+    - caller must finish the stream with array_writer_close(); fd stays
+      owned by the caller
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+array_writer_open(ArrayWriter **out, int fd, size_t element_size,
+    uint64_t count, unsigned flags)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(fd < 0 || !element_size) return EINVAL;
+    if(flags & ~(unsigned)ARRAY_IO_CHECKSUM) return EINVAL;
+    if(count > (UINT64_MAX - sizeof(uint64_t)) / element_size)
+    {
+        return EOVERFLOW;
+    }
+
+    ArrayWriter *tmp = memory_allocator(sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->fd = fd;
+    tmp->element_size = element_size;
+    tmp->remaining = count;
+    tmp->flags = flags;
+    tmp->error = 0;
+    tmp->buffered = 0;
+    array_checksum_init(&tmp->checksum);
+
+    ArrayStreamHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARRAY_STREAM_MAGIC, sizeof(header.magic));
+    header.version = ARRAY_STREAM_VERSION;
+    header.flags = flags;
+    header.element_size = element_size;
+    header.count = count;
+
+    memcpy(tmp->buffer, &header, sizeof(header));
+    tmp->buffered = sizeof(header);
+
+    *out = tmp;
+
+    return 0;
+}
+
+/*
+@brief:
+Append count elements stored contiguously at values.
+
+@post:
+    On success:
+        - return 0
+
+    On failure:
+        - return EINVAL when more elements are written than announced at
+          open, otherwise the errno of the failed write; the stream is
+          unusable after a write error
+*/
+int
+array_writer_write(ArrayWriter *w, const void *values, size_t count)
+{
+    if(!w || (!values && count)) return EINVAL;
+    if(w->error) return w->error;
+    if(count > w->remaining) return EINVAL;
+
+    size_t bytes;
+    if(mul_safe(count, w->element_size, &bytes)) return EOVERFLOW;
+
+    if(w->flags & ARRAY_IO_CHECKSUM)
+    {
+        array_checksum_update(&w->checksum, values, bytes);
+    }
+
+    int error = array_writer_put(w, values, bytes);
+    if(error)
+    {
+        w->error = error;
+        return error;
+    }
+
+    w->remaining -= count;
+
+    return 0;
+}
+
+/*
+@brief:
+Write the trailer, flush and release the writer.
+
+@note:
+The writer is released even on failure.
+
+@post:
+    - *writer == NULL
+    - return EINVAL when fewer elements were written than announced,
+      otherwise the first write error of the stream or 0
+*/
+int
+array_writer_close(ArrayWriter **writer)
+{
+    if(!writer || !*writer) return EINVAL;
+
+    ArrayWriter *w = *writer;
+
+    int error = w->error;
+    if(!error && w->remaining) error = EINVAL;
+
+    if(!error && (w->flags & ARRAY_IO_CHECKSUM))
+    {
+        uint64_t checksum = array_checksum_final(&w->checksum);
+        error = array_writer_put(w, &checksum, sizeof(checksum));
+    }
+
+    if(!error) error = array_writer_flush(w);
+
+    memory_free(w);
+    *writer = NULL;
+
+    return error;
+}
+
+/*
+@invariant:
+    - r->start <= r->end <= ARRAY_IO_BUFFER_SIZE
+    - r->unread bytes of the stream have not been read from fd yet; the
+      reader never asks fd for more
+    - r->error != 0 once a read failed; every later call returns it
+*/
+struct ArrayReader
+{
+    int fd;
+    size_t element_size;
+    uint64_t remaining;
+    uint64_t unread;
+    unsigned flags;
+    int error;
+    ArrayChecksum checksum;
+    size_t start;
+    size_t end;
+    unsigned char buffer[ARRAY_IO_BUFFER_SIZE];
+};
+
+/*
+@brief:
+Copy the next size bytes of the stream to dst.
+
+@note:
+Buffered bytes are consumed first. Requests of at least one buffer are
+read straight into dst; smaller ones refill the buffer, never past the
+end of the stream.
+
+@pre:
+    - size <= buffered bytes + r->unread
+*/
+static int
+array_reader_take(ArrayReader *r, void *dst, size_t size)
+{
+    unsigned char *out = dst;
+
+    size_t buffered = r->end - r->start;
+    size_t take = buffered < size ? buffered : size;
+
+    if(take) memcpy(out, r->buffer + r->start, take);
+    r->start += take;
+    out += take;
+    size -= take;
+
+    while(size > 0)
+    {
+        size_t got = 0;
+
+        if(size >= ARRAY_IO_BUFFER_SIZE)
+        {
+            int error = array_io_read_some(r->fd, out, size, &got);
+            if(error) return error;
+
+            r->unread -= got;
+            out += got;
+            size -= got;
+            continue;
+        }
+
+        size_t want = r->unread < ARRAY_IO_BUFFER_SIZE ? (size_t)r->unread
+                                                       : ARRAY_IO_BUFFER_SIZE;
+
+        int error = array_io_read_some(r->fd, r->buffer, want, &got);
+        if(error) return error;
+
+        r->unread -= got;
+        r->start = 0;
+        r->end = got;
+
+        take = got < size ? got : size;
+        memcpy(out, r->buffer, take);
+        r->start = take;
+        out += take;
+        size -= take;
+    }
+
+    return 0;
+}
+
+/*
+@brief:
+Read the trailer and compare it against the payload checksum.
+*/
+static int
+array_reader_verify(ArrayReader *r)
+{
+    if(!(r->flags & ARRAY_IO_CHECKSUM)) return 0;
+
+    uint64_t stored;
+    int error = array_reader_take(r, &stored, sizeof(stored));
+    if(error) return error;
+
+    return stored == array_checksum_final(&r->checksum) ? 0 : EBADMSG;
+}
+
+/*
+Contract
+
+@brief
+Reads a stream header from fd and prepares to read its elements.
+
+@pre:
+    - out != NULL
+    - fd is open for reading and positioned at a stream header
+    - element_size equals the element size stored in the stream
+
+@ownership:
+    - caller must release the reader with array_reader_close(); fd stays
+      owned by the caller
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+        - array_reader_remaining(*out) == element count of the stream
+
+    On failure (return != 0):
+        - *out == NULL
+        - return EINVAL for an incompatible header, EIO for a truncated
+          stream, EBADMSG for a checksum mismatch of an empty payload, or
+          the errno of read()
+*/
+int
+array_reader_open(ArrayReader **out, int fd, size_t element_size)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(fd < 0 || !element_size) return EINVAL;
+
+    ArrayReader *tmp = memory_allocator(sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->fd = fd;
+    tmp->element_size = element_size;
+    tmp->remaining = 0;
+    tmp->unread = sizeof(ArrayStreamHeader);
+    tmp->error = 0;
+    tmp->start = 0;
+    tmp->end = 0;
+    array_checksum_init(&tmp->checksum);
+
+    ArrayStreamHeader header;
+    int error = array_reader_take(tmp, &header, sizeof(header));
+
+    if(!error)
+    {
+        if(memcmp(header.magic, ARRAY_STREAM_MAGIC, sizeof(header.magic)) ||
+            header.version != ARRAY_STREAM_VERSION ||
+            (header.flags & ~(uint32_t)ARRAY_IO_CHECKSUM) ||
+            header.element_size != element_size ||
+            header.count >
+                (UINT64_MAX - sizeof(uint64_t)) / header.element_size)
+        {
+            error = EINVAL;
+        }
+    }
+
+    if(!error)
+    {
+        tmp->flags = header.flags;
+        tmp->remaining = header.count;
+        tmp->unread = header.count * element_size;
+        if(header.flags & ARRAY_IO_CHECKSUM) tmp->unread += sizeof(uint64_t);
+
+        if(tmp->remaining == 0) error = array_reader_verify(tmp);
+    }
+
+    if(error)
+    {
+        memory_free(tmp);
+        return error;
+    }
+
+    *out = tmp;
+
+    return 0;
+}
+
+uint64_t
+array_reader_remaining(const ArrayReader *r)
+{
+    return r ? r->remaining : 0;
+}
+
+/*
+@brief:
+Read the next count elements into values.
+
+@note:
+Reading the last element also verifies the checksum trailer.
+
+@post:
+    On success:
+        - return 0
+        - array_reader_remaining(r) decreased by count
+
+    On failure:
+        - return EINVAL when count exceeds the remaining elements, EIO for
+          a truncated stream, EBADMSG for a checksum mismatch, or the errno
+          of read(); the reader is unusable after a read error
+*/
+int
+array_reader_read(ArrayReader *r, void *values, size_t count)
+{
+    if(!r || (!values && count)) return EINVAL;
+    if(r->error) return r->error;
+    if(count > r->remaining) return EINVAL;
+    if(count == 0) return 0;
+
+    size_t bytes = count * r->element_size; // bounded by the header check
+
+    int error = array_reader_take(r, values, bytes);
+
+    if(!error)
+    {
+        if(r->flags & ARRAY_IO_CHECKSUM)
+        {
+            array_checksum_update(&r->checksum, values, bytes);
+        }
+
+        r->remaining -= count;
+
+        if(r->remaining == 0) error = array_reader_verify(r);
+    }
+
+    if(error) r->error = error;
+
+    return error;
+}
+
+/*
+@note:
+Function is null-safe and idempotent.
+*/
+void
+array_reader_close(ArrayReader **reader)
+{
+    if(!reader || !*reader) return;
+
+    memory_free(*reader);
+    *reader = NULL;
+}
+
+/*
+@brief:
+Write the whole array to fd as one stream.
+
+@note:
+Header and elements leave in a single writev straight from the array
+storage; the checksum trailer follows in a second write.
+
+@post:
+    On success:
+        - return 0
+
+    On failure:
+        - return error code; fd may hold a partial stream
+        - EBUSY: an incremental growth is still moving elements (see
+          array_data_const()); nothing was written
+*/
+int
+array_write_fd(const Array *a, int fd, unsigned flags)
+{
+    if(!a) return EINVAL;
+
+    const void *data = array_data_const(a);
+    if(!data && array_size(a)) return EBUSY;
+
+    ArrayWriter *w = NULL;
+    int error = array_writer_open(&w, fd, array_element_size(a),
+        array_size(a), flags);
+    if(error) return error;
+
+    error = array_writer_write(w, data, array_size(a));
+
+    int close_error = array_writer_close(&w);
+
+    return error ? error : close_error;
+}
+
+/*
+@brief:
+Bytes left in fd past its current offset, or -1 when fd is not a regular
+file (or its offset is unknown).
+*/
+static off_t
+array_read_fd_bytes_left(int fd)
+{
+    struct stat st;
+    if(fstat(fd, &st) || !S_ISREG(st.st_mode)) return -1;
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if(offset < 0 || offset > st.st_size) return -1;
+
+    return st.st_size - offset;
+}
+
+/*
+@brief:
+Undo a failed array_read_fd(): drop the elements appended past old_size
+and give back capacity grown past old_capacity.
+*/
+static void
+array_read_fd_rollback(Array *a, size_t old_size, size_t old_capacity)
+{
+    (void)array_erase_range(a, old_size, array_size(a) - old_size);
+
+    if(array_capacity(a) > old_capacity)
+    {
+        (void)array_shrink_fit(a);
+        (void)array_reserve_exact(a, old_capacity);
+    }
+}
+
+/*
+@brief:
+Append the elements of the next stream on fd to the array.
+
+@note:
+The element count in the header is not trusted for allocation. On a
+regular file it must fit in the bytes left in the file; storage is then
+reserved once for the exact count and the payload is read straight into
+the reserved tail with large read() calls. On pipes and sockets the
+payload is read in batches of about 1 MiB, so storage grows only as data
+actually arrives.
+
+@pre:
+    - a != NULL
+    - the stream element size equals array_element_size(a)
+
+@post:
+    On success:
+        - return 0
+        - array_size(a) increased by the stream element count
+
+    On failure:
+        - return error code (see array_reader_open/array_reader_read);
+          EIO when a regular file is shorter than the header claims
+        - array_size(a) is unchanged, capacity grown by the read is
+          released again
+*/
+int
+array_read_fd(Array *a, int fd)
+{
+    if(!a) return EINVAL;
+
+    off_t bytes_left = array_read_fd_bytes_left(fd);
+
+    ArrayReader *r = NULL;
+    int error = array_reader_open(&r, fd, array_element_size(a));
+    if(error) return error;
+
+    uint64_t remaining = array_reader_remaining(r);
+
+    size_t es = array_element_size(a);
+    size_t old_size = array_size(a);
+    size_t old_capacity = array_capacity(a);
+    size_t new_size;
+
+    if(remaining > SIZE_MAX || add_safe(old_size, (size_t)remaining, &new_size))
+    {
+        array_reader_close(&r);
+        return EOVERFLOW;
+    }
+
+    // count * es cannot overflow: array_reader_open() bounded it
+    if(bytes_left >= 0 &&
+        ((uint64_t)bytes_left < sizeof(ArrayStreamHeader) ||
+            remaining >
+                ((uint64_t)bytes_left - sizeof(ArrayStreamHeader)) / es))
+    {
+        array_reader_close(&r);
+        return EIO;
+    }
+
+    size_t count = (size_t)remaining;
+    size_t batch = count;
+
+    if(bytes_left >= 0)
+    {
+        error = array_reserve_exact(a, new_size);
+    }
+    else
+    {
+        batch = ARRAY_IO_READ_BATCH / es ? ARRAY_IO_READ_BATCH / es : 1;
+    }
+
+    for(size_t done = 0; !error && done < count;)
+    {
+        size_t n = count - done < batch ? count - done : batch;
+
+        void *tail = NULL;
+        error = array_push_back_uninit(a, n, &tail);
+        if(!error) error = array_reader_read(r, tail, n);
+
+        done += n;
+    }
+
+    if(error) array_read_fd_rollback(a, old_size, old_capacity);
+
+    array_reader_close(&r);
+
+    return error;
+}
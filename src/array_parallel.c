@@ -0,0 +1,279 @@
+#include "../include/array_parallel.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+#include "../include/thread_pool.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Data-parallel loops over the contiguous buffer of an Array, run on
+thread_pool_default() (or on the calling thread alone when the pool
+cannot be started). Loop bodies receive whole slices, never single
+elements, so the per-call overhead is paid once per grain.
+*/
+enum
+{
+    ARRAY_PARALLEL_GRAIN_BYTES = 64 * 1024,
+};
+
+typedef struct ArrayParallelFor
+{
+    unsigned char *base;
+    size_t element_size;
+    ArrayParallelFn fn;
+    void *context;
+} ArrayParallelFor;
+
+typedef struct ArrayParallelMap
+{
+    const unsigned char *src;
+    unsigned char *dst;
+    size_t src_size;
+    size_t dst_size;
+    ArrayMapFn fn;
+    void *context;
+} ArrayParallelMap;
+
+typedef struct ArrayParallelReduce
+{
+    const unsigned char *base;
+    unsigned char *partials;
+    size_t element_size;
+    size_t count;
+    size_t grain;
+    ArrayCombineFn combine;
+    void *context;
+} ArrayParallelReduce;
+
+static size_t
+array_parallel_grain(size_t grain, size_t element_size)
+{
+    if(grain) return grain;
+
+    grain = ARRAY_PARALLEL_GRAIN_BYTES / element_size;
+
+    return grain ? grain : 1;
+}
+
+static void
+array_parallel_run(size_t count, size_t grain, ThreadPoolRangeFn fn,
+    void *context)
+{
+    ThreadPool *pool = thread_pool_default();
+
+    if(!pool || thread_pool_for(pool, count, grain, fn, context))
+    {
+        fn(context, 0, count);
+    }
+}
+
+static void
+array_parallel_for_range(void *context, size_t begin, size_t end)
+{
+    ArrayParallelFor *loop = context;
+
+    loop->fn(loop->base + begin * loop->element_size, end - begin, begin,
+        loop->context);
+}
+
+/*
+@brief:
+Call fn on consecutive slices of array concurrently.
+
+@pre:
+    - array != NULL, fn != NULL
+    - grain: at most this many elements per call; 0 picks about 64 KiB
+      of elements
+    - fn is safe to call concurrently on disjoint slices and does not
+      resize array
+
+@post:
+    - every element was passed to fn exactly once, in some slice
+*/
+int
+array_parallel_for(Array *array, size_t grain, ArrayParallelFn fn,
+    void *context)
+{
+    if(!array || !fn) return EINVAL;
+
+    size_t count = array_size(array);
+    if(count == 0) return 0;
+
+    ArrayParallelFor loop = {
+        .base = array_data(array),
+        .element_size = array_element_size(array),
+        .fn = fn,
+        .context = context,
+    };
+
+    array_parallel_run(count,
+        array_parallel_grain(grain, loop.element_size),
+        array_parallel_for_range, &loop);
+
+    return 0;
+}
+
+static void
+array_parallel_map_range(void *context, size_t begin, size_t end)
+{
+    ArrayParallelMap *map = context;
+
+    map->fn(map->src + begin * map->src_size,
+        map->dst + begin * map->dst_size, end - begin, map->context);
+}
+
+/*
+@brief:
+Replace the contents of dst with fn applied to every element of src,
+computed concurrently.
+
+@pre:
+    - src != NULL, dst != NULL, src != dst
+    - fn != NULL; fn writes count elements of dst's element size
+
+@post:
+    On success (return == 0):
+        - size(dst) == size(src)
+        - dst[i] is fn's output for src[i]
+
+    On failure (return != 0):
+        - dst is unchanged
+        - EBUSY: an incremental growth of src is still moving elements
+          (see array_data_const())
+*/
+int
+array_parallel_map(const Array *src, Array *dst, ArrayMapFn fn,
+    void *context)
+{
+    if(!src || !dst || !fn || src == dst) return EINVAL;
+
+    size_t count = array_size(src);
+    size_t current = array_size(dst);
+
+    const void *base = array_data_const(src);
+    if(!base && count) return EBUSY;
+
+    // resize first: every slot is overwritten below
+    void *out = NULL;
+    int error = count > current
+        ? array_push_back_uninit(dst, count - current, &out)
+        : array_erase_range(dst, count, current - count);
+    if(error) return error;
+
+    if(count == 0) return 0;
+
+    ArrayParallelMap map = {
+        .src = base,
+        .dst = array_data(dst),
+        .src_size = array_element_size(src),
+        .dst_size = array_element_size(dst),
+        .fn = fn,
+        .context = context,
+    };
+
+    size_t widest = map.src_size > map.dst_size ? map.src_size : map.dst_size;
+
+    array_parallel_run(count, array_parallel_grain(0, widest),
+        array_parallel_map_range, &map);
+
+    return 0;
+}
+
+static void
+array_parallel_reduce_range(void *context, size_t begin, size_t end)
+{
+    ArrayParallelReduce *reduce = context;
+    size_t es = reduce->element_size;
+
+    for(size_t chunk = begin; chunk < end; ++chunk)
+    {
+        size_t first = chunk * reduce->grain;
+        size_t last = reduce->count - first < reduce->grain
+            ? reduce->count
+            : first + reduce->grain;
+
+        unsigned char *accumulator = reduce->partials + chunk * es;
+        memcpy(accumulator, reduce->base + first * es, es);
+
+        for(size_t i = first + 1; i < last; ++i)
+        {
+            reduce->combine(accumulator, reduce->base + i * es,
+                reduce->context);
+        }
+    }
+}
+
+/*
+@brief:
+Fold every element of array into init with combine, computed
+concurrently, and store the result in out.
+
+@pre:
+    - array != NULL, init != NULL, out != NULL, combine != NULL
+    - init and out hold one element; they may alias
+
+@post:
+    On success (return == 0):
+        - *out == init + a[0] + a[1] + ... + a[n - 1], grouped in some
+          way but always in index order
+
+    On failure (return != 0):
+        - *out is unchanged
+        - EBUSY: an incremental growth of array is still moving elements
+          (see array_data_const())
+
+@note:
+Partial results of fixed-size chunks (about 64 KiB of elements each) are
+kept in a buffer from the array's allocator and combined in chunk order
+on the calling thread, so the result does not depend on scheduling.
+*/
+int
+array_parallel_reduce(const Array *array, const void *init, void *out,
+    ArrayCombineFn combine, void *context)
+{
+    if(!array || !init || !out || !combine) return EINVAL;
+
+    size_t es = array_element_size(array);
+    size_t count = array_size(array);
+
+    if(count == 0)
+    {
+        memmove(out, init, es);
+        return 0;
+    }
+
+    const void *base = array_data_const(array);
+    if(!base) return EBUSY;
+
+    ArrayParallelReduce reduce = {
+        .base = base,
+        .element_size = es,
+        .count = count,
+        .grain = array_parallel_grain(0, es),
+        .combine = combine,
+        .context = context,
+    };
+
+    size_t chunks = count / reduce.grain + (count % reduce.grain != 0);
+
+    const Allocator *allocator = array_allocator(array);
+    size_t bytes = chunks * es;
+    reduce.partials = allocator->allocate(allocator->context, bytes);
+    if(!reduce.partials) return ENOMEM;
+
+    array_parallel_run(chunks, 1, array_parallel_reduce_range, &reduce);
+
+    memmove(out, init, es);
+
+    for(size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        combine(out, reduce.partials + chunk * es, context);
+    }
+
+    allocator->deallocate(allocator->context, reduce.partials, bytes);
+
+    return 0;
+}
@@ -0,0 +1,1027 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/array_sort.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+Comparison sort: introsort over an explicit range stack. Partitions use a
+median-of-3 pivot (ninther above ARRAY_SORT_NINTHER_THRESHOLD) and
+Sedgewick's two-sided scan, which stops on equal keys and so stays
+balanced on inputs with many duplicates. Ranges of at most
+ARRAY_SORT_INSERTION_THRESHOLD elements are finished by insertion sort,
+and a range that exceeds the depth budget falls back to heapsort, so the
+worst case is O(n log n).
+
+The core is forced inline into one wrapper per common element size; with
+a constant element_size every swap compiles to a pair of word loads and
+stores instead of a byte loop.
+*/
+#ifdef __GNUC__
+#define ARRAY_SORT_INLINE static inline __attribute__((always_inline))
+#else
+#define ARRAY_SORT_INLINE static inline
+#endif
+
+enum
+{
+    ARRAY_SORT_INSERTION_THRESHOLD = 16,
+    ARRAY_SORT_NINTHER_THRESHOLD = 128,
+    ARRAY_SORT_STACK_DEPTH = 64, // smaller half first: log2(SIZE_MAX)
+    ARRAY_SORT_PARALLEL_THRESHOLD = 1 << 16,
+    ARRAY_SORT_PARALLEL_GRAIN = 1 << 12, // minimum elements per thread
+    ARRAY_SORT_MAX_THREADS = 256,
+    ARRAY_RADIX_BITS = 8,
+    ARRAY_RADIX_BUCKETS = 1 << ARRAY_RADIX_BITS,
+};
+
+typedef struct ArraySortRange
+{
+    size_t first;
+    size_t count;
+    size_t depth;
+} ArraySortRange;
+
+ARRAY_SORT_INLINE void
+array_sort_swap(unsigned char *a, unsigned char *b, size_t element_size)
+{
+    if(element_size == 4)
+    {
+        uint32_t x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        memcpy(a, &y, 4);
+        memcpy(b, &x, 4);
+        return;
+    }
+
+    if(element_size == 8)
+    {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        memcpy(a, &y, 8);
+        memcpy(b, &x, 8);
+        return;
+    }
+
+    if(element_size == 16)
+    {
+        uint64_t x[2], y[2];
+        memcpy(x, a, 16);
+        memcpy(y, b, 16);
+        memcpy(a, y, 16);
+        memcpy(b, x, 16);
+        return;
+    }
+
+    for(; element_size >= 8; element_size -= 8, a += 8, b += 8)
+    {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        memcpy(a, &y, 8);
+        memcpy(b, &x, 8);
+    }
+
+    for(; element_size; --element_size, ++a, ++b)
+    {
+        unsigned char x = *a;
+        *a = *b;
+        *b = x;
+    }
+}
+
+ARRAY_SORT_INLINE void
+array_sort_insertion(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    for(size_t i = 1; i < count; ++i)
+    {
+        unsigned char *p = base + i * element_size;
+
+        for(; p > base && cmp(p - element_size, p) > 0; p -= element_size)
+        {
+            array_sort_swap(p - element_size, p, element_size);
+        }
+    }
+}
+
+ARRAY_SORT_INLINE void
+array_sort_sift_down(unsigned char *base, size_t root, size_t count,
+    size_t element_size, ArrayComparator cmp)
+{
+    for(;;)
+    {
+        size_t child = 2 * root + 1;
+        if(child >= count) return;
+
+        unsigned char *c = base + child * element_size;
+        if(child + 1 < count && cmp(c, c + element_size) < 0)
+        {
+            ++child;
+            c += element_size;
+        }
+
+        unsigned char *r = base + root * element_size;
+        if(cmp(r, c) >= 0) return;
+
+        array_sort_swap(r, c, element_size);
+        root = child;
+    }
+}
+
+ARRAY_SORT_INLINE void
+array_sort_heap(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    for(size_t i = count / 2; i-- > 0;)
+    {
+        array_sort_sift_down(base, i, count, element_size, cmp);
+    }
+
+    for(size_t end = count - 1; end > 0; --end)
+    {
+        array_sort_swap(base, base + end * element_size, element_size);
+        array_sort_sift_down(base, 0, end, element_size, cmp);
+    }
+}
+
+ARRAY_SORT_INLINE size_t
+array_sort_median3(const unsigned char *base, size_t a, size_t b, size_t c,
+    size_t element_size, ArrayComparator cmp)
+{
+    const void *pa = base + a * element_size;
+    const void *pb = base + b * element_size;
+    const void *pc = base + c * element_size;
+
+    if(cmp(pa, pb) < 0)
+    {
+        if(cmp(pb, pc) < 0) return b;
+        return cmp(pa, pc) < 0 ? c : a;
+    }
+
+    if(cmp(pa, pc) < 0) return a;
+    return cmp(pb, pc) < 0 ? c : b;
+}
+
+/*
+@brief:
+Partition base[0, count) around a median pivot and return its final
+index; every element before it compares <= and every element after it
+compares >= the pivot.
+*/
+ARRAY_SORT_INLINE size_t
+array_sort_partition(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    size_t mid = count / 2;
+    size_t last = count - 1;
+    size_t pivot;
+
+    if(count > ARRAY_SORT_NINTHER_THRESHOLD)
+    {
+        size_t s = count / 8;
+        size_t a = array_sort_median3(base, 0, s, 2 * s, element_size, cmp);
+        size_t b = array_sort_median3(base, mid - s, mid, mid + s,
+            element_size, cmp);
+        size_t c = array_sort_median3(base, last - 2 * s, last - s, last,
+            element_size, cmp);
+        pivot = array_sort_median3(base, a, b, c, element_size, cmp);
+    }
+    else
+    {
+        pivot = array_sort_median3(base, 0, mid, last, element_size, cmp);
+    }
+
+    array_sort_swap(base, base + pivot * element_size, element_size);
+
+    size_t i = 0;
+    size_t j = count;
+
+    for(;;)
+    {
+        while(++i < count && cmp(base + i * element_size, base) < 0) {}
+        while(cmp(base, base + --j * element_size) < 0) {}
+
+        if(i >= j) break;
+
+        array_sort_swap(base + i * element_size, base + j * element_size,
+            element_size);
+    }
+
+    array_sort_swap(base, base + j * element_size, element_size);
+
+    return j;
+}
+
+ARRAY_SORT_INLINE void
+array_sort_intro(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    ArraySortRange stack[ARRAY_SORT_STACK_DEPTH];
+    size_t top = 0;
+
+    size_t depth = 0;
+    for(size_t n = count; n > 1; n >>= 1) depth += 2;
+
+    size_t first = 0;
+
+    for(;;)
+    {
+        while(count > ARRAY_SORT_INSERTION_THRESHOLD)
+        {
+            unsigned char *p = base + first * element_size;
+
+            if(depth == 0)
+            {
+                array_sort_heap(p, count, element_size, cmp);
+                count = 0;
+                break;
+            }
+            --depth;
+
+            size_t pivot = array_sort_partition(p, count, element_size, cmp);
+            size_t left = pivot;
+            size_t right = count - pivot - 1;
+
+            // defer the larger side so the stack stays logarithmic
+            if(left < right)
+            {
+                stack[top++] =
+                    (ArraySortRange){first + pivot + 1, right, depth};
+                count = left;
+            }
+            else
+            {
+                stack[top++] = (ArraySortRange){first, left, depth};
+                first += pivot + 1;
+                count = right;
+            }
+        }
+
+        array_sort_insertion(base + first * element_size, count, element_size,
+            cmp);
+
+        if(top == 0) return;
+
+        --top;
+        first = stack[top].first;
+        count = stack[top].count;
+        depth = stack[top].depth;
+    }
+}
+
+static void
+array_sort_4(unsigned char *base, size_t count, ArrayComparator cmp)
+{
+    array_sort_intro(base, count, 4, cmp);
+}
+
+static void
+array_sort_8(unsigned char *base, size_t count, ArrayComparator cmp)
+{
+    array_sort_intro(base, count, 8, cmp);
+}
+
+static void
+array_sort_16(unsigned char *base, size_t count, ArrayComparator cmp)
+{
+    array_sort_intro(base, count, 16, cmp);
+}
+
+static void
+array_sort_generic(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    array_sort_intro(base, count, element_size, cmp);
+}
+
+static void
+array_sort_run(unsigned char *base, size_t count, size_t element_size,
+    ArrayComparator cmp)
+{
+    if(element_size == 4)
+    {
+        array_sort_4(base, count, cmp);
+    }
+    else if(element_size == 8)
+    {
+        array_sort_8(base, count, cmp);
+    }
+    else if(element_size == 16)
+    {
+        array_sort_16(base, count, cmp);
+    }
+    else
+    {
+        array_sort_generic(base, count, element_size, cmp);
+    }
+}
+
+/*
+@brief:
+Sort array in ascending order of cmp. Not stable.
+
+@pre:
+    - array != NULL
+    - cmp != NULL, a strict weak order as for qsort
+
+@post:
+    On success (return == 0):
+        - for every i + 1 < size: cmp(at(i), at(i + 1)) <= 0
+
+    On failure (return != 0):
+        - array is unchanged
+
+@note:
+O(n log n) comparisons in the worst case, no allocation.
+*/
+int
+array_sort(Array *array, ArrayComparator cmp)
+{
+    if(!array || !cmp) return EINVAL;
+
+    size_t count = array_size(array);
+    if(count < 2) return 0;
+
+    array_sort_run(array_data(array), count, array_element_size(array), cmp);
+
+    return 0;
+}
+
+/*
+LSD radix sort, 8 bits per pass. One read of the input builds the
+histograms of every digit; a pass whose digit is the same for all keys is
+skipped, so small key ranges cost only the passes their bits need. Each
+pass is a stable scatter between the values and a scratch buffer of the
+same size.
+*/
+typedef struct ArraySortPair
+{
+    uint64_t key;
+    size_t index;
+} ArraySortPair;
+
+#define ARRAY_RADIX_DEFINE(name, type, key_bytes, key_of)                      \
+    static void name(type *values, type *scratch, size_t count)                \
+    {                                                                          \
+        size_t counts[key_bytes][ARRAY_RADIX_BUCKETS];                         \
+        memset(counts, 0, sizeof(counts));                                     \
+                                                                               \
+        for(size_t i = 0; i < count; ++i)                                      \
+        {                                                                      \
+            uint64_t key = key_of(values[i]);                                  \
+            for(size_t d = 0; d < (key_bytes); ++d)                            \
+            {                                                                  \
+                ++counts[d][(key >> (d * ARRAY_RADIX_BITS)) & 0xFF];           \
+            }                                                                  \
+        }                                                                      \
+                                                                               \
+        type *src = values;                                                    \
+        type *dst = scratch;                                                   \
+                                                                               \
+        for(size_t d = 0; d < (key_bytes); ++d)                                \
+        {                                                                      \
+            unsigned shift = (unsigned)(d * ARRAY_RADIX_BITS);                 \
+            size_t *offsets = counts[d];                                       \
+                                                                               \
+            if(offsets[(key_of(src[0]) >> shift) & 0xFF] == count) continue;   \
+                                                                               \
+            size_t sum = 0;                                                    \
+            for(size_t b = 0; b < ARRAY_RADIX_BUCKETS; ++b)                    \
+            {                                                                  \
+                size_t n = offsets[b];                                         \
+                offsets[b] = sum;                                              \
+                sum += n;                                                      \
+            }                                                                  \
+                                                                               \
+            for(size_t i = 0; i < count; ++i)                                  \
+            {                                                                  \
+                dst[offsets[(key_of(src[i]) >> shift) & 0xFF]++] = src[i];     \
+            }                                                                  \
+                                                                               \
+            type *tmp = src;                                                   \
+            src = dst;                                                         \
+            dst = tmp;                                                         \
+        }                                                                      \
+                                                                               \
+        if(src != values) memcpy(values, src, count * sizeof(*values));        \
+    }
+
+#define ARRAY_RADIX_KEY_SELF(v) ((uint64_t)(v))
+#define ARRAY_RADIX_KEY_PAIR(v) ((v).key)
+
+ARRAY_RADIX_DEFINE(array_radix_u32, uint32_t, 4, ARRAY_RADIX_KEY_SELF)
+ARRAY_RADIX_DEFINE(array_radix_u64, uint64_t, 8, ARRAY_RADIX_KEY_SELF)
+ARRAY_RADIX_DEFINE(array_radix_pairs, ArraySortPair, 8, ARRAY_RADIX_KEY_PAIR)
+
+static void *
+array_sort_scratch(const Array *array, size_t count, size_t size,
+    size_t extra, size_t *bytes)
+{
+    if(mul_safe(count, size, bytes) || add_safe(*bytes, extra, bytes))
+    {
+        return NULL;
+    }
+
+    const Allocator *allocator = array_allocator(array);
+
+    return allocator->allocate(allocator->context, *bytes);
+}
+
+static void
+array_sort_scratch_free(const Array *array, void *scratch, size_t bytes)
+{
+    const Allocator *allocator = array_allocator(array);
+
+    allocator->deallocate(allocator->context, scratch, bytes);
+}
+
+static int
+array_sort_radix(Array *array, size_t key_bytes)
+{
+    if(!array) return EINVAL;
+    if(array_element_size(array) != key_bytes) return EINVAL;
+
+    size_t count = array_size(array);
+    if(count < 2) return 0;
+
+    size_t bytes;
+    void *scratch = array_sort_scratch(array, count, key_bytes, 0, &bytes);
+    if(!scratch) return ENOMEM;
+
+    if(key_bytes == sizeof(uint32_t))
+    {
+        array_radix_u32(array_data(array), scratch, count);
+    }
+    else
+    {
+        array_radix_u64(array_data(array), scratch, count);
+    }
+
+    array_sort_scratch_free(array, scratch, bytes);
+
+    return 0;
+}
+
+/*
+@brief:
+Stable ascending radix sort of an array of uint32_t.
+
+@pre:
+    - array != NULL
+    - element_size == sizeof(uint32_t)
+
+@post:
+    On failure (return != 0):
+        - array is unchanged
+
+@note:
+Uses one scratch buffer of size * element_size bytes from the array's
+allocator (ENOMEM when it cannot be obtained).
+*/
+int
+array_sort_u32(Array *array)
+{
+    return array_sort_radix(array, sizeof(uint32_t));
+}
+
+/*
+@brief:
+Stable ascending radix sort of an array of uint64_t; see array_sort_u32().
+*/
+int
+array_sort_u64(Array *array)
+{
+    return array_sort_radix(array, sizeof(uint64_t));
+}
+
+/*
+@brief:
+Rewrite every element as an unsigned key with the same order, or with
+inverse, restore the values from their keys.
+*/
+static void
+array_sort_map_keys(Array *array, bool f64, bool inverse)
+{
+    unsigned char *p = array_data(array);
+    size_t count = array_size(array);
+    const uint64_t sign = (uint64_t)1 << 63;
+
+    for(size_t i = 0; i < count; ++i, p += sizeof(uint64_t))
+    {
+        uint64_t bits;
+        memcpy(&bits, p, sizeof(bits));
+
+        if(!f64)
+        {
+            bits ^= sign;
+        }
+        else if(!inverse)
+        {
+            // negative: reverse the magnitude order; positive: above them
+            bits ^= (0 - (bits >> 63)) | sign;
+        }
+        else
+        {
+            bits ^= ((bits >> 63) - 1) | sign;
+        }
+
+        memcpy(p, &bits, sizeof(bits));
+    }
+}
+
+static int
+array_sort_mapped(Array *array, bool f64)
+{
+    if(!array) return EINVAL;
+    if(array_element_size(array) != sizeof(uint64_t)) return EINVAL;
+
+    if(array_size(array) < 2) return 0;
+
+    array_sort_map_keys(array, f64, false);
+
+    int error = array_sort_radix(array, sizeof(uint64_t));
+
+    array_sort_map_keys(array, f64, true);
+
+    return error;
+}
+
+/*
+@brief:
+Stable ascending radix sort of an array of int64_t; see array_sort_u32().
+*/
+int
+array_sort_i64(Array *array)
+{
+    return array_sort_mapped(array, false);
+}
+
+/*
+@brief:
+Stable ascending radix sort of an array of double; see array_sort_u32().
+
+@note:
+Orders by IEEE-754 total order: -NaN < -inf < ... < -0.0 < +0.0 < ...
+< +inf < +NaN.
+*/
+int
+array_sort_f64(Array *array)
+{
+    return array_sort_mapped(array, true);
+}
+
+/*
+@brief:
+Stable sort of array by an unsigned 64-bit key extracted from each
+element, e.g. an integer field of a struct.
+
+@pre:
+    - array != NULL
+    - key != NULL; called exactly once per element
+
+@post:
+    On failure (return != 0):
+        - array is unchanged
+
+@note:
+Radix-sorts (key, index) pairs, then applies the permutation in place by
+following its cycles, so every element is moved at most once plus once per
+cycle. Scratch space is 2 * size * 16 bytes plus one element, from the
+array's allocator.
+*/
+int
+array_sort_by_key(Array *array, ArraySortKey key, void *context)
+{
+    if(!array || !key) return EINVAL;
+
+    size_t count = array_size(array);
+    if(count < 2) return 0;
+
+    size_t element_size = array_element_size(array);
+    unsigned char *base = array_data(array);
+
+    size_t pairs_bytes;
+    if(mul_safe(count, 2 * sizeof(ArraySortPair), &pairs_bytes)) return ENOMEM;
+
+    size_t bytes;
+    ArraySortPair *pairs = array_sort_scratch(array, count,
+        2 * sizeof(ArraySortPair), element_size, &bytes);
+    if(!pairs) return ENOMEM;
+
+    unsigned char *held = (unsigned char *)pairs + pairs_bytes;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        pairs[i].key = key(base + i * element_size, context);
+        pairs[i].index = i;
+    }
+
+    array_radix_pairs(pairs, pairs + count, count);
+
+    // slot j receives the element that started at pairs[j].index
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(pairs[i].index == i) continue;
+
+        memcpy(held, base + i * element_size, element_size);
+
+        size_t j = i;
+        for(;;)
+        {
+            size_t from = pairs[j].index;
+            pairs[j].index = j;
+            if(from == i) break;
+
+            memcpy(base + j * element_size, base + from * element_size,
+                element_size);
+            j = from;
+        }
+
+        memcpy(base + j * element_size, held, element_size);
+    }
+
+    array_sort_scratch_free(array, pairs, bytes);
+
+    return 0;
+}
+
+/*
+Stable merge sort and the parallel driver.
+
+array_sort_parallel() cuts the array into one contiguous chunk per thread
+and sorts the chunks concurrently, by introsort or, with
+ARRAY_SORT_STABLE, by a bottom-up merge sort. It then merges pairs of
+sorted runs in log2(threads) rounds, ping-ponging between the array and
+one scratch buffer. Within a round the output is split into equal
+segments, one per thread, and each thread finds where its segment starts
+in both inputs by binary search (co-ranking), so every round is fully
+parallel even when only one pair of runs remains.
+
+Each phase spawns its threads and joins them before the next one starts;
+a thread that cannot be created has its share run by the caller.
+*/
+ARRAY_SORT_INLINE void
+array_sort_copy(unsigned char *dst, const unsigned char *src,
+    size_t element_size)
+{
+    if(element_size == 4)
+    {
+        memcpy(dst, src, 4);
+    }
+    else if(element_size == 8)
+    {
+        memcpy(dst, src, 8);
+    }
+    else if(element_size == 16)
+    {
+        memcpy(dst, src, 16);
+    }
+    else
+    {
+        memcpy(dst, src, element_size);
+    }
+}
+
+/*
+@brief:
+Merge sorted a[0, na) and b[0, nb) into dst; on ties a goes first.
+*/
+static void
+array_sort_merge(unsigned char *dst, const unsigned char *a, size_t na,
+    const unsigned char *b, size_t nb, size_t element_size,
+    ArrayComparator cmp)
+{
+    const unsigned char *a_end = a + na * element_size;
+    const unsigned char *b_end = b + nb * element_size;
+
+    while(a < a_end && b < b_end)
+    {
+        if(cmp(b, a) < 0)
+        {
+            array_sort_copy(dst, b, element_size);
+            b += element_size;
+        }
+        else
+        {
+            array_sort_copy(dst, a, element_size);
+            a += element_size;
+        }
+        dst += element_size;
+    }
+
+    if(a < a_end) memcpy(dst, a, (size_t)(a_end - a));
+    if(b < b_end) memcpy(dst, b, (size_t)(b_end - b));
+}
+
+/*
+@brief:
+Number of elements of a among the first k outputs of
+array_sort_merge(a, na, b, nb).
+*/
+static size_t
+array_sort_corank(size_t k, const unsigned char *a, size_t na,
+    const unsigned char *b, size_t nb, size_t element_size,
+    ArrayComparator cmp)
+{
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+
+    // smallest i whose a[i] is not output before b[k - i - 1]
+    while(lo < hi)
+    {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = k - i;
+
+        if(cmp(b + (j - 1) * element_size, a + i * element_size) >= 0)
+        {
+            lo = i + 1;
+        }
+        else
+        {
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+static void
+array_sort_stable_run(unsigned char *base, unsigned char *scratch,
+    size_t count, size_t element_size, ArrayComparator cmp)
+{
+    const size_t run = ARRAY_SORT_INSERTION_THRESHOLD;
+
+    for(size_t i = 0; i < count; i += run)
+    {
+        array_sort_insertion(base + i * element_size,
+            count - i < run ? count - i : run, element_size, cmp);
+    }
+
+    unsigned char *src = base;
+    unsigned char *dst = scratch;
+
+    for(size_t width = run; width < count; width *= 2)
+    {
+        for(size_t i = 0; i < count; i += 2 * width)
+        {
+            size_t mid = count - i < width ? count : i + width;
+            size_t end = count - mid < width ? count : mid + width;
+
+            array_sort_merge(dst + i * element_size, src + i * element_size,
+                mid - i, src + mid * element_size, end - mid, element_size,
+                cmp);
+        }
+
+        unsigned char *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if(src != base) memcpy(base, src, count * element_size);
+}
+
+typedef enum ArraySortPhase
+{
+    ARRAY_SORT_PHASE_RUNS,
+    ARRAY_SORT_PHASE_MERGE,
+    ARRAY_SORT_PHASE_COPY,
+} ArraySortPhase;
+
+typedef struct ArraySortJob
+{
+    unsigned char *base;
+    unsigned char *scratch;
+    size_t count;
+    size_t element_size;
+    ArrayComparator cmp;
+    size_t threads;
+    bool stable;
+
+    ArraySortPhase phase;
+    unsigned char *src;
+    unsigned char *dst;
+    size_t width; // chunks per input run of a merge round
+} ArraySortJob;
+
+typedef struct ArraySortTask
+{
+    ArraySortJob *job;
+    size_t index;
+} ArraySortTask;
+
+static size_t
+array_sort_chunk_begin(const ArraySortJob *job, size_t chunk)
+{
+    if(chunk >= job->threads) return job->count;
+
+    // count * chunk / threads without overflow
+    size_t q = job->count / job->threads;
+    size_t r = job->count % job->threads;
+
+    return q * chunk + r * chunk / job->threads;
+}
+
+static void
+array_sort_merge_segment(const ArraySortJob *job, size_t index)
+{
+    size_t es = job->element_size;
+    size_t lo = array_sort_chunk_begin(job, index);
+    size_t hi = array_sort_chunk_begin(job, index + 1);
+
+    for(size_t c = 0; c < job->threads; c += 2 * job->width)
+    {
+        size_t first = array_sort_chunk_begin(job, c);
+        size_t mid = array_sort_chunk_begin(job, c + job->width);
+        size_t end = array_sort_chunk_begin(job, c + 2 * job->width);
+
+        if(end <= lo) continue;
+        if(first >= hi) break;
+
+        const unsigned char *a = job->src + first * es;
+        const unsigned char *b = job->src + mid * es;
+        size_t na = mid - first;
+        size_t nb = end - mid;
+
+        size_t k0 = (lo > first ? lo : first) - first;
+        size_t k1 = (hi < end ? hi : end) - first;
+
+        size_t i0 = array_sort_corank(k0, a, na, b, nb, es, job->cmp);
+        size_t i1 = array_sort_corank(k1, a, na, b, nb, es, job->cmp);
+
+        array_sort_merge(job->dst + (first + k0) * es, a + i0 * es, i1 - i0,
+            b + (k0 - i0) * es, (k1 - i1) - (k0 - i0), es, job->cmp);
+    }
+}
+
+static void *
+array_sort_worker(void *argument)
+{
+    ArraySortTask *task = argument;
+    ArraySortJob *job = task->job;
+    size_t es = job->element_size;
+
+    size_t first = array_sort_chunk_begin(job, task->index);
+    size_t count = array_sort_chunk_begin(job, task->index + 1) - first;
+
+    if(job->phase == ARRAY_SORT_PHASE_RUNS)
+    {
+        if(job->stable)
+        {
+            array_sort_stable_run(job->base + first * es,
+                job->scratch + first * es, count, es, job->cmp);
+        }
+        else
+        {
+            array_sort_run(job->base + first * es, count, es, job->cmp);
+        }
+    }
+    else if(job->phase == ARRAY_SORT_PHASE_MERGE)
+    {
+        array_sort_merge_segment(job, task->index);
+    }
+    else
+    {
+        memcpy(job->base + first * es, job->src + first * es, count * es);
+    }
+
+    return NULL;
+}
+
+typedef struct ArraySortThreads
+{
+    pthread_t workers[ARRAY_SORT_MAX_THREADS];
+    ArraySortTask tasks[ARRAY_SORT_MAX_THREADS];
+    bool started[ARRAY_SORT_MAX_THREADS];
+} ArraySortThreads;
+
+static void
+array_sort_run_phase(ArraySortJob *job, ArraySortThreads *threads)
+{
+    for(size_t t = 0; t < job->threads; ++t)
+    {
+        threads->tasks[t] = (ArraySortTask){job, t};
+    }
+
+    for(size_t t = 1; t < job->threads; ++t)
+    {
+        threads->started[t] = pthread_create(&threads->workers[t], NULL,
+                                  array_sort_worker, &threads->tasks[t]) == 0;
+    }
+
+    array_sort_worker(&threads->tasks[0]);
+
+    for(size_t t = 1; t < job->threads; ++t)
+    {
+        if(threads->started[t])
+        {
+            pthread_join(threads->workers[t], NULL);
+        }
+        else
+        {
+            array_sort_worker(&threads->tasks[t]);
+        }
+    }
+}
+
+/*
+@brief:
+Sort array on up to threads threads (0 = one per online CPU).
+
+@pre:
+    - array != NULL
+    - cmp != NULL, a strict weak order as for qsort, safe to call
+      concurrently
+    - flags is 0 or ARRAY_SORT_STABLE (equal elements keep their order)
+
+@post:
+    On success (return == 0):
+        - for every i + 1 < size: cmp(at(i), at(i + 1)) <= 0
+
+    On failure (return != 0):
+        - array is unchanged
+
+@note:
+Arrays below ARRAY_SORT_PARALLEL_THRESHOLD elements are sorted on the
+calling thread. Needs one scratch buffer of size * element_size bytes
+from the array's allocator, except for an unstable sort on one thread.
+*/
+int
+array_sort_parallel(Array *array, ArrayComparator cmp, size_t threads,
+    unsigned flags)
+{
+    if(!array || !cmp) return EINVAL;
+    if(flags & ~(unsigned)ARRAY_SORT_STABLE) return EINVAL;
+
+    size_t count = array_size(array);
+    if(count < 2) return 0;
+
+    if(threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+
+    if(threads > ARRAY_SORT_MAX_THREADS) threads = ARRAY_SORT_MAX_THREADS;
+    if(count < ARRAY_SORT_PARALLEL_THRESHOLD) threads = 1;
+    if(threads > count / ARRAY_SORT_PARALLEL_GRAIN)
+    {
+        threads = count / ARRAY_SORT_PARALLEL_GRAIN;
+    }
+    if(threads == 0) threads = 1;
+
+    bool stable = flags & ARRAY_SORT_STABLE;
+    if(threads == 1 && !stable) return array_sort(array, cmp);
+
+    ArraySortJob job = {
+        .base = array_data(array),
+        .count = count,
+        .element_size = array_element_size(array),
+        .cmp = cmp,
+        .threads = threads,
+        .stable = stable,
+    };
+
+    size_t bytes;
+    job.scratch = array_sort_scratch(array, count, job.element_size, 0,
+        &bytes);
+    if(!job.scratch) return ENOMEM;
+
+    ArraySortThreads pool;
+
+    job.phase = ARRAY_SORT_PHASE_RUNS;
+    array_sort_run_phase(&job, &pool);
+
+    job.phase = ARRAY_SORT_PHASE_MERGE;
+    job.src = job.base;
+    job.dst = job.scratch;
+
+    for(job.width = 1; job.width < threads; job.width *= 2)
+    {
+        array_sort_run_phase(&job, &pool);
+
+        unsigned char *tmp = job.src;
+        job.src = job.dst;
+        job.dst = tmp;
+    }
+
+    if(job.src != job.base)
+    {
+        job.phase = ARRAY_SORT_PHASE_COPY;
+        array_sort_run_phase(&job, &pool);
+    }
+
+    array_sort_scratch_free(array, job.scratch, bytes);
+
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include "../include/concurrent_array.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Append-only array for many concurrent producers.
+
+Element i lives in segment k at offset o, where i + FIRST == 2^(k + SHIFT)
++ o: segment 0 holds FIRST elements and every following segment twice as
+many as the one before. Segments are allocated on first touch and never
+moved or freed before destroy, so an element's address is fixed once its
+slot exists and the directory never needs to grow.
+
+A producer reserves an index with one fetch-add on reserved, installs
+the segment with a compare-and-swap if nobody has yet (the loser frees
+its copy), writes the element and then sets the slot's ready byte with
+release order. A reader that sees the ready byte with acquire order sees
+the whole element. Producers never wait for each other, and readers
+never block producers.
+*/
+enum
+{
+    CONCURRENT_ARRAY_SHIFT = 6,
+    CONCURRENT_ARRAY_FIRST = 1 << CONCURRENT_ARRAY_SHIFT,
+    CONCURRENT_ARRAY_SEGMENTS = sizeof(size_t) * CHAR_BIT,
+    CONCURRENT_ARRAY_CACHE_LINE = 64,
+};
+
+/*
+Segment layout: capacity elements, then capacity ready bytes.
+*/
+typedef struct ConcurrentSegment
+{
+    size_t capacity;
+    size_t bytes;
+    atomic_uchar *ready;
+    alignas(max_align_t) unsigned char data[];
+} ConcurrentSegment;
+
+/*
+@invariant:
+    - element_size > 0, allocator != NULL
+    - segments[k] is NULL or holds FIRST << k elements
+    - every index < reserved has been handed to exactly one producer
+*/
+struct ConcurrentArray
+{
+    atomic_size_t reserved;
+    unsigned char pad[CONCURRENT_ARRAY_CACHE_LINE - sizeof(atomic_size_t)];
+
+    size_t element_size;
+    const Allocator *allocator;
+    _Atomic(ConcurrentSegment *) segments[CONCURRENT_ARRAY_SEGMENTS];
+};
+
+static size_t
+concurrent_array_locate(size_t index, size_t *offset)
+{
+    size_t j = index + CONCURRENT_ARRAY_FIRST;
+    size_t high = (sizeof(unsigned long long) * CHAR_BIT - 1) -
+        (size_t)__builtin_clzll((unsigned long long)j);
+
+    *offset = j - ((size_t)1 << high);
+
+    return high - CONCURRENT_ARRAY_SHIFT;
+}
+
+static ConcurrentSegment *
+concurrent_array_segment(ConcurrentArray *a, size_t k)
+{
+    ConcurrentSegment *segment =
+        atomic_load_explicit(&a->segments[k], memory_order_acquire);
+    if(segment) return segment;
+
+    size_t capacity = (size_t)CONCURRENT_ARRAY_FIRST << k;
+
+    size_t data_bytes;
+    size_t bytes;
+    if(mul_safe(capacity, a->element_size, &data_bytes) ||
+        add_safe(data_bytes, sizeof(*segment) + capacity, &bytes))
+    {
+        return NULL;
+    }
+
+    ConcurrentSegment *fresh = a->allocator->allocate(a->allocator->context,
+        bytes);
+    if(!fresh) return NULL;
+
+    fresh->capacity = capacity;
+    fresh->bytes = bytes;
+    fresh->ready = (atomic_uchar *)(fresh->data + data_bytes);
+    memset(fresh->ready, 0, capacity);
+
+    if(atomic_compare_exchange_strong_explicit(&a->segments[k], &segment,
+           fresh, memory_order_acq_rel, memory_order_acquire))
+    {
+        return fresh;
+    }
+
+    // another producer installed it first
+    a->allocator->deallocate(a->allocator->context, fresh, bytes);
+
+    return segment;
+}
+
+/*
+@brief:
+Create an empty concurrent array for elements of element_size bytes.
+
+@pre:
+    - out != NULL
+    - element_size > 0
+    - allocator != NULL, safe to call from several threads at once and
+      outliving the array
+
+@ownership:
+    - caller must release with concurrent_array_destroy() once no other
+      thread uses the array
+
+@post:
+    On success (return == 0):
+        - *out != NULL, size == 0
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+concurrent_array_create_with_allocator(ConcurrentArray **out,
+    size_t element_size, const Allocator *allocator)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!element_size || !allocator) return EINVAL;
+
+    ConcurrentArray *tmp = allocator->allocate(allocator->context,
+        sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    atomic_init(&tmp->reserved, 0);
+    tmp->element_size = element_size;
+    tmp->allocator = allocator;
+
+    for(size_t k = 0; k < CONCURRENT_ARRAY_SEGMENTS; ++k)
+    {
+        atomic_init(&tmp->segments[k], NULL);
+    }
+
+    *out = tmp;
+
+    return 0;
+}
+
+int
+concurrent_array_create(ConcurrentArray **out, size_t element_size)
+{
+    return concurrent_array_create_with_allocator(out, element_size,
+        allocator_default());
+}
+
+/*
+@note:
+Function is null-safe and idempotent. Not safe against concurrent use of
+the array.
+*/
+void
+concurrent_array_destroy(ConcurrentArray **array)
+{
+    if(!array || !*array) return;
+
+    ConcurrentArray *a = *array;
+    const Allocator *allocator = a->allocator;
+
+    for(size_t k = 0; k < CONCURRENT_ARRAY_SEGMENTS; ++k)
+    {
+        ConcurrentSegment *segment = atomic_load(&a->segments[k]);
+        if(segment)
+        {
+            allocator->deallocate(allocator->context, segment,
+                segment->bytes);
+        }
+    }
+
+    allocator->deallocate(allocator->context, a, sizeof(*a));
+    *array = NULL;
+}
+
+/*
+@brief:
+Append a copy of value; safe to call from any number of threads at once.
+
+@pre:
+    - array != NULL, value != NULL
+    - out_index may be NULL; otherwise receives the element's index
+
+@post:
+    On success (return == 0):
+        - the element is visible to concurrent_array_get/at
+
+    On failure (return != 0):
+        - ENOMEM: the segment for the reserved index could not be
+          allocated; the index stays empty (get returns EAGAIN for it)
+*/
+int
+concurrent_array_push_back(ConcurrentArray *array, const void *value,
+    size_t *out_index)
+{
+    if(!array || !value) return EINVAL;
+
+    size_t index = atomic_fetch_add_explicit(&array->reserved, 1,
+        memory_order_relaxed);
+    if(index > SIZE_MAX - CONCURRENT_ARRAY_FIRST) return EOVERFLOW;
+
+    size_t offset;
+    size_t k = concurrent_array_locate(index, &offset);
+
+    ConcurrentSegment *segment = concurrent_array_segment(array, k);
+    if(!segment) return ENOMEM;
+
+    memcpy(segment->data + offset * array->element_size, value,
+        array->element_size);
+    atomic_store_explicit(&segment->ready[offset], 1, memory_order_release);
+
+    if(out_index) *out_index = index;
+
+    return 0;
+}
+
+/*
+@brief:
+Address of a published element, stable until the array is destroyed.
+
+@note:
+Returns NULL for an index that is not reserved yet or whose producer has
+not finished writing it. Safe concurrently with producers.
+*/
+const void *
+concurrent_array_at(const ConcurrentArray *array, size_t index)
+{
+    if(!array) return NULL;
+    if(index >= atomic_load_explicit(&array->reserved, memory_order_relaxed))
+    {
+        return NULL;
+    }
+
+    size_t offset;
+    size_t k = concurrent_array_locate(index, &offset);
+
+    ConcurrentSegment *segment =
+        atomic_load_explicit(&array->segments[k], memory_order_acquire);
+    if(!segment) return NULL;
+
+    if(!atomic_load_explicit(&segment->ready[offset], memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    return segment->data + offset * array->element_size;
+}
+
+/*
+@brief:
+Copy element index into out_value.
+
+@post:
+    - EINVAL: index >= size
+    - EAGAIN: index is reserved but its producer has not published it yet
+*/
+int
+concurrent_array_get(const ConcurrentArray *array, size_t index,
+    void *out_value)
+{
+    if(!array || !out_value) return EINVAL;
+    if(index >= atomic_load_explicit(&array->reserved, memory_order_relaxed))
+    {
+        return EINVAL;
+    }
+
+    const void *element = concurrent_array_at(array, index);
+    if(!element) return EAGAIN;
+
+    memcpy(out_value, element, array->element_size);
+
+    return 0;
+}
+
+/*
+@brief:
+Number of reserved indices. Every index below it has been handed to a
+producer; an index that is still being written reads as EAGAIN.
+*/
+size_t
+concurrent_array_size(const ConcurrentArray *array)
+{
+    return array ? atomic_load_explicit(&array->reserved, memory_order_relaxed)
+                 : 0;
+}
+
+size_t
+concurrent_array_element_size(const ConcurrentArray *array)
+{
+    return array ? array->element_size : 0;
+}
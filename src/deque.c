@@ -0,0 +1,368 @@
+#include "../include/deque.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+static const size_t DEQUE_INIT_CAP = 8;
+
+/*
+@invariant:
+    - d != NULL
+    - d->data != NULL
+    - d->element_size > 0
+    - d->capacity is a power of two
+    - d->head < d->capacity
+    - d->size <= d->capacity
+    - element i is stored in slot (d->head + i) & (d->capacity - 1)
+    - d->allocator != NULL
+*/
+struct Deque
+{
+    size_t capacity;
+    void *data;
+    size_t element_size;
+    size_t size;
+    size_t head;
+    const Allocator *allocator;
+};
+
+int
+deque_invariant_validation(const Deque *d)
+{
+    if(!d) return EINVAL;
+    if(!d->data) return EINVAL;
+    if(d->element_size == 0) return EINVAL;
+    if(d->capacity == 0 || (d->capacity & (d->capacity - 1))) return EINVAL;
+    if(d->head >= d->capacity) return EINVAL;
+    if(d->size > d->capacity) return EINVAL;
+    if(!d->allocator) return EINVAL;
+
+    return 0;
+}
+
+/*
+@brief:
+Translate a logical index into a pointer to its ring slot.
+
+@pre:
+    - index < d->capacity
+*/
+static inline char *
+deque_slot(const Deque *d, size_t index)
+{
+    size_t physical = (d->head + index) & (d->capacity - 1);
+    return (char *)d->data + physical * d->element_size;
+}
+
+/*
+Contract
+
+@brief
+Creates a ring-buffer deque with Array-compatible element semantics.
+
+@pre:
+    - out != NULL
+    - element_size > 0
+
+@ownership:
+    - caller must release object with deque_destroy()
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+        - deque_size(*out) == 0
+        - deque_capacity(*out) == DEQUE_INIT_CAP
+
+    On failure (return != 0):
+        - *out == NULL
+        - no memory is leaked
+*/
+int
+deque_create(Deque **object, size_t element_size)
+{
+    return deque_create_with_allocator(object, element_size,
+        allocator_default());
+}
+
+int
+deque_create_with_allocator(Deque **object, size_t element_size,
+    const Allocator *allocator)
+{
+    if(!object || !element_size || !allocator) return EINVAL;
+
+    *object = NULL;
+
+    size_t new_bytes;
+    if(mul_safe(DEQUE_INIT_CAP, element_size, &new_bytes)) return EOVERFLOW;
+
+    Deque *tmp = allocator->allocate(allocator->context, sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->data = allocator->allocate(allocator->context, new_bytes);
+    if(!tmp->data)
+    {
+        allocator->deallocate(allocator->context, tmp, sizeof(*tmp));
+        return ENOMEM;
+    }
+
+    tmp->capacity = DEQUE_INIT_CAP;
+    tmp->element_size = element_size;
+    tmp->size = 0;
+    tmp->head = 0;
+    tmp->allocator = allocator;
+
+    *object = tmp;
+
+    return 0;
+}
+
+/*
+@brief:
+Release the deque and its storage.
+
+@note:
+Function is null-safe and idempotent.
+*/
+void
+deque_destroy(Deque **object)
+{
+    if(!object || !*object) return;
+
+    Deque *d = *object;
+    const Allocator *allocator = d->allocator;
+
+    allocator->deallocate(allocator->context, d->data,
+        d->capacity * d->element_size);
+    allocator->deallocate(allocator->context, d, sizeof(*d));
+
+    *object = NULL;
+}
+
+/*
+@brief:
+Ensure room for at least min_capacity elements.
+
+@note:
+Capacity is rounded up to a power of two. Storage grows through
+reallocate; if the live range wrapped around, the wrapped prefix is moved
+behind the old end so that logical order is preserved.
+
+@post:
+    On success:
+        - return 0
+        - deque_capacity(d) >= min_capacity
+
+    On failure:
+        - return error code
+        - d is unchanged
+*/
+int
+deque_reserve(Deque *d, size_t min_capacity)
+{
+    if(!d) return EINVAL;
+
+    assert(deque_invariant_validation(d) == 0);
+
+    if(min_capacity <= d->capacity) return 0;
+
+    size_t new_capacity = d->capacity;
+    while(new_capacity < min_capacity)
+    {
+        if(mul_safe(new_capacity, 2, &new_capacity)) return EOVERFLOW;
+    }
+
+    size_t new_bytes;
+    if(mul_safe(new_capacity, d->element_size, &new_bytes)) return EOVERFLOW;
+
+    const Allocator *allocator = d->allocator;
+
+    char *tmp = allocator->reallocate(allocator->context, d->data,
+        d->capacity * d->element_size, new_bytes);
+    if(!tmp) return ENOMEM;
+
+    size_t old_capacity = d->capacity;
+
+    if(d->head + d->size > old_capacity)
+    {
+        // new_capacity >= 2 * old_capacity, so the prefix fits after old end
+        size_t wrapped = d->head + d->size - old_capacity;
+        memcpy(tmp + old_capacity * d->element_size, tmp,
+            wrapped * d->element_size);
+    }
+
+    d->data = tmp;
+    d->capacity = new_capacity;
+
+    return 0;
+}
+
+int
+deque_push_back(Deque *restrict d, const void *restrict value)
+{
+    if(!d || !value) return EINVAL;
+    if(d->size == SIZE_MAX) return EOVERFLOW;
+
+    int error = deque_reserve(d, d->size + 1);
+    if(error) return error;
+
+    memcpy(deque_slot(d, d->size), value, d->element_size);
+    ++d->size;
+
+    return 0;
+}
+
+int
+deque_push_front(Deque *restrict d, const void *restrict value)
+{
+    if(!d || !value) return EINVAL;
+    if(d->size == SIZE_MAX) return EOVERFLOW;
+
+    int error = deque_reserve(d, d->size + 1);
+    if(error) return error;
+
+    d->head = (d->head - 1) & (d->capacity - 1);
+    memcpy(deque_slot(d, 0), value, d->element_size);
+    ++d->size;
+
+    return 0;
+}
+
+void
+deque_pop_front(Deque *d)
+{
+    if(!d || d->size == 0) return;
+
+    d->head = (d->head + 1) & (d->capacity - 1);
+    --d->size;
+}
+
+void
+deque_pop_back(Deque *d)
+{
+    if(!d || d->size == 0) return;
+
+    --d->size;
+}
+
+/*
+@brief:
+Insert value before index.
+
+@note:
+Shifts whichever side of index is shorter, so the cost is
+O(min(index, size - index)).
+
+@pre:
+    - d != NULL
+    - value != NULL
+    - index <= deque_size(d)
+*/
+int
+deque_insert(Deque *restrict d, const void *restrict value, size_t index)
+{
+    if(!d || !value || (index > d->size)) return EINVAL;
+    if(d->size == SIZE_MAX) return EOVERFLOW;
+
+    int error = deque_reserve(d, d->size + 1);
+    if(error) return error;
+
+    size_t element_size = d->element_size;
+
+    if(index < d->size / 2)
+    {
+        d->head = (d->head - 1) & (d->capacity - 1);
+
+        for(size_t i = 0; i < index; ++i)
+        {
+            memcpy(deque_slot(d, i), deque_slot(d, i + 1), element_size);
+        }
+    }
+    else
+    {
+        for(size_t i = d->size; i > index; --i)
+        {
+            memcpy(deque_slot(d, i), deque_slot(d, i - 1), element_size);
+        }
+    }
+
+    memcpy(deque_slot(d, index), value, element_size);
+    ++d->size;
+
+    return 0;
+}
+
+/*
+@brief:
+Remove the element at index.
+
+@note:
+Shifts whichever side of index is shorter, so the cost is
+O(min(index, size - index)).
+*/
+int
+deque_erase(Deque *d, size_t index)
+{
+    if(!d || (index >= d->size)) return EINVAL;
+
+    size_t element_size = d->element_size;
+
+    if(index < d->size / 2)
+    {
+        for(size_t i = index; i > 0; --i)
+        {
+            memcpy(deque_slot(d, i), deque_slot(d, i - 1), element_size);
+        }
+
+        d->head = (d->head + 1) & (d->capacity - 1);
+    }
+    else
+    {
+        for(size_t i = index; i + 1 < d->size; ++i)
+        {
+            memcpy(deque_slot(d, i), deque_slot(d, i + 1), element_size);
+        }
+    }
+
+    --d->size;
+
+    return 0;
+}
+
+int
+deque_get(const Deque *d, size_t index, void *value)
+{
+    if(!d || !value) return EINVAL;
+    if(index >= d->size) return EINVAL;
+
+    memcpy(value, deque_slot(d, index), d->element_size);
+
+    return 0;
+}
+
+int
+deque_set(Deque *d, size_t index, const void *value)
+{
+    if(!d || !value) return EINVAL;
+    if(index >= d->size) return EINVAL;
+
+    memcpy(deque_slot(d, index), value, d->element_size);
+
+    return 0;
+}
+
+size_t
+deque_size(const Deque *d)
+{
+    return d ? d->size : 0;
+}
+
+size_t
+deque_capacity(const Deque *d)
+{
+    return d ? d->capacity : 0;
+}
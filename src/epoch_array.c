@@ -0,0 +1,485 @@
+#include "../include/epoch_array.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Growable array with one writer and wait-free readers.
+
+The writer appends into the current buffer and publishes the new size
+with a release store; elements below the size are never written again.
+Growth copies into a larger buffer, swaps the current pointer and retires
+the old buffer instead of freeing it.
+
+Retired buffers are reclaimed by epochs. A reader announces the global
+epoch in its own slot before it loads the buffer pointer and clears the
+slot when it is done. Retiring a buffer advances the global epoch; the
+buffer is freed once every slot is idle or announces a later epoch,
+because such readers loaded the pointer after the swap. Reads are two
+stores and a few loads, with no loop and no lock; the writer never waits
+for readers either, it just keeps buffers on the retired list longer.
+*/
+enum
+{
+    EPOCH_ARRAY_INIT_CAP = 8,
+    EPOCH_ARRAY_DEFAULT_READERS = 64,
+    EPOCH_ARRAY_CACHE_LINE = 64,
+};
+
+typedef struct EpochBuffer
+{
+    size_t capacity;
+    size_t bytes;
+    uint64_t retired_at;
+    struct EpochBuffer *next; // retired list
+    alignas(max_align_t) unsigned char data[];
+} EpochBuffer;
+
+/*
+One reader slot per cache line. epoch == 0 means outside a read.
+*/
+struct EpochArrayReader
+{
+    alignas(EPOCH_ARRAY_CACHE_LINE) atomic_uint_least64_t epoch;
+    atomic_bool in_use;
+    EpochArray *array;
+};
+
+_Static_assert(sizeof(EpochArrayReader) == EPOCH_ARRAY_CACHE_LINE,
+    "one reader slot per cache line");
+
+/*
+@invariant:
+    - current != NULL, size <= current->capacity
+    - epoch >= 1
+    - every buffer on retired has retired_at < epoch
+*/
+struct EpochArray
+{
+    _Atomic(EpochBuffer *) current;
+    atomic_size_t size;
+    atomic_uint_least64_t epoch;
+
+    size_t element_size;
+    const Allocator *allocator;
+
+    EpochBuffer *retired; // writer only
+    size_t retired_count;
+
+    size_t max_readers;
+    EpochArrayReader *readers; // cache-line aligned inside reader_block
+    void *reader_block;
+    size_t reader_block_bytes;
+};
+
+static EpochBuffer *
+epoch_buffer_create(const EpochArray *a, size_t capacity)
+{
+    size_t bytes;
+    if(mul_safe(capacity, a->element_size, &bytes) ||
+        add_safe(bytes, sizeof(EpochBuffer), &bytes))
+    {
+        return NULL;
+    }
+
+    EpochBuffer *buffer = a->allocator->allocate(a->allocator->context,
+        bytes);
+    if(!buffer) return NULL;
+
+    buffer->capacity = capacity;
+    buffer->bytes = bytes;
+    buffer->retired_at = 0;
+    buffer->next = NULL;
+
+    return buffer;
+}
+
+static void
+epoch_buffer_destroy(const EpochArray *a, EpochBuffer *buffer)
+{
+    a->allocator->deallocate(a->allocator->context, buffer, buffer->bytes);
+}
+
+/*
+@brief:
+Free every retired buffer no reader can still hold and return how many
+are left.
+*/
+size_t
+epoch_array_collect(EpochArray *array)
+{
+    if(!array) return 0;
+
+    uint_least64_t oldest = UINT_LEAST64_MAX;
+
+    for(size_t i = 0; i < array->max_readers; ++i)
+    {
+        uint_least64_t e = atomic_load(&array->readers[i].epoch);
+        if(e && e < oldest) oldest = e;
+    }
+
+    EpochBuffer **link = &array->retired;
+    while(*link)
+    {
+        EpochBuffer *buffer = *link;
+
+        if(buffer->retired_at < oldest)
+        {
+            *link = buffer->next;
+            epoch_buffer_destroy(array, buffer);
+            --array->retired_count;
+        }
+        else
+        {
+            link = &buffer->next;
+        }
+    }
+
+    return array->retired_count;
+}
+
+/*
+@brief:
+Move the elements to a buffer of capacity elements and retire the old
+one.
+*/
+static int
+epoch_array_grow(EpochArray *a, size_t capacity)
+{
+    EpochBuffer *old = atomic_load_explicit(&a->current, memory_order_relaxed);
+    size_t size = atomic_load_explicit(&a->size, memory_order_relaxed);
+
+    EpochBuffer *fresh = epoch_buffer_create(a, capacity);
+    if(!fresh) return ENOMEM;
+
+    memcpy(fresh->data, old->data, size * a->element_size);
+
+    atomic_store(&a->current, fresh);
+
+    old->retired_at = atomic_fetch_add(&a->epoch, 1);
+    old->next = a->retired;
+    a->retired = old;
+    ++a->retired_count;
+
+    epoch_array_collect(a);
+
+    return 0;
+}
+
+/*
+@brief:
+Create an empty array for one writer and up to max_readers concurrent
+reader handles.
+
+@pre:
+    - out != NULL
+    - element_size > 0
+    - max_readers == 0 selects EPOCH_ARRAY_DEFAULT_READERS (64)
+    - allocator != NULL, outlives the array
+
+@ownership:
+    - caller must release with epoch_array_destroy() after every reader
+      handle has been released
+
+@post:
+    On success (return == 0):
+        - *out != NULL, size == 0
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+epoch_array_create_with_allocator(EpochArray **out, size_t element_size,
+    size_t max_readers, const Allocator *allocator)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!element_size || !allocator) return EINVAL;
+
+    if(!max_readers) max_readers = EPOCH_ARRAY_DEFAULT_READERS;
+
+    // the allocator only guarantees max_align_t; align the slots by hand
+    size_t reader_bytes;
+    if(mul_safe(max_readers, sizeof(EpochArrayReader), &reader_bytes) ||
+        add_safe(reader_bytes, EPOCH_ARRAY_CACHE_LINE - 1, &reader_bytes))
+    {
+        return EINVAL;
+    }
+
+    EpochArray *tmp = allocator->allocate(allocator->context, sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->element_size = element_size;
+    tmp->allocator = allocator;
+    tmp->retired = NULL;
+    tmp->retired_count = 0;
+    tmp->max_readers = max_readers;
+
+    tmp->reader_block_bytes = reader_bytes;
+    tmp->reader_block = allocator->allocate(allocator->context, reader_bytes);
+    EpochBuffer *buffer = tmp->reader_block
+        ? epoch_buffer_create(tmp, EPOCH_ARRAY_INIT_CAP)
+        : NULL;
+
+    if(!buffer)
+    {
+        if(tmp->reader_block)
+        {
+            allocator->deallocate(allocator->context, tmp->reader_block,
+                reader_bytes);
+        }
+        allocator->deallocate(allocator->context, tmp, sizeof(*tmp));
+        return ENOMEM;
+    }
+
+    uintptr_t slots = ((uintptr_t)tmp->reader_block +
+                          EPOCH_ARRAY_CACHE_LINE - 1) &
+        ~(uintptr_t)(EPOCH_ARRAY_CACHE_LINE - 1);
+    tmp->readers = (EpochArrayReader *)slots;
+
+    for(size_t i = 0; i < max_readers; ++i)
+    {
+        atomic_init(&tmp->readers[i].epoch, 0);
+        atomic_init(&tmp->readers[i].in_use, false);
+        tmp->readers[i].array = tmp;
+    }
+
+    atomic_init(&tmp->current, buffer);
+    atomic_init(&tmp->size, 0);
+    atomic_init(&tmp->epoch, 1);
+
+    *out = tmp;
+
+    return 0;
+}
+
+int
+epoch_array_create(EpochArray **out, size_t element_size, size_t max_readers)
+{
+    return epoch_array_create_with_allocator(out, element_size, max_readers,
+        allocator_default());
+}
+
+/*
+@note:
+Function is null-safe and idempotent.
+*/
+void
+epoch_array_destroy(EpochArray **array)
+{
+    if(!array || !*array) return;
+
+    EpochArray *a = *array;
+    const Allocator *allocator = a->allocator;
+
+    while(a->retired)
+    {
+        EpochBuffer *next = a->retired->next;
+        epoch_buffer_destroy(a, a->retired);
+        a->retired = next;
+    }
+
+    epoch_buffer_destroy(a, atomic_load(&a->current));
+
+    allocator->deallocate(allocator->context, a->reader_block,
+        a->reader_block_bytes);
+    allocator->deallocate(allocator->context, a, sizeof(*a));
+
+    *array = NULL;
+}
+
+/*
+@brief:
+Make room for at least min_capacity elements. Writer thread only.
+
+@post:
+    On failure (return != 0):
+        - array is unchanged
+*/
+int
+epoch_array_reserve(EpochArray *array, size_t min_capacity)
+{
+    if(!array) return EINVAL;
+
+    EpochBuffer *current =
+        atomic_load_explicit(&array->current, memory_order_relaxed);
+    if(min_capacity <= current->capacity) return 0;
+
+    size_t capacity = current->capacity;
+    while(capacity < min_capacity)
+    {
+        if(capacity > SIZE_MAX / 2) return EOVERFLOW;
+        capacity *= 2;
+    }
+
+    return epoch_array_grow(array, capacity);
+}
+
+/*
+@brief:
+Append count elements and publish them to readers at once. Writer thread
+only.
+
+@post:
+    On failure (return != 0):
+        - array is unchanged
+*/
+int
+epoch_array_push_back_n(EpochArray *array, const void *values,
+    size_t count)
+{
+    if(!array || (!values && count)) return EINVAL;
+    if(count == 0) return 0;
+
+    size_t size = atomic_load_explicit(&array->size, memory_order_relaxed);
+    if(count > SIZE_MAX - size) return EOVERFLOW;
+
+    int error = epoch_array_reserve(array, size + count);
+    if(error) return error;
+
+    EpochBuffer *current =
+        atomic_load_explicit(&array->current, memory_order_relaxed);
+
+    memcpy(current->data + size * array->element_size, values,
+        count * array->element_size);
+
+    atomic_store_explicit(&array->size, size + count, memory_order_release);
+
+    return 0;
+}
+
+int
+epoch_array_push_back(EpochArray *array, const void *value)
+{
+    if(!value) return EINVAL;
+
+    return epoch_array_push_back_n(array, value, 1);
+}
+
+/*
+@brief:
+Claim a reader slot for the calling thread.
+
+@post:
+    On failure (return != 0):
+        - *out == NULL
+        - EAGAIN: all max_readers slots are taken
+*/
+int
+epoch_array_reader_acquire(EpochArray *array, EpochArrayReader **out)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!array) return EINVAL;
+
+    for(size_t i = 0; i < array->max_readers; ++i)
+    {
+        bool expected = false;
+        if(atomic_compare_exchange_strong(&array->readers[i].in_use,
+               &expected, true))
+        {
+            *out = &array->readers[i];
+            return 0;
+        }
+    }
+
+    return EAGAIN;
+}
+
+/*
+@note:
+Function is null-safe and idempotent. Ends an open read.
+*/
+void
+epoch_array_reader_release(EpochArrayReader **reader)
+{
+    if(!reader || !*reader) return;
+
+    atomic_store(&(*reader)->epoch, 0);
+    atomic_store(&(*reader)->in_use, false);
+    *reader = NULL;
+}
+
+/*
+@brief:
+Start a read and return a snapshot: the elements [0, *out_size) at the
+returned address stay valid until epoch_array_read_end().
+
+@pre:
+    - reader != NULL, out_size != NULL
+    - reads of one handle do not nest
+
+@note:
+Wait-free. A long read only delays freeing of buffers retired meanwhile.
+*/
+const void *
+epoch_array_read_begin(EpochArrayReader *reader, size_t *out_size)
+{
+    EpochArray *a = reader->array;
+
+    // announce before loading the pointer; pairs with the writer's
+    // store to current followed by the epoch increment
+    atomic_store(&reader->epoch, atomic_load(&a->epoch));
+
+    *out_size = atomic_load_explicit(&a->size, memory_order_acquire);
+
+    return atomic_load(&a->current)->data;
+}
+
+void
+epoch_array_read_end(EpochArrayReader *reader)
+{
+    atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+/*
+@brief:
+Copy element index into out_value. Wait-free.
+
+@post:
+    - EINVAL: index >= size at the time of the read
+*/
+int
+epoch_array_get(EpochArrayReader *reader, size_t index, void *out_value)
+{
+    if(!reader || !out_value) return EINVAL;
+
+    size_t size;
+    const unsigned char *data = epoch_array_read_begin(reader, &size);
+
+    int error = EINVAL;
+    if(index < size)
+    {
+        size_t element_size = reader->array->element_size;
+        memcpy(out_value, data + index * element_size, element_size);
+        error = 0;
+    }
+
+    epoch_array_read_end(reader);
+
+    return error;
+}
+
+size_t
+epoch_array_size(const EpochArray *array)
+{
+    return array ? atomic_load_explicit(&array->size, memory_order_acquire)
+                 : 0;
+}
+
+size_t
+epoch_array_element_size(const EpochArray *array)
+{
+    return array ? array->element_size : 0;
+}
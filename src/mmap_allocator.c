@@ -0,0 +1,326 @@
+#define _GNU_SOURCE
+
+#include "../include/mmap_allocator.h"
+
+#include "../include/allocator.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+Large-block allocator.
+
+Blocks of at least threshold bytes are backed by private anonymous
+mappings and resized with mremap(MREMAP_MAYMOVE), so growing a large array
+remaps pages instead of copying them. Smaller blocks go through
+memory_allocator. The size passed to reallocate/deallocate decides which
+kind of block a pointer is, so the Allocator contract of passing the
+exact previous size is required.
+
+With MMAP_ALLOCATOR_HUGE_PAGES, mappings of at least one huge page
+(2 MiB) are sized in whole huge pages and start on a huge page boundary,
+so transparent huge pages can back all of them; madvise(MADV_HUGEPAGE)
+is only a hint and is skipped for smaller mappings, which THP could not
+back anyway. Growing such a mapping moves it with mremap onto a freshly
+aligned range when it cannot grow in place, which still copies nothing.
+*/
+enum
+{
+    MMAP_HUGE_PAGE_SIZE = 2 * 1024 * 1024,
+};
+
+struct MmapAllocator
+{
+    Allocator allocator;
+    size_t threshold;
+    size_t page_size;
+    unsigned flags;
+};
+
+static bool
+mmap_is_huge(const MmapAllocator *m, size_t size)
+{
+    return (m->flags & MMAP_ALLOCATOR_HUGE_PAGES) &&
+        size >= MMAP_HUGE_PAGE_SIZE;
+}
+
+/*
+@brief:
+Mapping length of a block of size bytes: whole huge pages for huge
+blocks, whole pages otherwise.
+
+@pre:
+    - size <= SIZE_MAX - MMAP_HUGE_PAGE_SIZE
+*/
+static size_t
+mmap_round_up(const MmapAllocator *m, size_t size)
+{
+    size_t unit = mmap_is_huge(m, size) ? MMAP_HUGE_PAGE_SIZE : m->page_size;
+
+    return (size + (unit - 1)) & ~(unit - 1);
+}
+
+static bool
+mmap_is_huge_aligned(const void *pointer)
+{
+    return ((uintptr_t)pointer & (MMAP_HUGE_PAGE_SIZE - 1)) == 0;
+}
+
+static bool
+mmap_is_large(const MmapAllocator *m, size_t size)
+{
+    return size >= m->threshold;
+}
+
+static void
+mmap_advise(const MmapAllocator *m, void *pointer, size_t bytes)
+{
+#ifdef MADV_HUGEPAGE
+    if(mmap_is_huge(m, bytes))
+    {
+        (void)madvise(pointer, bytes, MADV_HUGEPAGE); // advisory only
+    }
+#else
+    (void)m;
+    (void)pointer;
+    (void)bytes;
+#endif
+}
+
+/*
+@brief:
+Map bytes (a multiple of the huge page size) starting on a huge page
+boundary, by over-mapping one huge page and unmapping the slack.
+*/
+static void *
+mmap_map_huge_aligned(size_t bytes)
+{
+    size_t span = bytes + MMAP_HUGE_PAGE_SIZE;
+
+    unsigned char *raw = mmap(NULL, span, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED) return NULL;
+
+    size_t head = (MMAP_HUGE_PAGE_SIZE -
+                      ((uintptr_t)raw & (MMAP_HUGE_PAGE_SIZE - 1))) &
+        (MMAP_HUGE_PAGE_SIZE - 1);
+    size_t tail = span - head - bytes;
+
+    if(head) munmap(raw, head);
+    if(tail) munmap(raw + head + bytes, tail);
+
+    return raw + head;
+}
+
+static void *
+mmap_map(const MmapAllocator *m, size_t size)
+{
+    if(size > SIZE_MAX - 2 * (size_t)MMAP_HUGE_PAGE_SIZE) return NULL;
+
+    size_t bytes = mmap_round_up(m, size);
+
+    if(mmap_is_huge(m, bytes))
+    {
+        void *pointer = mmap_map_huge_aligned(bytes);
+        if(pointer) mmap_advise(m, pointer, bytes);
+        return pointer;
+    }
+
+    void *pointer = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return pointer == MAP_FAILED ? NULL : pointer;
+}
+
+/*
+@brief:
+Resize a huge mapping, keeping it on a huge page boundary: in place when
+it already is aligned and the range after it is free, otherwise by
+moving its pages onto a freshly aligned range.
+*/
+static void *
+mmap_remap_huge(const MmapAllocator *m, void *pointer, size_t old_bytes,
+    size_t new_bytes)
+{
+    void *tmp = MAP_FAILED;
+
+    if(mmap_is_huge_aligned(pointer))
+    {
+        tmp = mremap(pointer, old_bytes, new_bytes, 0);
+    }
+
+    if(tmp == MAP_FAILED)
+    {
+        void *target = mmap_map_huge_aligned(new_bytes);
+        if(!target) return NULL;
+
+        tmp = mremap(pointer, old_bytes, new_bytes,
+            MREMAP_MAYMOVE | MREMAP_FIXED, target);
+        if(tmp == MAP_FAILED)
+        {
+            munmap(target, new_bytes);
+            return NULL;
+        }
+    }
+
+    if(new_bytes > old_bytes) mmap_advise(m, tmp, new_bytes);
+
+    return tmp;
+}
+
+static void *
+mmap_allocate(void *context, size_t size)
+{
+    MmapAllocator *m = context;
+
+    if(!mmap_is_large(m, size)) return memory_allocator(size);
+
+    return mmap_map(m, size);
+}
+
+/*
+@brief:
+Resize a block, switching between heap and mapping at the threshold.
+
+@note:
+mapping -> mapping uses mremap and never copies; crossing the threshold
+copies once.
+*/
+static void *
+mmap_reallocate(void *context, void *pointer, size_t old_size,
+    size_t new_size)
+{
+    MmapAllocator *m = context;
+
+    if(!pointer) return mmap_allocate(context, new_size);
+
+    bool old_large = mmap_is_large(m, old_size);
+    bool new_large = mmap_is_large(m, new_size);
+
+    if(!old_large && !new_large) return memory_reallocator(pointer, new_size);
+
+    if(old_large && new_large)
+    {
+        if(new_size > SIZE_MAX - 2 * (size_t)MMAP_HUGE_PAGE_SIZE) return NULL;
+
+        size_t old_bytes = mmap_round_up(m, old_size);
+        size_t new_bytes = mmap_round_up(m, new_size);
+
+        if(old_bytes == new_bytes) return pointer;
+
+        if(mmap_is_huge(m, new_bytes))
+        {
+            return mmap_remap_huge(m, pointer, old_bytes, new_bytes);
+        }
+
+        void *tmp = mremap(pointer, old_bytes, new_bytes, MREMAP_MAYMOVE);
+
+        return tmp == MAP_FAILED ? NULL : tmp;
+    }
+
+    void *tmp = mmap_allocate(context, new_size);
+    if(!tmp) return NULL;
+
+    memcpy(tmp, pointer, old_size < new_size ? old_size : new_size);
+
+    if(old_large)
+    {
+        munmap(pointer, mmap_round_up(m, old_size));
+    }
+    else
+    {
+        memory_free(pointer);
+    }
+
+    return tmp;
+}
+
+static void
+mmap_deallocate(void *context, void *pointer, size_t size)
+{
+    MmapAllocator *m = context;
+
+    if(!pointer) return;
+
+    if(mmap_is_large(m, size))
+    {
+        munmap(pointer, mmap_round_up(m, size));
+        return;
+    }
+
+    memory_free(pointer);
+}
+
+/*
+@brief:
+Create an allocator that backs blocks of threshold bytes or more with
+anonymous mappings.
+
+@pre:
+    - out != NULL
+    - threshold is rounded up to at least one page
+    - flags is 0 or MMAP_ALLOCATOR_HUGE_PAGES (mappings of 2 MiB or more
+      are 2 MiB-aligned whole huge pages with madvise(MADV_HUGEPAGE);
+      the hint is ignored where unsupported)
+
+@ownership:
+    - caller must release with mmap_allocator_destroy() after every block
+      obtained from it has been released
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+mmap_allocator_create(MmapAllocator **out, size_t threshold, unsigned flags)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(flags & ~(unsigned)MMAP_ALLOCATOR_HUGE_PAGES) return EINVAL;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if(page_size <= 0) return EINVAL;
+
+    MmapAllocator *tmp = memory_allocator(sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->allocator.allocate = mmap_allocate;
+    tmp->allocator.reallocate = mmap_reallocate;
+    tmp->allocator.deallocate = mmap_deallocate;
+    tmp->allocator.context = tmp;
+    tmp->page_size = (size_t)page_size;
+    tmp->threshold = threshold < tmp->page_size ? tmp->page_size : threshold;
+    tmp->flags = flags;
+
+    *out = tmp;
+
+    return 0;
+}
+
+/*
+@note:
+Function is null-safe and idempotent.
+*/
+void
+mmap_allocator_destroy(MmapAllocator **allocator)
+{
+    if(!allocator || !*allocator) return;
+
+    memory_free(*allocator);
+    *allocator = NULL;
+}
+
+const Allocator *
+mmap_allocator(MmapAllocator *allocator)
+{
+    return allocator ? &allocator->allocator : NULL;
+}
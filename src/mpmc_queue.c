@@ -0,0 +1,473 @@
+#define _GNU_SOURCE
+
+#include "../include/mpmc_queue.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+Bounded queue for any number of producer and consumer threads (Dmitry
+Vyukov's design).
+
+Every slot carries a sequence number next to its element. A slot at
+position pos is free for the producer that claims pos when its sequence
+equals pos, and holds an element for the consumer that claims pos when
+its sequence equals pos + 1. Producers claim positions with a
+compare-and-swap on enqueue_pos, write the element and publish it by
+storing pos + 1; consumers claim on dequeue_pos, copy the element out
+and hand the slot to the producer one lap later by storing
+pos + capacity. Producers and consumers only meet on a slot, never on a
+shared lock, and each counter has its own cache line.
+
+The blocking calls retry the non-blocking ones, yielding a few times and
+then sleeping on a futex word in between. A successful push checks the
+item waiter count and only when a consumer sleeps bumps the items word
+and wakes one; pops do the same for producers on spaces. When nobody
+sleeps that costs a fence and a read of a line that is rarely written.
+Without futexes they yield instead.
+*/
+enum
+{
+    MPMC_QUEUE_CACHE_LINE = 64,
+    MPMC_QUEUE_SPIN = 16,
+};
+
+_Static_assert(sizeof(atomic_uint) == 4, "futex words are 32 bits");
+
+typedef struct MpmcSlot
+{
+    atomic_size_t sequence;
+    unsigned char data[];
+} MpmcSlot;
+
+/*
+One waiting side: futex word bumped when a sleeper must recheck, plus the
+number of sleepers, alone on a cache line.
+*/
+typedef struct MpmcWait
+{
+    atomic_uint word;
+    atomic_uint waiters;
+    unsigned char pad[MPMC_QUEUE_CACHE_LINE - 2 * sizeof(atomic_uint)];
+} MpmcWait;
+
+/*
+@invariant:
+    - capacity is a power of two >= 2, mask == capacity - 1
+    - stride >= sizeof(MpmcSlot) + element_size, a multiple of the
+      alignment of MpmcSlot
+    - dequeue_pos <= enqueue_pos <= dequeue_pos + capacity
+*/
+struct MpmcQueue
+{
+    unsigned char front_pad[MPMC_QUEUE_CACHE_LINE];
+
+    // read-only after create
+    unsigned char *slots;
+    size_t mask;
+    size_t stride;
+    size_t element_size;
+    const Allocator *allocator;
+    unsigned char shared_pad[MPMC_QUEUE_CACHE_LINE - 4 * sizeof(size_t) -
+        sizeof(const Allocator *)];
+
+    atomic_size_t enqueue_pos;
+    unsigned char enqueue_pad[MPMC_QUEUE_CACHE_LINE - sizeof(atomic_size_t)];
+
+    atomic_size_t dequeue_pos;
+    unsigned char dequeue_pad[MPMC_QUEUE_CACHE_LINE - sizeof(atomic_size_t)];
+
+    MpmcWait items;  // consumers sleep here
+    MpmcWait spaces; // producers sleep here
+};
+
+static inline MpmcSlot *
+mpmc_slot(const MpmcQueue *q, size_t pos)
+{
+    return (MpmcSlot *)(q->slots + (pos & q->mask) * q->stride);
+}
+
+static void
+mpmc_futex_wait(atomic_uint *word, unsigned expected)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (unsigned *)word, FUTEX_WAIT_PRIVATE, expected, NULL,
+        NULL, 0);
+#else
+    (void)word;
+    (void)expected;
+    sched_yield();
+#endif
+}
+
+static void
+mpmc_futex_wake(atomic_uint *word, int count)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (unsigned *)word, FUTEX_WAKE_PRIVATE, count, NULL,
+        NULL, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+/*
+@brief:
+Wake one sleeper of w, if there is any, after a push or pop.
+
+@note:
+Pairs with mpmc_wait(): the sleeper raises waiters before it retries,
+the notifier publishes its slot before it reads waiters, and both fence
+in between, so either the retry sees the slot or the notifier sees the
+sleeper. The sleeper read the word before retrying, so the bump makes
+its futex wait return even if the wake comes first.
+*/
+static void
+mpmc_notify(MpmcWait *w)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if(!atomic_load_explicit(&w->waiters, memory_order_relaxed)) return;
+
+    atomic_fetch_add(&w->word, 1);
+    mpmc_futex_wake(&w->word, 1);
+}
+
+/*
+@brief:
+Create an empty queue holding at least capacity elements, rounded up to
+a power of two (at least 2).
+
+@pre:
+    - out != NULL
+    - element_size > 0, capacity > 0
+    - allocator != NULL, outlives the queue
+
+@ownership:
+    - caller must release with mpmc_destroy() once no thread uses it
+
+@post:
+    On success (return == 0):
+        - *out != NULL, size == 0
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+mpmc_create_with_allocator(MpmcQueue **out, size_t element_size,
+    size_t capacity, const Allocator *allocator)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!element_size || !capacity || !allocator) return EINVAL;
+
+    size_t rounded = 2;
+    while(rounded < capacity)
+    {
+        if(rounded > SIZE_MAX / 2) return EOVERFLOW;
+        rounded *= 2;
+    }
+
+    size_t align = _Alignof(MpmcSlot);
+    size_t stride;
+    size_t bytes;
+    if(add_safe(sizeof(MpmcSlot), element_size, &stride) ||
+        add_safe(stride, align - 1, &stride) ||
+        mul_safe(stride & ~(align - 1), rounded, &bytes))
+    {
+        return EOVERFLOW;
+    }
+    stride &= ~(align - 1);
+
+    MpmcQueue *tmp = allocator->allocate(allocator->context, sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->slots = allocator->allocate(allocator->context, bytes);
+    if(!tmp->slots)
+    {
+        allocator->deallocate(allocator->context, tmp, sizeof(*tmp));
+        return ENOMEM;
+    }
+
+    tmp->mask = rounded - 1;
+    tmp->stride = stride;
+    tmp->element_size = element_size;
+    tmp->allocator = allocator;
+
+    for(size_t pos = 0; pos < rounded; ++pos)
+    {
+        atomic_init(&mpmc_slot(tmp, pos)->sequence, pos);
+    }
+
+    atomic_init(&tmp->enqueue_pos, 0);
+    atomic_init(&tmp->dequeue_pos, 0);
+    atomic_init(&tmp->items.word, 0);
+    atomic_init(&tmp->items.waiters, 0);
+    atomic_init(&tmp->spaces.word, 0);
+    atomic_init(&tmp->spaces.waiters, 0);
+
+    *out = tmp;
+
+    return 0;
+}
+
+int
+mpmc_create(MpmcQueue **out, size_t element_size, size_t capacity)
+{
+    return mpmc_create_with_allocator(out, element_size, capacity,
+        allocator_default());
+}
+
+/*
+@note:
+Function is null-safe and idempotent. Not safe against concurrent use of
+the queue, blocked callers included.
+*/
+void
+mpmc_destroy(MpmcQueue **queue)
+{
+    if(!queue || !*queue) return;
+
+    MpmcQueue *q = *queue;
+    const Allocator *allocator = q->allocator;
+
+    allocator->deallocate(allocator->context, q->slots,
+        (q->mask + 1) * q->stride);
+    allocator->deallocate(allocator->context, q, sizeof(*q));
+
+    *queue = NULL;
+}
+
+static int
+mpmc_enqueue(MpmcQueue *q, const void *value)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for(;;)
+    {
+        slot = mpmc_slot(q, pos);
+        size_t sequence =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)(sequence - pos);
+
+        if(diff == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos,
+                   pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            return EAGAIN; // the slot one lap back is still occupied
+        }
+        else
+        {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->data, value, q->element_size);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    return 0;
+}
+
+static int
+mpmc_dequeue(MpmcQueue *q, void *out_value)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for(;;)
+    {
+        slot = mpmc_slot(q, pos);
+        size_t sequence =
+            atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)(sequence - (pos + 1));
+
+        if(diff == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos,
+                   pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            return EAGAIN; // not written yet
+        }
+        else
+        {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(out_value, slot->data, q->element_size);
+    atomic_store_explicit(&slot->sequence, pos + q->mask + 1,
+        memory_order_release);
+
+    return 0;
+}
+
+/*
+@brief:
+Enqueue a copy of value without blocking. Lock-free; safe from any
+number of threads.
+
+@post:
+    - EAGAIN: the queue is full
+*/
+int
+mpmc_try_push(MpmcQueue *queue, const void *value)
+{
+    if(!queue || !value) return EINVAL;
+
+    int error = mpmc_enqueue(queue, value);
+    if(!error) mpmc_notify(&queue->items);
+
+    return error;
+}
+
+/*
+@brief:
+Dequeue the oldest element into out_value without blocking. Lock-free;
+safe from any number of threads.
+
+@post:
+    - EAGAIN: the queue is empty, or its oldest element is still being
+      written
+*/
+int
+mpmc_try_pop(MpmcQueue *queue, void *out_value)
+{
+    if(!queue || !out_value) return EINVAL;
+
+    int error = mpmc_dequeue(queue, out_value);
+    if(!error) mpmc_notify(&queue->spaces);
+
+    return error;
+}
+
+/*
+@brief:
+Run attempt until it succeeds, spinning briefly and then sleeping on w.
+*/
+static void
+mpmc_wait(MpmcQueue *q, MpmcWait *w, int (*attempt)(MpmcQueue *, void *),
+    void *argument)
+{
+    // the other side usually catches up within a few time slices, far
+    // cheaper than a sleep plus one wake call per operation meanwhile
+    for(int spin = 0; spin < MPMC_QUEUE_SPIN; ++spin)
+    {
+        if(!attempt(q, argument)) return;
+        sched_yield();
+    }
+
+    for(;;)
+    {
+        atomic_fetch_add(&w->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        unsigned word = atomic_load(&w->word);
+
+        if(!attempt(q, argument))
+        {
+            atomic_fetch_sub(&w->waiters, 1);
+            return;
+        }
+
+        mpmc_futex_wait(&w->word, word);
+        atomic_fetch_sub(&w->waiters, 1);
+    }
+}
+
+static int
+mpmc_push_attempt(MpmcQueue *q, void *value)
+{
+    return mpmc_try_push(q, value);
+}
+
+static int
+mpmc_pop_attempt(MpmcQueue *q, void *out_value)
+{
+    return mpmc_try_pop(q, out_value);
+}
+
+/*
+@brief:
+Enqueue a copy of value, sleeping while the queue is full.
+*/
+int
+mpmc_push(MpmcQueue *queue, const void *value)
+{
+    if(!queue || !value) return EINVAL;
+
+    mpmc_wait(queue, &queue->spaces, mpmc_push_attempt, (void *)value);
+
+    return 0;
+}
+
+/*
+@brief:
+Dequeue the oldest element into out_value, sleeping while the queue is
+empty.
+*/
+int
+mpmc_pop(MpmcQueue *queue, void *out_value)
+{
+    if(!queue || !out_value) return EINVAL;
+
+    mpmc_wait(queue, &queue->items, mpmc_pop_attempt, out_value);
+
+    return 0;
+}
+
+/*
+@brief:
+Number of queued elements; a snapshot while other threads are active.
+*/
+size_t
+mpmc_size(const MpmcQueue *queue)
+{
+    if(!queue) return 0;
+
+    // dequeue first: it never passes enqueue, so the difference is >= 0
+    size_t head = atomic_load_explicit(&queue->dequeue_pos,
+        memory_order_acquire);
+    size_t tail = atomic_load_explicit(&queue->enqueue_pos,
+        memory_order_acquire);
+
+    size_t size = tail - head;
+
+    return size > queue->mask + 1 ? queue->mask + 1 : size;
+}
+
+size_t
+mpmc_capacity(const MpmcQueue *queue)
+{
+    return queue ? queue->mask + 1 : 0;
+}
+
+size_t
+mpmc_element_size(const MpmcQueue *queue)
+{
+    return queue ? queue->element_size : 0;
+}
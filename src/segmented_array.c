@@ -0,0 +1,433 @@
+#include "../include/segmented_array.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Growable array whose elements never move.
+
+Storage is a directory of chunks: chunk k holds FIRST << k elements, so
+element i lives in chunk k at offset o where i + FIRST == 2^(k + SHIFT)
++ o, found with one count-leading-zeros. Growing appends the next chunk
+and copies nothing, which keeps element addresses stable for the life of
+the element and avoids the O(n) copy a realloc of one buffer can cost.
+The directory has one entry per bit of size_t and never grows either.
+
+Chunks at least double, so at most half of the storage is unused, as
+with Array's default growth. segmented_array_flatten() produces a
+contiguous Array when an API needs one.
+*/
+enum
+{
+    SEGMENTED_ARRAY_SHIFT = 6,
+    SEGMENTED_ARRAY_FIRST = 1 << SEGMENTED_ARRAY_SHIFT,
+    SEGMENTED_ARRAY_CHUNKS = sizeof(size_t) * CHAR_BIT -
+        SEGMENTED_ARRAY_SHIFT,
+};
+
+/*
+@invariant:
+    - element_size > 0, allocator != NULL
+    - directory[k] != NULL exactly for k < chunks
+    - size <= capacity == FIRST * (2^chunks - 1)
+*/
+struct SegmentedArray
+{
+    size_t size;
+    size_t chunks;
+    size_t element_size;
+    const Allocator *allocator;
+    unsigned char *directory[SEGMENTED_ARRAY_CHUNKS];
+};
+
+static inline size_t
+segmented_array_chunk_capacity(size_t chunk)
+{
+    return (size_t)SEGMENTED_ARRAY_FIRST << chunk;
+}
+
+/*
+@brief:
+Number of elements stored in chunks [0, chunks).
+*/
+static inline size_t
+segmented_array_capacity_of(size_t chunks)
+{
+    return (((size_t)1 << chunks) - 1) * SEGMENTED_ARRAY_FIRST;
+}
+
+static inline unsigned char *
+segmented_array_locate(const SegmentedArray *a, size_t index)
+{
+    size_t j = index + SEGMENTED_ARRAY_FIRST;
+    size_t high = (sizeof(unsigned long long) * CHAR_BIT - 1) -
+        (size_t)__builtin_clzll((unsigned long long)j);
+
+    size_t offset = j - ((size_t)1 << high);
+
+    return a->directory[high - SEGMENTED_ARRAY_SHIFT] +
+        offset * a->element_size;
+}
+
+/*
+@brief:
+Create an empty segmented array for elements of element_size bytes. No
+storage is allocated until the first push or reserve.
+
+@pre:
+    - out != NULL
+    - element_size > 0
+    - allocator != NULL, outlives the array
+
+@ownership:
+    - caller must release with segmented_array_destroy()
+
+@post:
+    On success (return == 0):
+        - *out != NULL, size == 0, capacity == 0
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+segmented_array_create_with_allocator(SegmentedArray **out,
+    size_t element_size, const Allocator *allocator)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!element_size || !allocator) return EINVAL;
+
+    SegmentedArray *tmp = allocator->allocate(allocator->context,
+        sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->size = 0;
+    tmp->chunks = 0;
+    tmp->element_size = element_size;
+    tmp->allocator = allocator;
+
+    for(size_t k = 0; k < SEGMENTED_ARRAY_CHUNKS; ++k)
+    {
+        tmp->directory[k] = NULL;
+    }
+
+    *out = tmp;
+
+    return 0;
+}
+
+int
+segmented_array_create(SegmentedArray **out, size_t element_size)
+{
+    return segmented_array_create_with_allocator(out, element_size,
+        allocator_default());
+}
+
+static void
+segmented_array_release_chunks(SegmentedArray *a, size_t keep)
+{
+    while(a->chunks > keep)
+    {
+        --a->chunks;
+        a->allocator->deallocate(a->allocator->context,
+            a->directory[a->chunks],
+            segmented_array_chunk_capacity(a->chunks) * a->element_size);
+        a->directory[a->chunks] = NULL;
+    }
+}
+
+/*
+@note:
+Function is null-safe and idempotent.
+*/
+void
+segmented_array_destroy(SegmentedArray **array)
+{
+    if(!array || !*array) return;
+
+    SegmentedArray *a = *array;
+    const Allocator *allocator = a->allocator;
+
+    segmented_array_release_chunks(a, 0);
+    allocator->deallocate(allocator->context, a, sizeof(*a));
+
+    *array = NULL;
+}
+
+/*
+@brief:
+Append chunks until at least min_capacity elements fit. No element
+moves.
+
+@post:
+    On success (return == 0):
+        - capacity >= min_capacity
+
+    On failure (return != 0):
+        - size and contents are unchanged; chunks appended before the
+          failing one are kept
+*/
+int
+segmented_array_reserve(SegmentedArray *array, size_t min_capacity)
+{
+    if(!array) return EINVAL;
+
+    while(segmented_array_capacity_of(array->chunks) < min_capacity)
+    {
+        if(array->chunks == SEGMENTED_ARRAY_CHUNKS - 1) return EOVERFLOW;
+
+        size_t bytes;
+        if(mul_safe(segmented_array_chunk_capacity(array->chunks),
+               array->element_size, &bytes))
+        {
+            return EOVERFLOW;
+        }
+
+        unsigned char *chunk = array->allocator->allocate(
+            array->allocator->context, bytes);
+        if(!chunk) return ENOMEM;
+
+        array->directory[array->chunks++] = chunk;
+    }
+
+    return 0;
+}
+
+/*
+@brief:
+Free every chunk that holds no element.
+*/
+int
+segmented_array_shrink_fit(SegmentedArray *array)
+{
+    if(!array) return EINVAL;
+
+    size_t keep = 0;
+    while(segmented_array_capacity_of(keep) < array->size) ++keep;
+
+    segmented_array_release_chunks(array, keep);
+
+    return 0;
+}
+
+/*
+@brief:
+Append count elements copied from values.
+
+@post:
+    On success (return == 0):
+        - size increased by count; existing elements did not move
+
+    On failure (return != 0):
+        - size and contents are unchanged
+*/
+int
+segmented_array_push_back_n(SegmentedArray *array, const void *values,
+    size_t count)
+{
+    if(!array || (!values && count)) return EINVAL;
+    if(count == 0) return 0;
+
+    if(count > SIZE_MAX - array->size) return EOVERFLOW;
+
+    int error = segmented_array_reserve(array, array->size + count);
+    if(error) return error;
+
+    const unsigned char *src = values;
+    size_t es = array->element_size;
+
+    // one copy per chunk touched
+    while(count)
+    {
+        size_t j = array->size + SEGMENTED_ARRAY_FIRST;
+        size_t high = (sizeof(unsigned long long) * CHAR_BIT - 1) -
+            (size_t)__builtin_clzll((unsigned long long)j);
+        size_t room = ((size_t)1 << (high + 1)) - j;
+        size_t n = count < room ? count : room;
+
+        memcpy(segmented_array_locate(array, array->size), src, n * es);
+
+        array->size += n;
+        src += n * es;
+        count -= n;
+    }
+
+    return 0;
+}
+
+int
+segmented_array_push_back(SegmentedArray *array, const void *value)
+{
+    if(!value) return EINVAL;
+
+    return segmented_array_push_back_n(array, value, 1);
+}
+
+/*
+@note:
+No-op on an empty array. Keeps the storage.
+*/
+void
+segmented_array_pop_back(SegmentedArray *array)
+{
+    if(!array || array->size == 0) return;
+
+    --array->size;
+}
+
+/*
+@note:
+Keeps the storage; use segmented_array_shrink_fit() to release it.
+*/
+void
+segmented_array_clear(SegmentedArray *array)
+{
+    if(array) array->size = 0;
+}
+
+int
+segmented_array_get(const SegmentedArray *array, size_t index,
+    void *out_value)
+{
+    if(!array || !out_value || index >= array->size) return EINVAL;
+
+    memcpy(out_value, segmented_array_locate(array, index),
+        array->element_size);
+
+    return 0;
+}
+
+int
+segmented_array_set(SegmentedArray *array, size_t index, const void *value)
+{
+    if(!array || !value || index >= array->size) return EINVAL;
+
+    memcpy(segmented_array_locate(array, index), value,
+        array->element_size);
+
+    return 0;
+}
+
+/*
+@brief:
+Address of element index, or NULL when index >= size.
+
+@note:
+The address stays valid until the element is popped or cleared and its
+chunk released by segmented_array_shrink_fit() or destroy; pushes never
+invalidate it.
+*/
+void *
+segmented_array_at(SegmentedArray *array, size_t index)
+{
+    if(!array || index >= array->size) return NULL;
+
+    return segmented_array_locate(array, index);
+}
+
+const void *
+segmented_array_at_const(const SegmentedArray *array, size_t index)
+{
+    if(!array || index >= array->size) return NULL;
+
+    return segmented_array_locate(array, index);
+}
+
+/*
+@brief:
+Contiguous storage of chunk and the number of elements in it, for bulk
+loops that walk the array chunk by chunk.
+
+@post:
+    - returns NULL (and *out_count == 0) once chunk holds no element, so
+      for(k = 0; (p = segmented_array_chunk(a, k, &n)); ++k) visits
+      every element in index order
+*/
+void *
+segmented_array_chunk(SegmentedArray *array, size_t chunk,
+    size_t *out_count)
+{
+    if(out_count) *out_count = 0;
+    if(!array || !out_count || chunk >= array->chunks) return NULL;
+
+    size_t first = segmented_array_capacity_of(chunk);
+    if(first >= array->size) return NULL;
+
+    size_t count = array->size - first;
+    size_t capacity = segmented_array_chunk_capacity(chunk);
+
+    *out_count = count < capacity ? count : capacity;
+
+    return array->directory[chunk];
+}
+
+/*
+@brief:
+Replace the contents of out with a contiguous copy of array.
+
+@pre:
+    - array != NULL, out != NULL
+    - element sizes match
+
+@post:
+    On success (return == 0):
+        - size(out) == size(array), out[i] == array[i]
+
+    On failure (return != 0):
+        - out is unchanged
+*/
+int
+segmented_array_flatten(const SegmentedArray *array, Array *out)
+{
+    if(!array || !out) return EINVAL;
+    if(array_element_size(out) != array->element_size) return EINVAL;
+
+    size_t current = array_size(out);
+
+    // resize first: every slot is overwritten below
+    void *tail = NULL;
+    int error = array->size > current
+        ? array_push_back_uninit(out, array->size - current, &tail)
+        : array_erase_range(out, array->size, current - array->size);
+    if(error) return error;
+
+    unsigned char *dst = array_data(out);
+    size_t es = array->element_size;
+
+    for(size_t k = 0, done = 0; done < array->size; ++k)
+    {
+        size_t capacity = segmented_array_chunk_capacity(k);
+        size_t n = array->size - done < capacity ? array->size - done
+                                                 : capacity;
+
+        memcpy(dst + done * es, array->directory[k], n * es);
+        done += n;
+    }
+
+    return 0;
+}
+
+size_t
+segmented_array_capacity(const SegmentedArray *array)
+{
+    return array ? segmented_array_capacity_of(array->chunks) : 0;
+}
+
+size_t
+segmented_array_size(const SegmentedArray *array)
+{
+    return array ? array->size : 0;
+}
+
+size_t
+segmented_array_element_size(const SegmentedArray *array)
+{
+    return array ? array->element_size : 0;
+}
@@ -0,0 +1,327 @@
+#include "../include/spsc_ring.h"
+
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+Bounded queue for exactly one producer and one consumer thread.
+
+The slots are an Array sized once at create and never resized, so the
+element storage and allocator are the Array's own. Capacity is a power
+of two; head and tail run freely and are masked on use, and tail - head
+is the number of queued elements.
+
+The producer owns tail and the consumer owns head, each on its own cache
+line together with a private copy of the other index. The shared index
+is only reloaded when the copy says the ring is full (or empty), so a
+batch of pushes or pops touches the other side's line once at most.
+*/
+enum
+{
+    SPSC_RING_CACHE_LINE = 64,
+};
+
+/*
+@invariant:
+    - storage holds capacity elements, capacity is a power of two
+    - mask == capacity - 1, data == array_data(storage)
+    - head <= tail <= head + capacity
+*/
+struct SpscRing
+{
+    unsigned char front_pad[SPSC_RING_CACHE_LINE];
+
+    // read-only after create
+    unsigned char *data;
+    size_t mask;
+    size_t element_size;
+    Array *storage;
+    const Allocator *allocator;
+    unsigned char shared_pad[SPSC_RING_CACHE_LINE - 4 * sizeof(size_t) -
+        sizeof(const Allocator *)];
+
+    // producer
+    atomic_size_t tail;
+    size_t head_cache;
+    unsigned char tail_pad[SPSC_RING_CACHE_LINE - 2 * sizeof(size_t)];
+
+    // consumer
+    atomic_size_t head;
+    size_t tail_cache;
+    unsigned char head_pad[SPSC_RING_CACHE_LINE - 2 * sizeof(size_t)];
+};
+
+/*
+@brief:
+Create an empty ring holding at least capacity elements, rounded up to
+a power of two.
+
+@pre:
+    - out != NULL
+    - element_size > 0, capacity > 0
+    - allocator != NULL, outlives the ring
+
+@ownership:
+    - caller must release with spsc_destroy() once neither side uses it
+
+@post:
+    On success (return == 0):
+        - *out != NULL, size == 0
+
+    On failure (return != 0):
+        - *out == NULL
+*/
+int
+spsc_create_with_allocator(SpscRing **out, size_t element_size,
+    size_t capacity, const Allocator *allocator)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(!element_size || !capacity || !allocator) return EINVAL;
+
+    size_t rounded = 1;
+    while(rounded < capacity)
+    {
+        if(rounded > SIZE_MAX / 2) return EOVERFLOW;
+        rounded *= 2;
+    }
+
+    SpscRing *tmp = allocator->allocate(allocator->context, sizeof(*tmp));
+    if(!tmp) return ENOMEM;
+
+    tmp->storage = NULL;
+
+    void *data = NULL;
+    int error = array_create_with_allocator(&tmp->storage, element_size,
+        allocator);
+    if(!error) error = array_reserve_exact(tmp->storage, rounded);
+    if(!error) error = array_push_back_uninit(tmp->storage, rounded, &data);
+
+    if(error)
+    {
+        array_destroy(&tmp->storage);
+        allocator->deallocate(allocator->context, tmp, sizeof(*tmp));
+        return error;
+    }
+
+    tmp->data = data;
+    tmp->mask = rounded - 1;
+    tmp->element_size = element_size;
+    tmp->allocator = allocator;
+
+    atomic_init(&tmp->tail, 0);
+    tmp->head_cache = 0;
+    atomic_init(&tmp->head, 0);
+    tmp->tail_cache = 0;
+
+    *out = tmp;
+
+    return 0;
+}
+
+int
+spsc_create(SpscRing **out, size_t element_size, size_t capacity)
+{
+    return spsc_create_with_allocator(out, element_size, capacity,
+        allocator_default());
+}
+
+/*
+@note:
+Function is null-safe and idempotent.
+*/
+void
+spsc_destroy(SpscRing **ring)
+{
+    if(!ring || !*ring) return;
+
+    SpscRing *r = *ring;
+    const Allocator *allocator = r->allocator;
+
+    array_destroy(&r->storage);
+    allocator->deallocate(allocator->context, r, sizeof(*r));
+
+    *ring = NULL;
+}
+
+/*
+@brief:
+Copy count elements between the ring slots starting at index and a flat
+buffer, splitting the copy where the slots wrap.
+*/
+static void
+spsc_copy_in(SpscRing *r, size_t index, const unsigned char *src,
+    size_t count)
+{
+    size_t es = r->element_size;
+    size_t slot = index & r->mask;
+    size_t first = r->mask + 1 - slot;
+    if(first > count) first = count;
+
+    memcpy(r->data + slot * es, src, first * es);
+    if(count > first) memcpy(r->data, src + first * es, (count - first) * es);
+}
+
+static void
+spsc_copy_out(const SpscRing *r, size_t index, unsigned char *dst,
+    size_t count)
+{
+    size_t es = r->element_size;
+    size_t slot = index & r->mask;
+    size_t first = r->mask + 1 - slot;
+    if(first > count) first = count;
+
+    memcpy(dst, r->data + slot * es, first * es);
+    if(count > first) memcpy(dst + first * es, r->data, (count - first) * es);
+}
+
+/*
+@brief:
+Enqueue up to count elements in order, as many as fit. Producer thread
+only.
+
+@pre:
+    - out_pushed may be NULL; otherwise receives the number enqueued
+
+@post:
+    On success (return == 0):
+        - the first *out_pushed values are visible to the consumer
+
+    On failure (return != 0):
+        - EAGAIN: count > 0 and the ring is full; nothing was enqueued
+*/
+int
+spsc_push_n(SpscRing *ring, const void *values, size_t count,
+    size_t *out_pushed)
+{
+    if(out_pushed) *out_pushed = 0;
+    if(!ring || (!values && count)) return EINVAL;
+    if(count == 0) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t capacity = ring->mask + 1;
+
+    size_t space = capacity - (tail - ring->head_cache);
+    if(space < count)
+    {
+        ring->head_cache =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+        space = capacity - (tail - ring->head_cache);
+    }
+
+    if(space == 0) return EAGAIN;
+    if(count > space) count = space;
+
+    spsc_copy_in(ring, tail, values, count);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+
+    if(out_pushed) *out_pushed = count;
+
+    return 0;
+}
+
+/*
+@post:
+    - EAGAIN: the ring is full
+*/
+int
+spsc_push(SpscRing *ring, const void *value)
+{
+    if(!value) return EINVAL;
+
+    return spsc_push_n(ring, value, 1, NULL);
+}
+
+/*
+@brief:
+Dequeue up to count elements in order into out_values. Consumer thread
+only.
+
+@pre:
+    - out_popped may be NULL; otherwise receives the number dequeued
+
+@post:
+    On success (return == 0):
+        - the first *out_popped slots of out_values are filled
+
+    On failure (return != 0):
+        - EAGAIN: count > 0 and the ring is empty
+*/
+int
+spsc_pop_n(SpscRing *ring, void *out_values, size_t count,
+    size_t *out_popped)
+{
+    if(out_popped) *out_popped = 0;
+    if(!ring || (!out_values && count)) return EINVAL;
+    if(count == 0) return 0;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    size_t available = ring->tail_cache - head;
+    if(available < count)
+    {
+        ring->tail_cache =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+        available = ring->tail_cache - head;
+    }
+
+    if(available == 0) return EAGAIN;
+    if(count > available) count = available;
+
+    spsc_copy_out(ring, head, out_values, count);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+
+    if(out_popped) *out_popped = count;
+
+    return 0;
+}
+
+/*
+@post:
+    - EAGAIN: the ring is empty
+*/
+int
+spsc_pop(SpscRing *ring, void *out_value)
+{
+    if(!out_value) return EINVAL;
+
+    return spsc_pop_n(ring, out_value, 1, NULL);
+}
+
+/*
+@brief:
+Number of queued elements. Exact from either side when the other is
+idle, otherwise a snapshot.
+*/
+size_t
+spsc_size(const SpscRing *ring)
+{
+    if(!ring) return 0;
+
+    // head first: it never passes tail, so the difference cannot wrap
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    size_t size = tail - head;
+
+    return size > ring->mask + 1 ? ring->mask + 1 : size;
+}
+
+size_t
+spsc_capacity(const SpscRing *ring)
+{
+    return ring ? ring->mask + 1 : 0;
+}
+
+size_t
+spsc_element_size(const SpscRing *ring)
+{
+    return ring ? ring->element_size : 0;
+}
@@ -0,0 +1,478 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/thread_pool.h"
+
+#include "../include/allocator.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/*
+Work-stealing pool for parallel loops.
+
+Every worker owns a deque of ranges; a thread running a range splits it
+in halves down to the grain, pushing the upper halves onto the bottom of
+its own deque and running the lowest piece itself. It then pops its own
+deque from the bottom (smallest, most recently split, cache-warm ranges)
+and, when that is empty, steals from the top of another deque (the
+largest ranges, so one steal moves a lot of work). Threads that call
+thread_pool_for() from outside the pool share one extra deque and work
+alongside the pool until their loop is done.
+
+Deques are short (a chain of halvings holds at most one range per bit of
+the count) and guarded by a mutex each; the lock is only contended when
+a thief and the owner meet on the same deque.
+*/
+enum
+{
+    THREAD_POOL_DEQUE_CAPACITY = 64,
+    THREAD_POOL_MAX_THREADS = 256,
+};
+
+typedef struct ThreadPoolJob
+{
+    ThreadPoolRangeFn fn;
+    void *context;
+    size_t grain;
+    atomic_size_t pending; // iterations not yet run
+} ThreadPoolJob;
+
+typedef struct ThreadPoolRange
+{
+    ThreadPoolJob *job;
+    size_t begin;
+    size_t end;
+} ThreadPoolRange;
+
+/*
+@invariant:
+    - top <= bottom, bottom - top <= THREAD_POOL_DEQUE_CAPACITY
+    - ranges live in slots [top, bottom) modulo the capacity
+*/
+typedef struct ThreadPoolDeque
+{
+    pthread_mutex_t lock;
+    size_t top;
+    size_t bottom;
+    ThreadPoolRange ranges[THREAD_POOL_DEQUE_CAPACITY];
+} ThreadPoolDeque;
+
+struct ThreadPool
+{
+    size_t threads;
+    pthread_t *workers;
+    ThreadPoolDeque *deques; // threads + 1, the last for outside callers
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_size_t queued;
+    atomic_size_t sleepers;
+    atomic_bool stop;
+};
+
+typedef struct ThreadPoolSelf
+{
+    ThreadPool *pool;
+    size_t index;
+    uint64_t random;
+} ThreadPoolSelf;
+
+static _Thread_local ThreadPoolSelf thread_pool_self;
+
+static pthread_once_t thread_pool_default_once = PTHREAD_ONCE_INIT;
+static ThreadPool *thread_pool_default_pool;
+
+static bool
+thread_pool_push(ThreadPool *pool, ThreadPoolDeque *d, ThreadPoolRange range)
+{
+    pthread_mutex_lock(&d->lock);
+
+    bool pushed = d->bottom - d->top < THREAD_POOL_DEQUE_CAPACITY;
+    if(pushed)
+    {
+        d->ranges[d->bottom % THREAD_POOL_DEQUE_CAPACITY] = range;
+        ++d->bottom;
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    if(!pushed) return false;
+
+    atomic_fetch_add(&pool->queued, 1);
+
+    // pairs with the sleepers/queued check in thread_pool_sleep
+    if(atomic_load(&pool->sleepers))
+    {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return true;
+}
+
+static bool
+thread_pool_take(ThreadPool *pool, ThreadPoolDeque *d, bool bottom,
+    ThreadPoolRange *out)
+{
+    pthread_mutex_lock(&d->lock);
+
+    bool taken = d->bottom != d->top;
+    if(taken && bottom)
+    {
+        --d->bottom;
+        *out = d->ranges[d->bottom % THREAD_POOL_DEQUE_CAPACITY];
+    }
+    else if(taken)
+    {
+        *out = d->ranges[d->top % THREAD_POOL_DEQUE_CAPACITY];
+        ++d->top;
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    if(taken) atomic_fetch_sub(&pool->queued, 1);
+
+    return taken;
+}
+
+static uint64_t
+thread_pool_random(ThreadPoolSelf *self)
+{
+    uint64_t x = self->random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    self->random = x;
+    return x;
+}
+
+/*
+@brief:
+Pop the caller's own deque, else steal from the others starting at a
+random victim.
+*/
+static bool
+thread_pool_find(ThreadPool *pool, size_t index, ThreadPoolRange *out)
+{
+    if(thread_pool_take(pool, &pool->deques[index], true, out)) return true;
+
+    size_t count = pool->threads + 1;
+    size_t start = (size_t)(thread_pool_random(&thread_pool_self) % count);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        size_t victim = (start + i) % count;
+        if(victim == index) continue;
+
+        if(thread_pool_take(pool, &pool->deques[victim], false, out))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+thread_pool_run(ThreadPool *pool, size_t index, ThreadPoolRange range)
+{
+    ThreadPoolJob *job = range.job;
+
+    while(range.end - range.begin > job->grain)
+    {
+        size_t mid = range.begin + (range.end - range.begin) / 2;
+
+        ThreadPoolRange upper = {job, mid, range.end};
+        if(!thread_pool_push(pool, &pool->deques[index], upper)) break;
+
+        range.end = mid;
+    }
+
+    job->fn(job->context, range.begin, range.end);
+
+    // last access to job: its owner may return as soon as this hits 0
+    atomic_fetch_sub(&job->pending, range.end - range.begin);
+}
+
+static void
+thread_pool_sleep(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+
+    atomic_fetch_add(&pool->sleepers, 1);
+    while(!atomic_load(&pool->queued) && !atomic_load(&pool->stop))
+    {
+        pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    atomic_fetch_sub(&pool->sleepers, 1);
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct ThreadPoolStart
+{
+    ThreadPool *pool;
+    size_t index;
+} ThreadPoolStart;
+
+static void *
+thread_pool_worker(void *argument)
+{
+    ThreadPoolStart start = *(ThreadPoolStart *)argument;
+    memory_free(argument);
+
+    ThreadPool *pool = start.pool;
+
+    thread_pool_self.pool = pool;
+    thread_pool_self.index = start.index;
+    thread_pool_self.random = 0x9E3779B97F4A7C15u * (start.index + 1);
+
+    while(!atomic_load(&pool->stop))
+    {
+        ThreadPoolRange range;
+        if(thread_pool_find(pool, start.index, &range))
+        {
+            thread_pool_run(pool, start.index, range);
+        }
+        else
+        {
+            thread_pool_sleep(pool);
+        }
+    }
+
+    return NULL;
+}
+
+static void
+thread_pool_shutdown(ThreadPool *pool, size_t started)
+{
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->stop, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(size_t i = 0; i < started; ++i) pthread_join(pool->workers[i], NULL);
+
+    for(size_t i = 0; i <= pool->threads; ++i)
+    {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+
+    memory_free(pool->deques);
+    memory_free(pool->workers);
+    memory_free(pool);
+}
+
+/*
+@brief:
+Start a pool of worker threads.
+
+@pre:
+    - out != NULL
+    - threads <= THREAD_POOL_MAX_THREADS; 0 starts one worker per online
+      CPU besides the calling thread (which works inside
+      thread_pool_for() too)
+
+@ownership:
+    - caller must release with thread_pool_destroy() once no
+      thread_pool_for() on it is running
+
+@post:
+    On success (return == 0):
+        - *out != NULL
+
+    On failure (return != 0):
+        - *out == NULL
+        - EAGAIN when a worker thread cannot be started
+*/
+int
+thread_pool_create(ThreadPool **out, size_t threads)
+{
+    if(!out) return EINVAL;
+
+    *out = NULL;
+
+    if(threads > THREAD_POOL_MAX_THREADS) return EINVAL;
+
+    if(threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 1 ? (size_t)online - 1 : 0;
+        if(threads > THREAD_POOL_MAX_THREADS) threads = THREAD_POOL_MAX_THREADS;
+    }
+
+    ThreadPool *pool = memory_allocator(sizeof(*pool));
+    if(!pool) return ENOMEM;
+
+    // + 1: no zero-byte request for a pool without workers
+    pool->threads = threads;
+    pool->workers = memory_allocator((threads + 1) * sizeof(pthread_t));
+    pool->deques = memory_allocator((threads + 1) * sizeof(ThreadPoolDeque));
+
+    if(!pool->workers || !pool->deques)
+    {
+        memory_free(pool->deques);
+        memory_free(pool->workers);
+        memory_free(pool);
+        return ENOMEM;
+    }
+
+    for(size_t i = 0; i <= threads; ++i)
+    {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->deques[i].top = 0;
+        pool->deques[i].bottom = 0;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->sleepers, 0);
+    atomic_init(&pool->stop, false);
+
+    for(size_t i = 0; i < threads; ++i)
+    {
+        ThreadPoolStart *start = memory_allocator(sizeof(*start));
+        int error = start ? 0 : ENOMEM;
+
+        if(start)
+        {
+            start->pool = pool;
+            start->index = i;
+
+            error = pthread_create(&pool->workers[i], NULL, thread_pool_worker,
+                start);
+            if(error)
+            {
+                memory_free(start);
+                error = EAGAIN;
+            }
+        }
+
+        if(error)
+        {
+            thread_pool_shutdown(pool, i);
+            return error;
+        }
+    }
+
+    *out = pool;
+
+    return 0;
+}
+
+/*
+@note:
+Function is null-safe and idempotent. Joins every worker.
+*/
+void
+thread_pool_destroy(ThreadPool **pool)
+{
+    if(!pool || !*pool) return;
+
+    thread_pool_shutdown(*pool, (*pool)->threads);
+    *pool = NULL;
+}
+
+/*
+@brief:
+Run fn over [0, count) in ranges of at most grain iterations, on the
+pool and the calling thread, and return when every range has finished.
+
+@pre:
+    - pool != NULL, fn != NULL
+    - grain == 0 behaves as 1
+    - fn is safe to call concurrently on disjoint ranges
+
+@post:
+    - every iteration in [0, count) was passed to fn exactly once
+
+@note:
+May be called from inside fn (nested loops) and from several threads at
+once; a waiting caller keeps running ranges of any loop on the pool.
+*/
+int
+thread_pool_for(ThreadPool *pool, size_t count, size_t grain,
+    ThreadPoolRangeFn fn, void *context)
+{
+    if(!pool || !fn) return EINVAL;
+    if(count == 0) return 0;
+
+    ThreadPoolJob job = {
+        .fn = fn,
+        .context = context,
+        .grain = grain ? grain : 1,
+    };
+    atomic_init(&job.pending, count);
+
+    size_t index = pool->threads; // shared deque of outside callers
+    if(thread_pool_self.pool == pool)
+    {
+        index = thread_pool_self.index;
+    }
+    else if(!thread_pool_self.random)
+    {
+        thread_pool_self.random = (uint64_t)(uintptr_t)&thread_pool_self | 1;
+    }
+
+    thread_pool_run(pool, index, (ThreadPoolRange){&job, 0, count});
+
+    while(atomic_load(&job.pending))
+    {
+        ThreadPoolRange range;
+        if(thread_pool_find(pool, index, &range))
+        {
+            thread_pool_run(pool, index, range);
+        }
+        else
+        {
+            sched_yield(); // the rest is running on other threads
+        }
+    }
+
+    return 0;
+}
+
+/*
+@brief:
+Number of worker threads, not counting callers of thread_pool_for().
+*/
+size_t
+thread_pool_size(const ThreadPool *pool)
+{
+    return pool ? pool->threads : 0;
+}
+
+static void
+thread_pool_default_init(void)
+{
+    if(thread_pool_create(&thread_pool_default_pool, 0))
+    {
+        thread_pool_default_pool = NULL;
+    }
+}
+
+/*
+@brief:
+Process-wide pool with one worker per online CPU besides the caller,
+started on first use and kept for the process lifetime.
+
+@note:
+Returns NULL when the pool could not be started.
+*/
+ThreadPool *
+thread_pool_default(void)
+{
+    pthread_once(&thread_pool_default_once, thread_pool_default_init);
+
+    return thread_pool_default_pool;
+}
@@ -0,0 +1,204 @@
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_allocator_trace_counts(void)
+{
+    assert(allocator_trace_start(1u << 7) == EINVAL);
+    assert(allocator_trace_start(0) == 0);
+    assert(allocator_trace_start(0) == EBUSY);
+
+    AllocatorTraceStats stats;
+
+    void *p = memory_allocator(100);
+    assert(p);
+    p = memory_reallocator(p, 200);
+    p = memory_reallocator(p, 400);
+    assert(p);
+
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.allocations == 1);
+    assert(stats.reallocations == 2);
+    assert(stats.live_blocks == 1);
+    assert(stats.live_bytes == 400);
+    assert(stats.peak_bytes == 400);
+
+    memory_free(p);
+
+    // arrays go through the same layer
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+    for(int i = 0; i < 1000; ++i) assert(array_push_back(a, &i) == 0);
+
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.frees == 1);
+    assert(stats.live_blocks == 2); // header and element storage
+    assert(stats.peak_bytes >= 1000 * sizeof(int));
+
+    // report with live blocks, then after everything was released
+    FILE *out = fopen("/dev/null", "w");
+    assert(out);
+    allocator_trace_report(out);
+
+    array_destroy(&a);
+
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.live_blocks == 0);
+    assert(stats.live_bytes == 0);
+    allocator_trace_report(out);
+
+    const AllocatorTraceStats last MAYBE_UNUSED = stats;
+
+    fclose(out);
+
+    allocator_trace_stop();
+    allocator_trace_stop();
+
+    // untraced blocks are ignored
+    p = memory_allocator(16);
+    memory_free(p);
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.allocations == last.allocations);
+    assert(stats.frees == last.frees);
+}
+
+static void
+test_allocator_trace_many(void)
+{
+    enum
+    {
+        COUNT = 5000,
+    };
+
+    static void *blocks[COUNT];
+
+    assert(allocator_trace_start(0) == 0);
+
+    // forces the table to grow and exercises deletion from long probes
+    for(size_t i = 0; i < COUNT; ++i)
+    {
+        blocks[i] = memory_allocator(i % 64 + 1);
+        assert(blocks[i]);
+    }
+    for(size_t i = 0; i < COUNT; i += 2) memory_free(blocks[i]);
+
+    AllocatorTraceStats stats MAYBE_UNUSED;
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.live_blocks == COUNT / 2);
+    assert(stats.peak_blocks == COUNT);
+
+    for(size_t i = 1; i < COUNT; i += 2) memory_free(blocks[i]);
+
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.live_blocks == 0);
+    assert(stats.frees == COUNT);
+
+    allocator_trace_stop();
+}
+
+enum
+{
+    TRACE_TEST_THREADS = 4,
+    TRACE_TEST_ROUNDS = 2000,
+    TRACE_TEST_KEPT = 8,
+};
+
+/*
+Grows blocks through realloc while the other threads allocate and free,
+so freed addresses are handed out again right away.
+*/
+static void *
+trace_test_worker(void *argument)
+{
+    void **kept = argument;
+
+    for(size_t i = 0; i < TRACE_TEST_ROUNDS; ++i)
+    {
+        void *p = memory_allocator(16);
+        assert(p);
+        for(size_t size = 32; size <= 512; size *= 2)
+        {
+            p = memory_reallocator(p, size);
+            assert(p);
+        }
+
+        void *q = memory_allocator(24);
+        assert(q);
+        memory_free(p);
+        memory_free(q);
+    }
+
+    for(size_t i = 0; i < TRACE_TEST_KEPT; ++i)
+    {
+        kept[i] = memory_allocator(8);
+        assert(kept[i]);
+        kept[i] = memory_reallocator(kept[i], 64);
+        assert(kept[i]);
+    }
+
+    return NULL;
+}
+
+static void
+test_allocator_trace_threads(void)
+{
+    static void *kept[TRACE_TEST_THREADS][TRACE_TEST_KEPT];
+    pthread_t threads[TRACE_TEST_THREADS];
+
+    assert(allocator_trace_start(0) == 0);
+
+    for(size_t t = 0; t < TRACE_TEST_THREADS; ++t)
+    {
+        assert(pthread_create(&threads[t], NULL, trace_test_worker,
+                   kept[t]) == 0);
+    }
+    for(size_t t = 0; t < TRACE_TEST_THREADS; ++t)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    const uint64_t rounds = (uint64_t)TRACE_TEST_THREADS * TRACE_TEST_ROUNDS;
+    const uint64_t kept_blocks =
+        (uint64_t)TRACE_TEST_THREADS * TRACE_TEST_KEPT;
+
+    AllocatorTraceStats stats MAYBE_UNUSED;
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.untracked == 0);
+    assert(stats.allocations == 2 * rounds + kept_blocks);
+    assert(stats.reallocations == 5 * rounds + kept_blocks);
+    assert(stats.frees == 2 * rounds);
+    assert(stats.live_blocks == kept_blocks);
+    assert(stats.live_bytes == kept_blocks * 64);
+
+    for(size_t t = 0; t < TRACE_TEST_THREADS; ++t)
+    {
+        for(size_t i = 0; i < TRACE_TEST_KEPT; ++i) memory_free(kept[t][i]);
+    }
+
+    assert(allocator_trace_stats(&stats) == 0);
+    assert(stats.live_blocks == 0);
+    assert(stats.live_bytes == 0);
+    assert(stats.frees == 2 * rounds + kept_blocks);
+
+    allocator_trace_stop();
+}
+
+void
+run_allocator_trace_tests(void)
+{
+    test_allocator_trace_counts();
+    test_allocator_trace_many();
+    test_allocator_trace_threads();
+}
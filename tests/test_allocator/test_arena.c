@@ -0,0 +1,141 @@
+#include "../include/arena.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdalign.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_arena_create_invalid(void)
+{
+    assert(arena_create(NULL, 0) == EINVAL);
+}
+
+static void
+test_arena_allocate_aligned(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 0) == 0);
+
+    const Allocator *allocator = arena_allocator(arena);
+    assert(allocator);
+
+    for(size_t i = 1; i < 64; ++i)
+    {
+        void *p MAYBE_UNUSED = allocator->allocate(allocator->context, i);
+        assert(p);
+        assert((uintptr_t)p % alignof(max_align_t) == 0);
+    }
+
+    assert(arena_bytes_used(arena) > 0);
+    assert(arena_bytes_reserved(arena) >= arena_bytes_used(arena));
+
+    arena_destroy(&arena);
+    assert(arena == NULL);
+    arena_destroy(&arena);
+}
+
+static void
+test_arena_reallocate_last_in_place(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 4096) == 0);
+
+    const Allocator *allocator = arena_allocator(arena);
+
+    int *p = allocator->allocate(allocator->context, 4 * sizeof(int));
+    assert(p);
+    for(int i = 0; i < 4; ++i) p[i] = i;
+
+    int *q MAYBE_UNUSED =
+        allocator->reallocate(allocator->context, p, 4 * sizeof(int),
+            64 * sizeof(int));
+    assert(q == p);
+    for(int i = 0; i < 4; ++i) assert(q[i] == i);
+
+    arena_destroy(&arena);
+}
+
+static void
+test_arena_array_lifecycle(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 1024) == 0);
+
+    Array *a = NULL;
+    assert(array_create_with_allocator(&a, sizeof(int),
+               arena_allocator(arena)) == 0);
+
+    for(int i = 0; i < 1000; ++i) assert(array_push_back(a, &i) == 0);
+
+    assert(array_size(a) == 1000);
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        int v MAYBE_UNUSED = -1;
+        assert(array_get(a, i, &v) == 0);
+        assert(v == (int)i);
+    }
+
+    array_destroy(&a);
+    assert(a == NULL);
+
+    arena_destroy(&arena);
+}
+
+static void
+test_arena_reset_releases_arrays(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 0) == 0);
+
+    for(int round = 0; round < 4; ++round)
+    {
+        for(int k = 0; k < 16; ++k)
+        {
+            Array *a = NULL;
+            assert(array_create_with_allocator(&a, sizeof(double),
+                       arena_allocator(arena)) == 0);
+
+            for(int i = 0; i < 32; ++i)
+            {
+                double d = i;
+                assert(array_push_back(a, &d) == 0);
+            }
+        }
+
+        assert(arena_bytes_used(arena) > 0);
+
+        arena_reset(arena);
+        assert(arena_bytes_used(arena) == 0);
+    }
+
+    arena_destroy(&arena);
+}
+
+static void
+test_array_create_with_allocator_invalid(void)
+{
+    Array *a = NULL;
+    assert(array_create_with_allocator(&a, sizeof(int), NULL) == EINVAL);
+    assert(a == NULL);
+    assert(array_create_with_allocator(NULL, sizeof(int),
+               allocator_default()) == EINVAL);
+}
+
+void
+run_arena_tests(void)
+{
+    test_arena_create_invalid();
+    test_arena_allocate_aligned();
+    test_arena_reallocate_last_in_place();
+    test_arena_array_lifecycle();
+    test_arena_reset_releases_arrays();
+    test_array_create_with_allocator_invalid();
+}
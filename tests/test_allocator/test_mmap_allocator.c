@@ -0,0 +1,141 @@
+#include "../include/array.h"
+#include "../include/mmap_allocator.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_mmap_allocator_create_invalid(void)
+{
+    MmapAllocator *m = NULL;
+    assert(mmap_allocator_create(NULL, 0, 0) == EINVAL);
+    assert(mmap_allocator_create(&m, 0, 1u << 7) == EINVAL);
+    assert(m == NULL);
+
+    mmap_allocator_destroy(&m);
+    mmap_allocator_destroy(NULL);
+}
+
+static void
+test_mmap_allocator_cross_threshold(void)
+{
+    MmapAllocator *m = NULL;
+    assert(mmap_allocator_create(&m, 1 << 16, 0) == 0);
+
+    const Allocator *allocator = mmap_allocator(m);
+
+    size_t size = 1024;
+    unsigned char *p = allocator->allocate(allocator->context, size);
+    assert(p);
+    memset(p, 0x5A, size);
+
+    // heap -> mapping -> larger mapping -> heap
+    const size_t sizes[] = {1 << 17, 1 << 22, 1 << 18, 512};
+    for(size_t i = 0; i < 4; ++i)
+    {
+        size_t next = sizes[i];
+        p = allocator->reallocate(allocator->context, p, size, next);
+        assert(p);
+
+        size_t keep MAYBE_UNUSED = size < next ? size : next;
+        assert(p[0] == 0x5A && p[keep - 1] == 0x5A);
+
+        if(next > size) memset(p + size, 0x5A, next - size);
+        size = next;
+    }
+
+    allocator->deallocate(allocator->context, p, size);
+
+    mmap_allocator_destroy(&m);
+    assert(m == NULL);
+}
+
+static void
+test_mmap_allocator_array_growth(void)
+{
+    MmapAllocator *m = NULL;
+    assert(mmap_allocator_create(&m, 1 << 16, MMAP_ALLOCATOR_HUGE_PAGES) ==
+        0);
+
+    Array *a = NULL;
+    assert(array_create_with_allocator(&a, sizeof(long), mmap_allocator(m)) ==
+        0);
+
+    for(long i = 0; i < 200000; ++i) assert(array_push_back(a, &i) == 0);
+
+    for(size_t i = 0; i < 200000; i += 4999)
+    {
+        long v MAYBE_UNUSED = -1;
+        assert(array_get(a, i, &v) == 0);
+        assert(v == (long)i);
+    }
+
+    assert(array_erase_range(a, 10, array_size(a) - 10) == 0);
+    assert(array_shrink_fit(a) == 0); // mapping -> heap
+
+    long v MAYBE_UNUSED = -1;
+    assert(array_get(a, 9, &v) == 0);
+    assert(v == 9);
+
+    array_destroy(&a);
+    mmap_allocator_destroy(&m);
+}
+
+static void
+test_mmap_allocator_huge_alignment(void)
+{
+    const size_t huge = (size_t)2 << 20;
+
+    MmapAllocator *m = NULL;
+    assert(mmap_allocator_create(&m, 1 << 16, MMAP_ALLOCATOR_HUGE_PAGES) ==
+        0);
+
+    const Allocator *allocator = mmap_allocator(m);
+
+    // below one huge page: an ordinary mapping
+    size_t size = 1 << 20;
+    unsigned char *p = allocator->allocate(allocator->context, size);
+    assert(p);
+    memset(p, 0x3C, size);
+
+    // every huge mapping starts on a huge page boundary, across moves
+    const size_t sizes[] = {3 * huge + 123, 5 * huge, 2 * huge, huge / 2};
+    for(size_t i = 0; i < 4; ++i)
+    {
+        size_t next = sizes[i];
+        p = allocator->reallocate(allocator->context, p, size, next);
+        assert(p);
+        if(next >= huge) assert((uintptr_t)p % huge == 0);
+
+        size_t keep MAYBE_UNUSED = size < next ? size : next;
+        assert(p[0] == 0x3C && p[keep - 1] == 0x3C);
+
+        if(next > size) memset(p + size, 0x3C, next - size);
+        size = next;
+    }
+
+    allocator->deallocate(allocator->context, p, size);
+
+    p = allocator->allocate(allocator->context, huge + 1);
+    assert(p && (uintptr_t)p % huge == 0);
+    allocator->deallocate(allocator->context, p, huge + 1);
+
+    mmap_allocator_destroy(&m);
+}
+
+void
+run_mmap_allocator_tests(void)
+{
+    test_mmap_allocator_create_invalid();
+    test_mmap_allocator_cross_threshold();
+    test_mmap_allocator_array_growth();
+    test_mmap_allocator_huge_alignment();
+}
@@ -0,0 +1,136 @@
+#include "../include/allocator.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_pool_allocate_every_size(void)
+{
+    const Allocator *pool = allocator_pool();
+    assert(pool);
+
+    void *blocks[200];
+    size_t sizes[200];
+
+    for(size_t i = 0; i < 200; ++i)
+    {
+        sizes[i] = 1 + i * 173; // spans classes up to and beyond 32 KiB
+        blocks[i] = pool->allocate(pool->context, sizes[i]);
+        assert(blocks[i]);
+        assert((uintptr_t)blocks[i] % 16 == 0);
+        memset(blocks[i], (int)i, sizes[i]);
+    }
+
+    for(size_t i = 0; i < 200; ++i)
+    {
+        const unsigned char *p MAYBE_UNUSED = blocks[i];
+        assert(p[0] == (unsigned char)i);
+        assert(p[sizes[i] - 1] == (unsigned char)i);
+        pool->deallocate(pool->context, blocks[i], sizes[i]);
+    }
+}
+
+static void
+test_pool_reallocate_preserves_contents(void)
+{
+    const Allocator *pool = allocator_pool();
+
+    size_t size = 8;
+    unsigned char *p = pool->allocate(pool->context, size);
+    assert(p);
+    for(size_t i = 0; i < size; ++i) p[i] = (unsigned char)i;
+
+    while(size < 100000)
+    {
+        size_t next = size * 2;
+        p = pool->reallocate(pool->context, p, size, next);
+        assert(p);
+        for(size_t i = 0; i < 8; ++i) assert(p[i] == (unsigned char)i);
+        size = next;
+    }
+
+    pool->deallocate(pool->context, p, size);
+}
+
+static void
+test_pool_array_push_back(void)
+{
+    Array *a = NULL;
+    assert(array_create_with_allocator(&a, sizeof(int), allocator_pool()) ==
+        0);
+
+    for(int i = 0; i < 5000; ++i) assert(array_push_back(a, &i) == 0);
+
+    for(size_t i = 0; i < 5000; i += 97)
+    {
+        int v MAYBE_UNUSED = -1;
+        assert(array_get(a, i, &v) == 0);
+        assert(v == (int)i);
+    }
+
+    array_destroy(&a);
+}
+
+static void *
+test_pool_thread_main(void *argument)
+{
+    Array **arrays = argument;
+
+    for(int round = 0; round < 200; ++round)
+    {
+        Array *a = NULL;
+        assert(array_create_with_allocator(&a, sizeof(long),
+                   allocator_pool()) == 0);
+
+        for(long i = 0; i < 100; ++i) assert(array_push_back(a, &i) == 0);
+
+        array_destroy(&a);
+    }
+
+    // hand one array to the main thread: freed on a different thread
+    assert(array_create_with_allocator(arrays, sizeof(long),
+               allocator_pool()) == 0);
+
+    return NULL;
+}
+
+static void
+test_pool_threads(void)
+{
+    pthread_t threads[4];
+    Array *arrays[4] = {NULL};
+
+    for(size_t i = 0; i < 4; ++i)
+    {
+        assert(pthread_create(&threads[i], NULL, test_pool_thread_main,
+                   &arrays[i]) == 0);
+    }
+
+    for(size_t i = 0; i < 4; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        assert(arrays[i]);
+        array_destroy(&arrays[i]);
+    }
+
+    allocator_pool_thread_flush();
+}
+
+void
+run_pool_tests(void)
+{
+    test_pool_allocate_every_size();
+    test_pool_reallocate_preserves_contents();
+    test_pool_array_push_back();
+    test_pool_threads();
+}
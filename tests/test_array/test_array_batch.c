@@ -0,0 +1,176 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static uint64_t
+batch_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/*
+@brief:
+Reference result: walk the original elements and emit inserts and
+survivors in order.
+*/
+static size_t
+batch_expected(const int *original, size_t size, const ArrayEdit *edits,
+    size_t count, int *out)
+{
+    size_t n = 0;
+    size_t e = 0;
+
+    for(size_t i = 0; i <= size; ++i)
+    {
+        int erased = 0;
+        for(; e < count && edits[e].index == i; ++e)
+        {
+            if(edits[e].op == ARRAY_EDIT_INSERT)
+            {
+                out[n++] = *(const int *)edits[e].value;
+            }
+            else
+            {
+                erased = 1;
+            }
+        }
+
+        if(i < size && !erased) out[n++] = original[i];
+    }
+
+    return n;
+}
+
+static void
+test_array_apply_batch_random(void)
+{
+    enum
+    {
+        SIZE = 300,
+        MAX_EDITS = 200,
+    };
+
+    static int original[SIZE];
+    static int expected[SIZE + MAX_EDITS];
+    static int values[MAX_EDITS];
+    static ArrayEdit edits[MAX_EDITS];
+
+    uint64_t state = 0x853C49E6748FEA9Bu;
+
+    for(int round = 0; round < 200; ++round)
+    {
+        size_t size = batch_random(&state) % SIZE;
+        size_t count = batch_random(&state) % MAX_EDITS;
+
+        Array *a = NULL;
+        assert(array_create(&a, sizeof(int)) == 0);
+        for(size_t i = 0; i < size; ++i)
+        {
+            original[i] = (int)i;
+            assert(array_push_back(a, &original[i]) == 0);
+        }
+
+        // sorted random edits, erase only once per index
+        size_t n = 0;
+        size_t index = 0;
+        for(size_t e = 0; e < count && index <= size; ++e)
+        {
+            index += batch_random(&state) % 4 == 0
+                ? batch_random(&state) % 8
+                : 0;
+            if(index > size) break;
+
+            bool erase = index < size && batch_random(&state) % 2 &&
+                !(n && edits[n - 1].index == index &&
+                    edits[n - 1].op == ARRAY_EDIT_ERASE);
+
+            values[n] = -(int)e - 1;
+            edits[n].index = index;
+            edits[n].op = erase ? ARRAY_EDIT_ERASE : ARRAY_EDIT_INSERT;
+            edits[n].value = erase ? NULL : &values[n];
+            ++n;
+
+            if(erase) ++index; // keep one erase per index
+        }
+
+        size_t expected_size MAYBE_UNUSED =
+            batch_expected(original, size, edits, n, expected);
+
+        assert(array_apply_batch(a, edits, n) == 0);
+        assert(array_size(a) == expected_size);
+
+        for(size_t i = 0; i < expected_size; ++i)
+        {
+            assert(*(const int *)array_at_const(a, i) == expected[i]);
+        }
+
+        array_destroy(&a);
+    }
+}
+
+static void
+test_array_apply_batch_invalid(void)
+{
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+    for(int i = 0; i < 4; ++i) assert(array_push_back(a, &i) == 0);
+
+    int v = 9;
+
+    const ArrayEdit unsorted[] = {
+        {2, ARRAY_EDIT_INSERT, &v},
+        {1, ARRAY_EDIT_INSERT, &v},
+    };
+    const ArrayEdit twice[] = {
+        {1, ARRAY_EDIT_ERASE, NULL},
+        {1, ARRAY_EDIT_INSERT, &v},
+        {1, ARRAY_EDIT_ERASE, NULL},
+    };
+    const ArrayEdit past_end[] = {{4, ARRAY_EDIT_ERASE, NULL}};
+    const ArrayEdit no_value[] = {{0, ARRAY_EDIT_INSERT, NULL}};
+
+    assert(array_apply_batch(a, unsorted, 2) == EINVAL);
+    assert(array_apply_batch(a, twice, 3) == EINVAL);
+    assert(array_apply_batch(a, past_end, 1) == EINVAL);
+    assert(array_apply_batch(a, no_value, 1) == EINVAL);
+    assert(array_apply_batch(NULL, no_value, 1) == EINVAL);
+    assert(array_apply_batch(a, NULL, 1) == EINVAL);
+    assert(array_apply_batch(a, NULL, 0) == 0);
+
+    // unchanged after every failure
+    assert(array_size(a) == 4);
+    assert(*(const int *)array_at_const(a, 3) == 3);
+
+    // insert at the end and erase the first element
+    const ArrayEdit edits[] = {
+        {0, ARRAY_EDIT_ERASE, NULL},
+        {4, ARRAY_EDIT_INSERT, &v},
+    };
+    assert(array_apply_batch(a, edits, 2) == 0);
+    assert(array_size(a) == 4);
+    assert(*(const int *)array_at_const(a, 0) == 1);
+    assert(*(const int *)array_at_const(a, 3) == 9);
+
+    array_destroy(&a);
+}
+
+void
+run_array_batch_tests(void)
+{
+    test_array_apply_batch_random();
+    test_array_apply_batch_invalid();
+}
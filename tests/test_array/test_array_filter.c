@@ -0,0 +1,116 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static bool
+is_multiple(const void *element, void *context)
+{
+    return *(const int *)element % *(const int *)context == 0;
+}
+
+static bool
+count_calls(const void *element, void *context)
+{
+    (void)element;
+    ++*(size_t *)context;
+    return false;
+}
+
+static Array *
+filter_filled(int count)
+{
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+    for(int i = 0; i < count; ++i) assert(array_push_back(a, &i) == 0);
+    return a;
+}
+
+static void
+test_array_remove_if(void)
+{
+    Array *a = filter_filled(1000);
+
+    int three = 3;
+    assert(array_remove_if(a, is_multiple, &three) == 0);
+    assert(array_size(a) == 1000 - 334);
+
+    // order is preserved
+    int previous = -1;
+    for(size_t i = 0; i < array_size(a); ++i)
+    {
+        const int *v MAYBE_UNUSED = array_at_const(a, i);
+        assert(*v % 3 != 0);
+        assert(*v > previous);
+        previous = *v;
+    }
+
+    // predicate is called exactly once per element
+    size_t calls = 0;
+    size_t size MAYBE_UNUSED = array_size(a);
+    assert(array_remove_if(a, count_calls, &calls) == 0);
+    assert(calls == size);
+    assert(array_size(a) == size);
+
+    int one = 1;
+    assert(array_remove_if(a, is_multiple, &one) == 0);
+    assert(array_size(a) == 0);
+    assert(array_remove_if(a, is_multiple, &one) == 0);
+
+    assert(array_remove_if(NULL, is_multiple, &one) == EINVAL);
+    assert(array_remove_if(a, NULL, &one) == EINVAL);
+
+    array_destroy(&a);
+}
+
+static void
+test_array_retain(void)
+{
+    Array *a = filter_filled(100);
+
+    int ten = 10;
+    assert(array_retain(a, is_multiple, &ten) == 0);
+    assert(array_size(a) == 10);
+
+    for(size_t i = 0; i < 10; ++i)
+    {
+        const int *v MAYBE_UNUSED = array_at_const(a, i);
+        assert(*v == (int)i * 10);
+    }
+
+    array_destroy(&a);
+}
+
+static void
+test_array_swap_remove(void)
+{
+    Array *a = filter_filled(5); // 0 1 2 3 4
+
+    assert(array_swap_remove(a, 1) == 0); // 0 4 2 3
+    assert(array_size(a) == 4);
+    assert(*(const int *)array_at_const(a, 1) == 4);
+
+    assert(array_swap_remove(a, 3) == 0); // last element: 0 4 2
+    assert(array_size(a) == 3);
+    assert(*(const int *)array_at_const(a, 2) == 2);
+
+    assert(array_swap_remove(a, 3) == EINVAL);
+    assert(array_swap_remove(NULL, 0) == EINVAL);
+
+    array_destroy(&a);
+}
+
+void
+run_array_filter_tests(void)
+{
+    test_array_remove_if();
+    test_array_retain();
+    test_array_swap_remove();
+}
@@ -0,0 +1,313 @@
+#include "../include/array.h"
+#include "../include/array_io.h"
+
+#include <assert.h>
+#include <errno.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static size_t
+growth_round_to_hundred(size_t capacity, size_t min_capacity, void *context)
+{
+    (void)capacity;
+    ++*(int *)context;
+    return (min_capacity + 99) / 100 * 100;
+}
+
+static void
+fill_ints(Array *a, int n)
+{
+    for(int i = 0; i < n; ++i) assert(array_push_back(a, &i) == 0);
+}
+
+static void
+test_array_growth_one_and_half(void)
+{
+    static const ArrayGrowthPolicy policy = {
+        .factor_numerator = 3,
+        .factor_denominator = 2,
+    };
+
+    Array *a = array_init(sizeof(int));
+    assert(a);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 9); // 8 -> 12
+    assert(array_capacity(a) == 12);
+
+    fill_ints(a, 4); // 12 -> 18
+    assert(array_capacity(a) == 18);
+
+    array_delete(&a);
+}
+
+static void
+test_array_growth_linear_step(void)
+{
+    static const ArrayGrowthPolicy policy = {
+        .factor_numerator = 2,
+        .factor_denominator = 1,
+        .linear_threshold = 64,
+        .linear_step = 100,
+    };
+
+    Array *a = array_init(sizeof(int));
+    assert(a);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 65); // 8 -> 16 -> 32 -> 64 -> 164
+    assert(array_capacity(a) == 164);
+
+    assert(array_reserve(a, 500) == 0); // 164 + 4 * 100
+    assert(array_capacity(a) == 564);
+
+    array_delete(&a);
+}
+
+static void
+test_array_growth_callback(void)
+{
+    int calls = 0;
+    ArrayGrowthPolicy policy = {
+        .callback = growth_round_to_hundred,
+        .context = &calls,
+    };
+
+    Array *a = array_init(sizeof(int));
+    assert(a);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 9);
+    assert(array_capacity(a) == 100);
+    assert(calls == 1);
+
+    array_delete(&a);
+}
+
+static void
+test_array_growth_invalid_policy(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    const ArrayGrowthPolicy no_growth = {.factor_numerator = 1,
+        .factor_denominator = 1};
+    const ArrayGrowthPolicy zero_den = {.factor_numerator = 2};
+    const ArrayGrowthPolicy no_step = {.factor_numerator = 2,
+        .factor_denominator = 1,
+        .linear_threshold = 10};
+    const ArrayGrowthPolicy bad_shrink = {.factor_numerator = 2,
+        .factor_denominator = 1,
+        .shrink_divisor = 1};
+
+    assert(array_set_growth_policy(a, &no_growth) == EINVAL);
+    assert(array_set_growth_policy(a, &zero_den) == EINVAL);
+    assert(array_set_growth_policy(a, &no_step) == EINVAL);
+    assert(array_set_growth_policy(a, &bad_shrink) == EINVAL);
+    assert(array_set_growth_policy(NULL, NULL) == EINVAL);
+    assert(array_set_growth_policy(a, NULL) == 0);
+
+    array_delete(&a);
+}
+
+static void
+test_array_reserve_exact_and_shrink_fit(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    assert(array_reserve_exact(a, 1000) == 0);
+    assert(array_capacity(a) == 1000);
+    assert(array_reserve_exact(a, 10) == 0); // never shrinks
+    assert(array_capacity(a) == 1000);
+
+    fill_ints(a, 300);
+    assert(array_shrink_fit(a) == 0);
+    assert(array_capacity(a) == 300);
+
+    int v MAYBE_UNUSED = -1;
+    assert(array_get(a, 299, &v) == 0);
+    assert(v == 299);
+
+    // small enough to move back into the inline buffer
+    assert(array_erase_range(a, 3, 297) == 0);
+    assert(array_shrink_fit(a) == 0);
+    assert(array_capacity(a) == 8);
+    assert(array_get(a, 2, &v) == 0);
+    assert(v == 2);
+
+    array_delete(&a);
+}
+
+static void
+test_array_auto_shrink_hysteresis(void)
+{
+    static const ArrayGrowthPolicy policy = {
+        .factor_numerator = 2,
+        .factor_denominator = 1,
+        .shrink_divisor = 4,
+    };
+
+    Array *a = array_init(sizeof(int));
+    assert(a);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 1024);
+    assert(array_capacity(a) == 1024);
+
+    // 256 == capacity / 4: not below the threshold yet
+    assert(array_erase_range(a, 256, 768) == 0);
+    assert(array_capacity(a) == 1024);
+
+    array_pop_back(a); // 255 < 1024 / 4
+    assert(array_capacity(a) == 512);
+
+    // growing back by one element must not regrow immediately
+    assert(array_push_back(a, &(int){0}) == 0);
+    assert(array_capacity(a) == 512);
+
+    while(array_size(a) > 1) array_pop_front(a);
+    assert(array_capacity(a) == 8);
+
+    int v MAYBE_UNUSED = -1;
+    assert(array_get(a, 0, &v) == 0);
+    assert(v == 0);
+
+    array_delete(&a);
+}
+
+static void
+test_array_growth_incremental(void)
+{
+    static const ArrayGrowthPolicy policy = {
+        .factor_numerator = 2,
+        .factor_denominator = 1,
+        .incremental_step = 2,
+    };
+
+    Array *a = NULL;
+    assert(array_create_inline(&a, sizeof(int), 0, allocator_default()) ==
+        0);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 16);
+    assert(array_capacity(a) == 16);
+
+    // 16 -> 32 allocates but moves only 2 elements
+    assert(array_push_back(a, &(int){16}) == 0);
+    assert(array_capacity(a) == 32);
+
+    const int *fresh = (const int *)array_at_const(a, 16) - 16;
+    assert(array_at_const(a, 1) == fresh + 1);
+    assert(array_at_const(a, 2) != fresh + 2); // still in the old buffer
+
+    // lookups consult both buffers
+    for(int i = 0; i < 17; ++i)
+    {
+        int v MAYBE_UNUSED = -1;
+        assert(array_get(a, (size_t)i, &v) == 0);
+        assert(v == i);
+    }
+
+    assert(array_set(a, 10, &(int){-10}) == 0);
+    assert(*(const int *)array_at_const(a, 10) == -10);
+
+    // each push moves 2 more: 7 pushes drain the remaining 14
+    fill_ints(a, 6);
+    assert(array_at_const(a, 15) != fresh + 15);
+    assert(array_push_back(a, &(int){0}) == 0);
+    assert(array_at_const(a, 15) == fresh + 15);
+
+    int v MAYBE_UNUSED = -1;
+    assert(array_get(a, 10, &v) == 0);
+    assert(v == -10);
+
+    // shrinking into the old buffer and reading contiguously
+    fill_ints(a, 9); // 32 -> 64, migration pending
+    assert(array_size(a) == 33);
+    assert(array_swap_remove(a, 3) == 0); // last element 8 moves to 3
+    while(array_size(a) > 12) array_pop_back(a);
+
+    const int *data = array_data(a);
+    assert(data == array_at_const(a, 0));
+    for(int i = 0; i < 12; ++i)
+    {
+        int expected MAYBE_UNUSED = i == 3 ? 8 : i == 10 ? -10 : i;
+        assert(data[i] == expected);
+    }
+
+    // popping below the migrated prefix frees the old buffer
+    fill_ints(a, 53); // 64 -> 128
+    while(array_size(a) > 1) array_pop_back(a);
+    assert(array_get(a, 0, &v) == 0);
+    assert(v == 0);
+
+    array_destroy(&a);
+}
+
+static void
+test_array_growth_incremental_const(void)
+{
+    static const ArrayGrowthPolicy policy = {
+        .factor_numerator = 2,
+        .factor_denominator = 1,
+        .incremental_step = 2,
+    };
+
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+    assert(array_set_growth_policy(a, &policy) == 0);
+
+    fill_ints(a, 16);
+    const void *settled MAYBE_UNUSED = array_data_const(a);
+    assert(settled);
+
+    fill_ints(a, 1); // 16 -> 32, 14 elements still in the old buffer
+
+    // read-only accessors never move elements
+    assert(array_data_const(a) == NULL);
+    assert(array_write_fd(a, -1, 0) == EBUSY);
+    for(int i = 0; i < 16; ++i)
+    {
+        assert(*(const int *)array_at_const(a, (size_t)i) == i);
+    }
+
+    // appending from a pending array leaves it pending
+    Array *copy = NULL;
+    assert(array_create(&copy, sizeof(int)) == 0);
+    assert(array_append_array(copy, a) == 0);
+    assert(array_data_const(a) == NULL);
+    assert(array_size(copy) == 17);
+
+    const int *values = array_data_const(copy);
+    for(int i = 0; i < 17; ++i)
+    {
+        int expected MAYBE_UNUSED = i == 16 ? 0 : i;
+        assert(values[i] == expected);
+    }
+
+    // the mutable accessor finishes the move
+    const void *data MAYBE_UNUSED = array_data(a);
+    assert(data && data != settled);
+    assert(array_data_const(a) == data);
+
+    array_destroy(&copy);
+    array_destroy(&a);
+}
+
+void
+run_array_growth_tests(void)
+{
+    test_array_growth_one_and_half();
+    test_array_growth_linear_step();
+    test_array_growth_callback();
+    test_array_growth_invalid_policy();
+    test_array_reserve_exact_and_shrink_fit();
+    test_array_auto_shrink_hysteresis();
+    test_array_growth_incremental();
+    test_array_growth_incremental_const();
+}
@@ -0,0 +1,144 @@
+#include "../include/arena.h"
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdalign.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_array_create_single_allocation(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 4096) == 0);
+
+    Array *a = NULL;
+    assert(array_create_with_allocator(&a, sizeof(int),
+               arena_allocator(arena)) == 0);
+
+    // header and inline elements live in one block next to each other
+    assert((char *)array_data(a) > (char *)a);
+    assert((char *)array_data(a) < (char *)a + ARRAY_HEADER_SIZE);
+
+    const size_t cap MAYBE_UNUSED = array_capacity(a);
+    for(int i = 0; i < (int)cap; ++i) assert(array_push_back(a, &i) == 0);
+    assert((char *)array_data(a) < (char *)a + ARRAY_HEADER_SIZE);
+
+    array_destroy(&a);
+    arena_destroy(&arena);
+}
+
+static void
+test_array_create_inline_spill(void)
+{
+    Array *a = NULL;
+    assert(array_create_inline(&a, sizeof(int), 4, allocator_default()) ==
+        0);
+    assert(array_capacity(a) == 4);
+
+    for(int i = 0; i < 100; ++i) assert(array_push_back(a, &i) == 0);
+    assert(array_capacity(a) >= 100);
+
+    for(size_t i = 0; i < 100; ++i)
+    {
+        int v MAYBE_UNUSED = -1;
+        assert(array_get(a, i, &v) == 0);
+        assert(v == (int)i);
+    }
+
+    array_destroy(&a);
+}
+
+static void
+test_array_create_inline_zero(void)
+{
+    Array *a = NULL;
+    assert(array_create_inline(&a, sizeof(int), 0, allocator_default()) ==
+        0);
+    assert(array_capacity(a) == 0);
+    assert(array_data(a) == NULL);
+
+    assert(array_push_back(a, &(int){7}) == 0);
+    assert(array_size(a) == 1);
+
+    array_destroy(&a);
+}
+
+static void
+test_array_init_inplace_stack(void)
+{
+    alignas(max_align_t) unsigned char storage[ARRAY_INPLACE_BYTES(
+        sizeof(int), 8)];
+
+    Array *a = NULL;
+    assert(array_init_inplace(&a, storage, sizeof(storage), sizeof(int)) ==
+        0);
+    assert(a == (Array *)storage);
+    assert(array_capacity(a) >= 8);
+
+    const size_t cap MAYBE_UNUSED = array_capacity(a);
+
+    for(int i = 0; i < 8; ++i) assert(array_push_back(a, &i) == 0);
+    assert(array_capacity(a) == cap); // still inline
+
+    for(int i = 8; i < 64; ++i) assert(array_push_back(a, &i) == 0);
+    assert(array_capacity(a) > cap);
+
+    int v MAYBE_UNUSED = -1;
+    assert(array_get(a, 63, &v) == 0);
+    assert(v == 63);
+
+    array_destroy(&a); // releases the heap block only
+    assert(a == NULL);
+}
+
+static void
+test_array_init_inplace_invalid(void)
+{
+    alignas(max_align_t) unsigned char storage[ARRAY_HEADER_SIZE];
+
+    Array *a = NULL;
+    assert(array_init_inplace(NULL, storage, sizeof(storage), 4) == EINVAL);
+    assert(array_init_inplace(&a, NULL, sizeof(storage), 4) == EINVAL);
+    assert(array_init_inplace(&a, storage, sizeof(storage) - 1, 4) ==
+        EINVAL);
+    assert(array_init_inplace(&a, storage + 1, sizeof(storage) - 1, 4) ==
+        EINVAL);
+    assert(array_init_inplace(&a, storage, sizeof(storage), 0) == EINVAL);
+    assert(a == NULL);
+}
+
+static void
+test_array_pop_back_full(void)
+{
+    Array *a = NULL;
+    assert(array_create_inline(&a, sizeof(int), 2, allocator_default()) ==
+        0);
+
+    assert(array_push_back(a, &(int){1}) == 0);
+    assert(array_push_back(a, &(int){2}) == 0);
+
+    array_pop_back(a);
+    array_pop_back(a);
+    array_pop_back(a); // no-op on empty
+    array_pop_front(a);
+    assert(array_size(a) == 0);
+
+    array_destroy(&a);
+}
+
+void
+run_array_inline_tests(void)
+{
+    test_array_create_single_allocation();
+    test_array_create_inline_spill();
+    test_array_create_inline_zero();
+    test_array_init_inplace_stack();
+    test_array_init_inplace_invalid();
+    test_array_pop_back_full();
+}
@@ -0,0 +1,259 @@
+#include "../include/array.h"
+#include "../include/array_io.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static int
+test_array_io_file(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/ads_lib_test_io_%ld.bin", (long)getpid());
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+
+    return fd;
+}
+
+static Array *
+test_array_io_filled(size_t count)
+{
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(uint64_t)) == 0);
+
+    for(uint64_t i = 0; i < count; ++i)
+    {
+        uint64_t v = i * 2654435761u;
+        assert(array_push_back(a, &v) == 0);
+    }
+
+    return a;
+}
+
+static void
+test_array_io_roundtrip(void)
+{
+    char path[128];
+    int fd = test_array_io_file(path, sizeof(path));
+
+    // larger than the stream buffer, so both read paths are used
+    Array *small = test_array_io_filled(10);
+    Array *large = test_array_io_filled(100000);
+    Array *empty = test_array_io_filled(0);
+
+    assert(array_write_fd(small, fd, 0) == 0);
+    assert(array_write_fd(large, fd, ARRAY_IO_CHECKSUM) == 0);
+    assert(array_write_fd(empty, fd, ARRAY_IO_CHECKSUM) == 0);
+
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    // streams are read back to back without over-reading
+    Array *b = NULL;
+    assert(array_create(&b, sizeof(uint64_t)) == 0);
+
+    assert(array_read_fd(b, fd) == 0);
+    assert(array_size(b) == 10);
+    assert(array_read_fd(b, fd) == 0);
+    assert(array_size(b) == 100010);
+    assert(array_read_fd(b, fd) == 0);
+    assert(array_size(b) == 100010);
+    assert(array_read_fd(b, fd) == EIO); // end of file
+
+    for(size_t i = 0; i < 100000; i += 999)
+    {
+        const uint64_t *expected MAYBE_UNUSED = array_at_const(large, i);
+        const uint64_t *actual MAYBE_UNUSED = array_at_const(b, 10 + i);
+        assert(*expected == *actual);
+    }
+
+    array_destroy(&b);
+    array_destroy(&empty);
+    array_destroy(&large);
+    array_destroy(&small);
+
+    close(fd);
+    remove(path);
+}
+
+static void
+test_array_io_corrupt(void)
+{
+    char path[128];
+    int fd = test_array_io_file(path, sizeof(path));
+
+    Array *a = test_array_io_filled(1000);
+    assert(array_write_fd(a, fd, ARRAY_IO_CHECKSUM) == 0);
+
+    // flip one payload byte
+    unsigned char byte;
+    assert(lseek(fd, 100, SEEK_SET) == 100);
+    assert(read(fd, &byte, 1) == 1);
+    byte ^= 0x01;
+    assert(lseek(fd, 100, SEEK_SET) == 100);
+    assert(write(fd, &byte, 1) == 1);
+
+    Array *b = NULL;
+    assert(array_create(&b, sizeof(uint64_t)) == 0);
+
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    assert(array_read_fd(b, fd) == EBADMSG);
+    assert(array_size(b) == 0);
+
+    // element size must match
+    Array *c = NULL;
+    assert(array_create(&c, sizeof(uint32_t)) == 0);
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    assert(array_read_fd(c, fd) == EINVAL);
+    array_destroy(&c);
+
+    // truncated stream
+    assert(ftruncate(fd, 500) == 0);
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    assert(array_read_fd(b, fd) == EIO);
+    assert(array_size(b) == 0);
+
+    array_destroy(&b);
+    array_destroy(&a);
+
+    close(fd);
+    remove(path);
+}
+
+/*
+@brief:
+Write a stream of count elements to fd, with the header count replaced
+by claimed.
+*/
+static void
+test_array_io_write_claiming(int fd, size_t count, uint64_t claimed)
+{
+    char path[128];
+    int tmp = test_array_io_file(path, sizeof(path));
+
+    Array *a = test_array_io_filled(count);
+    assert(array_write_fd(a, tmp, 0) == 0);
+    array_destroy(&a);
+
+    static unsigned char stream[32 + 5000 * sizeof(uint64_t)];
+    size_t bytes = 32 + count * sizeof(uint64_t);
+    assert(bytes <= sizeof(stream));
+
+    assert(lseek(tmp, 0, SEEK_SET) == 0);
+    assert(read(tmp, stream, bytes) == (ssize_t)bytes);
+    memcpy(stream + 24, &claimed, sizeof(claimed)); // header.count
+    assert(write(fd, stream, bytes) == (ssize_t)bytes);
+
+    close(tmp);
+    remove(path);
+}
+
+static void
+test_array_io_untrusted_count(void)
+{
+    Array *b = test_array_io_filled(3);
+    size_t capacity MAYBE_UNUSED = array_capacity(b);
+
+    // a regular file shorter than the count is rejected before allocating
+    char path[128];
+    int fd = test_array_io_file(path, sizeof(path));
+    remove(path);
+    test_array_io_write_claiming(fd, 10, (uint64_t)1 << 40);
+
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    assert(array_read_fd(b, fd) == EIO);
+    assert(array_size(b) == 3);
+    assert(array_capacity(b) == capacity);
+    close(fd);
+
+    // a pipe is read in batches; a short one gives back what it grew
+    int fds[2];
+    assert(pipe(fds) == 0);
+    test_array_io_write_claiming(fds[1], 5000, (uint64_t)1 << 28);
+    close(fds[1]);
+
+    assert(array_read_fd(b, fds[0]) == EIO);
+    assert(array_size(b) == 3);
+    assert(array_capacity(b) == capacity);
+    close(fds[0]);
+
+    // and an honest one is read in full
+    assert(pipe(fds) == 0);
+    test_array_io_write_claiming(fds[1], 5000, 5000);
+    close(fds[1]);
+
+    assert(array_read_fd(b, fds[0]) == 0);
+    assert(array_size(b) == 5003);
+    const uint64_t *last MAYBE_UNUSED = array_at_const(b, 5002);
+    assert(*last == 4999 * (uint64_t)2654435761u);
+    close(fds[0]);
+
+    array_destroy(&b);
+}
+
+static void
+test_array_io_streaming(void)
+{
+    char path[128];
+    int fd = test_array_io_file(path, sizeof(path));
+
+    ArrayWriter *w = NULL;
+    assert(array_writer_open(&w, fd, sizeof(int), 1000, ARRAY_IO_CHECKSUM) ==
+        0);
+    for(int i = 0; i < 1000; ++i) assert(array_writer_write(w, &i, 1) == 0);
+
+    int extra = 0;
+    assert(array_writer_write(w, &extra, 1) == EINVAL);
+    assert(array_writer_close(&w) == 0);
+    assert(w == NULL);
+
+    // closing before every announced element was written fails
+    assert(array_writer_open(&w, fd, sizeof(int), 2, 0) == 0);
+    assert(array_writer_write(w, &extra, 1) == 0);
+    assert(array_writer_close(&w) == EINVAL);
+
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    ArrayReader *r = NULL;
+    assert(array_reader_open(&r, fd, sizeof(int)) == 0);
+    assert(array_reader_remaining(r) == 1000);
+
+    int values[10];
+    for(int i = 0; i < 100; ++i)
+    {
+        assert(array_reader_read(r, values, 10) == 0);
+        assert(values[0] == i * 10 && values[9] == i * 10 + 9);
+    }
+    assert(array_reader_remaining(r) == 0);
+    assert(array_reader_read(r, values, 1) == EINVAL);
+
+    array_reader_close(&r);
+    assert(r == NULL);
+    array_reader_close(&r);
+
+    assert(array_writer_open(NULL, fd, sizeof(int), 0, 0) == EINVAL);
+    assert(array_writer_open(&w, fd, sizeof(int), 0, 1u << 7) == EINVAL);
+    assert(array_reader_open(&r, -1, sizeof(int)) == EINVAL);
+
+    close(fd);
+    remove(path);
+}
+
+void
+run_array_io_tests(void)
+{
+    test_array_io_roundtrip();
+    test_array_io_corrupt();
+    test_array_io_untrusted_count();
+    test_array_io_streaming();
+}
@@ -0,0 +1,140 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_array_mapped_path(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/ads_lib_test_mapped_%ld.bin", (long)getpid());
+    remove(path);
+}
+
+static void
+test_array_open_mapped_invalid(void)
+{
+    char path[128];
+    test_array_mapped_path(path, sizeof(path));
+
+    Array *a = NULL;
+    assert(array_open_mapped(NULL, path, sizeof(int), 0) == EINVAL);
+    assert(array_open_mapped(&a, NULL, sizeof(int), 0) == EINVAL);
+    assert(array_open_mapped(&a, path, 0, ARRAY_MAPPED_CREATE) == EINVAL);
+    assert(array_open_mapped(&a, path, sizeof(int),
+               ARRAY_MAPPED_READ_ONLY | ARRAY_MAPPED_CREATE) == EINVAL);
+    assert(array_open_mapped(&a, path, sizeof(int), 1u << 7) == EINVAL);
+    assert(array_open_mapped(&a, path, sizeof(int), 0) == ENOENT);
+    assert(a == NULL);
+
+    // not an array file
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    for(int i = 0; i < 100; ++i) fputc('x', f);
+    fclose(f);
+
+    assert(array_open_mapped(&a, path, sizeof(int), 0) == EINVAL);
+    assert(a == NULL);
+
+    remove(path);
+
+    // non-mapped arrays cannot be synced
+    assert(array_create(&a, sizeof(int)) == 0);
+    assert(array_sync(a) == EINVAL);
+    array_destroy(&a);
+}
+
+static void
+test_array_mapped_persist(void)
+{
+    char path[128];
+    test_array_mapped_path(path, sizeof(path));
+
+    Array *a = NULL;
+    assert(array_open_mapped(&a, path, sizeof(int), ARRAY_MAPPED_CREATE) == 0);
+    assert(array_size(a) == 0);
+    assert(array_capacity(a) > 0);
+
+    // grows the file several times
+    for(int i = 0; i < 10000; ++i) assert(array_push_back(a, &i) == 0);
+    assert(array_erase(a, 0) == 0);
+    assert(array_sync(a) == 0);
+    array_destroy(&a);
+    assert(a == NULL);
+
+    // element size must match the file
+    assert(array_open_mapped(&a, path, sizeof(long long), 0) == EINVAL);
+
+    assert(array_open_mapped(&a, path, sizeof(int), 0) == 0);
+    assert(array_size(a) == 9999);
+    for(size_t i = 0; i < 9999; ++i)
+    {
+        const int *p MAYBE_UNUSED = array_at_const(a, i);
+        assert(*p == (int)i + 1);
+    }
+
+    // the count is also persisted by destroy
+    assert(array_erase_range(a, 100, array_size(a) - 100) == 0);
+    assert(array_shrink_fit(a) == 0);
+    assert(array_capacity(a) == 100);
+    array_destroy(&a);
+
+    assert(array_open_mapped(&a, path, sizeof(int), 0) == 0);
+    assert(array_size(a) == 100);
+    array_destroy(&a);
+
+    remove(path);
+}
+
+static void
+test_array_mapped_read_only(void)
+{
+    char path[128];
+    test_array_mapped_path(path, sizeof(path));
+
+    Array *a = NULL;
+    assert(array_open_mapped(&a, path, sizeof(int), ARRAY_MAPPED_CREATE) == 0);
+    for(int i = 0; i < 8; ++i) assert(array_push_back(a, &i) == 0);
+    array_destroy(&a);
+
+    Array *r = NULL;
+    assert(array_open_mapped(&r, path, sizeof(int), ARRAY_MAPPED_READ_ONLY) ==
+        0);
+    assert(array_size(r) == 8);
+
+    // writes stay private to the process, resizing the file is refused
+    int v MAYBE_UNUSED = 42;
+    assert(array_set(r, 0, &v) == 0);
+    assert(array_push_back(r, &v) == EROFS);
+    assert(array_sync(r) == EROFS);
+    array_destroy(&r);
+
+    assert(array_open_mapped(&r, path, sizeof(int), ARRAY_MAPPED_READ_ONLY) ==
+        0);
+    assert(array_get(r, 0, &v) == 0);
+    assert(v == 0);
+    array_destroy(&r);
+
+    // truncate discards the previous contents
+    assert(array_open_mapped(&a, path, sizeof(int), ARRAY_MAPPED_TRUNCATE) ==
+        0);
+    assert(array_size(a) == 0);
+    array_destroy(&a);
+
+    remove(path);
+}
+
+void
+run_array_mapped_tests(void)
+{
+    test_array_open_mapped_invalid();
+    test_array_mapped_persist();
+    test_array_mapped_read_only();
+}
@@ -0,0 +1,143 @@
+#include "../include/array.h"
+#include "../include/array_parallel.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+/*
+Polynomial hash of a sequence: associative but not commutative, so the
+reduce test catches any out-of-order combine.
+*/
+typedef struct ParallelHash
+{
+    uint64_t hash;
+    uint64_t power;
+} ParallelHash;
+
+static void
+parallel_hash_combine(void *accumulator, const void *value, void *context)
+{
+    ParallelHash *a = accumulator;
+    const ParallelHash *b = value;
+    (void)context;
+
+    a->hash = a->hash * b->power + b->hash;
+    a->power *= b->power;
+}
+
+static void
+parallel_scale(void *elements, size_t count, size_t first, void *context)
+{
+    int64_t *v = elements;
+    int64_t factor = *(const int64_t *)context;
+    (void)first;
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        assert(v[i] == (int64_t)(first + i)); // slice starts at first
+        v[i] *= factor;
+    }
+}
+
+static void
+parallel_to_double(const void *src, void *dst, size_t count, void *context)
+{
+    const int64_t *in = src;
+    double *out = dst;
+    (void)context;
+
+    for(size_t i = 0; i < count; ++i) out[i] = (double)in[i] / 2;
+}
+
+static void
+test_array_parallel_for_and_map(void)
+{
+    enum
+    {
+        COUNT = 200000
+    };
+
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int64_t)) == 0);
+    for(int64_t i = 0; i < COUNT; ++i) assert(array_push_back(a, &i) == 0);
+
+    int64_t factor = 3;
+    assert(array_parallel_for(a, 1000, parallel_scale, &factor) == 0);
+    for(size_t i = 0; i < COUNT; ++i)
+    {
+        assert(*(const int64_t *)array_at_const(a, i) == 3 * (int64_t)i);
+    }
+
+    // dst grows to, then shrinks to, the size of src
+    Array *d = NULL;
+    assert(array_create(&d, sizeof(double)) == 0);
+    assert(array_parallel_map(a, d, parallel_to_double, NULL) == 0);
+    assert(array_size(d) == COUNT);
+    for(size_t i = 0; i < COUNT; ++i)
+    {
+        assert(*(const double *)array_at_const(d, i) == 1.5 * (double)i);
+    }
+
+    assert(array_erase_range(a, 10, COUNT - 10) == 0);
+    assert(array_parallel_map(a, d, parallel_to_double, NULL) == 0);
+    assert(array_size(d) == 10);
+    assert(*(const double *)array_at_const(d, 9) == 13.5);
+
+    assert(array_parallel_map(a, a, parallel_to_double, NULL) == EINVAL);
+    assert(array_parallel_for(NULL, 0, parallel_scale, NULL) == EINVAL);
+    assert(array_parallel_for(a, 0, NULL, NULL) == EINVAL);
+
+    array_destroy(&d);
+    array_destroy(&a);
+}
+
+static void
+test_array_parallel_reduce_in_order(void)
+{
+    enum
+    {
+        COUNT = 100000
+    };
+
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(ParallelHash)) == 0);
+
+    ParallelHash expected = {7, 1};
+    for(uint64_t i = 0; i < COUNT; ++i)
+    {
+        ParallelHash h = {i * 2654435761u, 31};
+        assert(array_push_back(a, &h) == 0);
+        parallel_hash_combine(&expected, &h, NULL);
+    }
+
+    ParallelHash init = {7, 1};
+    ParallelHash out = {0, 0};
+    assert(array_parallel_reduce(a, &init, &out, parallel_hash_combine,
+               NULL) == 0);
+    assert(out.hash == expected.hash && out.power == expected.power);
+
+    // empty array: init, also when out aliases it
+    assert(array_erase_range(a, 0, COUNT) == 0);
+    assert(array_parallel_reduce(a, &init, &init, parallel_hash_combine,
+               NULL) == 0);
+    assert(init.hash == 7 && init.power == 1);
+
+    assert(array_parallel_reduce(a, NULL, &out, parallel_hash_combine,
+               NULL) == EINVAL);
+
+    array_destroy(&a);
+}
+
+void
+run_array_parallel_tests(void)
+{
+    test_array_parallel_for_and_map();
+    test_array_parallel_reduce_in_order();
+}
@@ -0,0 +1,163 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+assert_array_equals(const Array *a MAYBE_UNUSED, const int *expected,
+    size_t n)
+{
+    assert(array_size(a) == n);
+
+    for(size_t i = 0; i < n; ++i)
+    {
+        int v MAYBE_UNUSED = -1;
+        assert(array_get(a, i, &v) == 0);
+        assert(v == expected[i]);
+    }
+}
+
+static void
+test_array_push_back_n(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    int values[100];
+    for(int i = 0; i < 100; ++i) values[i] = i;
+
+    assert(array_push_back_n(a, values, 60) == 0);
+    assert(array_push_back_n(a, values + 60, 40) == 0);
+    assert(array_push_back_n(a, NULL, 0) == 0);
+
+    assert_array_equals(a, values, 100);
+    assert(array_capacity(a) >= 100);
+
+    assert(array_push_back_n(a, NULL, 1) == EINVAL);
+    assert(array_push_back_n(NULL, values, 1) == EINVAL);
+
+    array_delete(&a);
+}
+
+static void
+test_array_insert_range_middle(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    const int initial[] = {1, 2, 3, 4};
+    const int inserted[] = {10, 11, 12};
+    assert(array_push_back_n(a, initial, 4) == 0);
+
+    assert(array_insert_range(a, inserted, 3, 2) == 0);
+
+    const int expected[] = {1, 2, 10, 11, 12, 3, 4};
+    assert_array_equals(a, expected, 7);
+
+    assert(array_insert_range(a, inserted, 3, 0) == 0);
+    assert(array_insert_range(a, inserted, 3, array_size(a)) == 0);
+
+    const int expected2[] = {10, 11, 12, 1, 2, 10, 11, 12, 3, 4, 10, 11, 12};
+    assert_array_equals(a, expected2, 13);
+
+    assert(array_insert_range(a, inserted, 3, 14) == EINVAL);
+    assert_array_equals(a, expected2, 13);
+
+    array_delete(&a);
+}
+
+static void
+test_array_erase_range(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    const int initial[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    assert(array_push_back_n(a, initial, 10) == 0);
+
+    assert(array_erase_range(a, 2, 3) == 0);
+    const int expected[] = {0, 1, 5, 6, 7, 8, 9};
+    assert_array_equals(a, expected, 7);
+
+    assert(array_erase_range(a, 5, 2) == 0);
+    const int expected2[] = {0, 1, 5, 6, 7};
+    assert_array_equals(a, expected2, 5);
+
+    assert(array_erase_range(a, 4, 2) == EINVAL);
+    assert(array_erase_range(a, 6, 0) == EINVAL);
+    assert(array_erase_range(a, 1, SIZE_MAX) == EINVAL);
+    assert(array_erase_range(a, 5, 0) == 0);
+
+    assert(array_erase_range(a, 0, 5) == 0);
+    assert(array_size(a) == 0);
+
+    array_delete(&a);
+}
+
+static void
+test_array_assign(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    int values[50];
+    for(int i = 0; i < 50; ++i) values[i] = 50 - i;
+
+    assert(array_push_back(a, &(int){7}) == 0);
+    assert(array_assign(a, values, 50) == 0);
+    assert_array_equals(a, values, 50);
+
+    assert(array_assign(a, values, 3) == 0);
+    assert_array_equals(a, values, 3);
+
+    assert(array_assign(a, NULL, 0) == 0);
+    assert(array_size(a) == 0);
+
+    array_delete(&a);
+}
+
+static void
+test_array_append_array(void)
+{
+    Array *a = array_init(sizeof(int));
+    Array *b = array_init(sizeof(int));
+    Array *c = array_init(sizeof(char));
+    assert(a && b && c);
+
+    const int first[] = {1, 2, 3, 4, 5, 6, 7};
+    const int second[] = {8, 9};
+    assert(array_push_back_n(a, first, 7) == 0);
+    assert(array_push_back_n(b, second, 2) == 0);
+
+    assert(array_append_array(a, b) == 0);
+    const int expected[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    assert_array_equals(a, expected, 9);
+
+    // self append forces a reallocation of the source buffer
+    assert(array_append_array(b, b) == 0);
+    const int expected2[] = {8, 9, 8, 9};
+    assert_array_equals(b, expected2, 4);
+
+    assert(array_append_array(a, c) == EINVAL);
+    assert(array_append_array(NULL, b) == EINVAL);
+
+    array_delete(&a);
+    array_delete(&b);
+    array_delete(&c);
+}
+
+void
+run_array_range_tests(void)
+{
+    test_array_push_back_n();
+    test_array_insert_range_middle();
+    test_array_erase_range();
+    test_array_assign();
+    test_array_append_array();
+}
@@ -0,0 +1,401 @@
+#include "../include/array.h"
+#include "../include/array_sort.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+typedef struct SortRecord
+{
+    uint32_t key;
+    uint32_t order;
+    uint64_t payload[2];
+} SortRecord;
+
+static uint64_t
+sort_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static int
+sort_cmp_u8(const void *a, const void *b)
+{
+    unsigned char x = *(const unsigned char *)a;
+    unsigned char y = *(const unsigned char *)b;
+    return (x > y) - (x < y);
+}
+
+static int
+sort_cmp_u32(const void *a, const void *b)
+{
+    uint32_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+static int
+sort_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+static int
+sort_cmp_i64(const void *a, const void *b)
+{
+    int64_t x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+static int
+sort_cmp_f64(const void *a, const void *b)
+{
+    double x, y;
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+static int
+sort_cmp_record(const void *a, const void *b)
+{
+    const SortRecord *x = a;
+    const SortRecord *y = b;
+    if(x->key != y->key) return (x->key > y->key) - (x->key < y->key);
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+static int
+sort_cmp_record_key(const void *a, const void *b)
+{
+    const SortRecord *x = a;
+    const SortRecord *y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static uint64_t
+sort_record_key(const void *element, void *context)
+{
+    (void)context;
+    return ((const SortRecord *)element)->key;
+}
+
+/*
+@brief:
+Fill a with count random elements shaped by pattern (0 random, 1 sorted,
+2 reversed, 3 few distinct values) and keep a copy in expected.
+*/
+static Array *
+sort_fill(size_t element_size, size_t count, int pattern, uint64_t *state,
+    unsigned char *expected)
+{
+    Array *a = NULL;
+    assert(array_create(&a, element_size) == 0);
+
+    unsigned char *p = NULL;
+    assert(array_push_back_uninit(a, count, (void **)&p) == 0);
+
+    for(size_t i = 0; i < count * element_size; ++i)
+    {
+        p[i] = (unsigned char)sort_random(state);
+    }
+
+    if(pattern == 3)
+    {
+        for(size_t i = 0; i < count * element_size; ++i) p[i] &= 3;
+    }
+
+    if(count) memcpy(expected, p, count * element_size);
+
+    return a;
+}
+
+static void
+test_array_sort_matches_qsort(void)
+{
+    static const size_t sizes[] = {1, 4, 8, 16, 24};
+    static const ArrayComparator cmps[] = {
+        sort_cmp_u8, sort_cmp_u32, sort_cmp_u64, sort_cmp_record, NULL};
+    static const size_t counts[] = {0, 1, 2, 17, 200, 5000};
+
+    uint64_t state = 0x9E3779B97F4A7C15u;
+    unsigned char *expected = malloc(5000 * 24);
+    assert(expected);
+
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        // 24-byte elements: order by the leading uint64_t
+        ArrayComparator cmp = cmps[s] ? cmps[s] : sort_cmp_u64;
+
+        for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+        {
+            for(int pattern = 0; pattern < 4; ++pattern)
+            {
+                size_t count = counts[c];
+                Array *a = sort_fill(sizes[s], count, pattern, &state,
+                    expected);
+
+                if(pattern == 1 || pattern == 2)
+                {
+                    qsort(array_data(a), count, sizes[s], cmp);
+                }
+                if(pattern == 2)
+                {
+                    // reverse the sorted input
+                    unsigned char *p = array_data(a);
+                    for(size_t i = 0; i < count / 2; ++i)
+                    {
+                        unsigned char tmp[24];
+                        unsigned char *x = p + i * sizes[s];
+                        unsigned char *y = p + (count - 1 - i) * sizes[s];
+                        memcpy(tmp, x, sizes[s]);
+                        memcpy(x, y, sizes[s]);
+                        memcpy(y, tmp, sizes[s]);
+                    }
+                }
+
+                assert(array_sort(a, cmp) == 0);
+                assert(array_size(a) == count);
+
+                for(size_t i = 1; i < count; ++i)
+                {
+                    assert(cmp(array_at_const(a, i - 1),
+                               array_at_const(a, i)) <= 0);
+                }
+
+                array_destroy(&a);
+            }
+        }
+    }
+
+    free(expected);
+}
+
+static void
+test_array_sort_radix(void)
+{
+    enum
+    {
+        COUNT = 4000
+    };
+
+    uint64_t state = 0xD1B54A32D192ED03u;
+    static unsigned char expected[COUNT * 8];
+
+    for(int pattern = 0; pattern < 4; ++pattern)
+    {
+        Array *a = sort_fill(4, COUNT, pattern, &state, expected);
+        qsort(expected, COUNT, 4, sort_cmp_u32);
+        assert(array_sort_u32(a) == 0);
+        assert(memcmp(array_data(a), expected, COUNT * 4) == 0);
+        array_destroy(&a);
+
+        a = sort_fill(8, COUNT, pattern, &state, expected);
+        qsort(expected, COUNT, 8, sort_cmp_u64);
+        assert(array_sort_u64(a) == 0);
+        assert(memcmp(array_data(a), expected, COUNT * 8) == 0);
+        array_destroy(&a);
+
+        a = sort_fill(8, COUNT, pattern, &state, expected);
+        qsort(expected, COUNT, 8, sort_cmp_i64);
+        assert(array_sort_i64(a) == 0);
+        assert(memcmp(array_data(a), expected, COUNT * 8) == 0);
+        array_destroy(&a);
+    }
+
+    // doubles of mixed sign and magnitude, no NaN
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(double)) == 0);
+    for(size_t i = 0; i < COUNT; ++i)
+    {
+        double v = (double)(int64_t)sort_random(&state) / 1e6;
+        if(i % 7 == 0) v = 1.0 / (double)(i + 1);
+        assert(array_push_back(a, &v) == 0);
+        memcpy(expected + i * sizeof(v), &v, sizeof(v));
+    }
+    const double special[] = {0.0, -0.0, 1e300, -1e300};
+    for(size_t i = 0; i < 4; ++i)
+    {
+        memcpy(array_at(a, i * 100), &special[i], sizeof(double));
+        memcpy(expected + i * 100 * sizeof(double), &special[i],
+            sizeof(double));
+    }
+
+    qsort(expected, COUNT, sizeof(double), sort_cmp_f64);
+    assert(array_sort_f64(a) == 0);
+
+    for(size_t i = 0; i < COUNT; ++i)
+    {
+        double x MAYBE_UNUSED = *(const double *)array_at_const(a, i);
+        double y MAYBE_UNUSED;
+        memcpy(&y, expected + i * sizeof(y), sizeof(y));
+        assert(x == y);
+    }
+
+    // -0.0 sorts before +0.0
+    for(size_t i = 1; i < COUNT; ++i)
+    {
+        const double *v = array_at_const(a, i);
+        if(*v == 0.0 && !signbit(*v))
+        {
+            assert(signbit(*(const double *)array_at_const(a, i - 1)));
+            break;
+        }
+    }
+
+    array_destroy(&a);
+}
+
+static void
+test_array_sort_by_key_is_stable(void)
+{
+    enum
+    {
+        COUNT = 3000
+    };
+
+    uint64_t state = 0x2545F4914F6CDD1Du;
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(SortRecord)) == 0);
+
+    for(uint32_t i = 0; i < COUNT; ++i)
+    {
+        SortRecord r = {(uint32_t)(sort_random(&state) % 64), i, {i, ~i}};
+        assert(array_push_back(a, &r) == 0);
+    }
+
+    assert(array_sort_by_key(a, sort_record_key, NULL) == 0);
+    assert(array_size(a) == COUNT);
+
+    for(size_t i = 1; i < COUNT; ++i)
+    {
+        const SortRecord *x MAYBE_UNUSED = array_at_const(a, i - 1);
+        const SortRecord *y MAYBE_UNUSED = array_at_const(a, i);
+
+        // equal keys keep their original order
+        assert(sort_cmp_record(x, y) < 0);
+        assert(y->payload[0] == y->order && y->payload[1] == ~y->order);
+    }
+
+    array_destroy(&a);
+}
+
+static void
+test_array_sort_parallel(void)
+{
+    enum
+    {
+        COUNT = 150000
+    };
+
+    static const size_t threads[] = {1, 2, 3, 8};
+
+    uint64_t state = 0xA0761D6478BD642Fu;
+
+    for(size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+    {
+        for(unsigned flags = 0; flags <= ARRAY_SORT_STABLE; ++flags)
+        {
+            Array *a = NULL;
+            assert(array_create(&a, sizeof(SortRecord)) == 0);
+
+            for(uint32_t i = 0; i < COUNT; ++i)
+            {
+                SortRecord r = {
+                    (uint32_t)(sort_random(&state) % 1000), i, {i, ~i}};
+                assert(array_push_back(a, &r) == 0);
+            }
+
+            assert(array_sort_parallel(a, sort_cmp_record_key, threads[t],
+                       flags) == 0);
+            assert(array_size(a) == COUNT);
+
+            uint64_t seen MAYBE_UNUSED = 0;
+            for(size_t i = 0; i < COUNT; ++i)
+            {
+                const SortRecord *y MAYBE_UNUSED = array_at_const(a, i);
+                assert(y->payload[0] == y->order &&
+                    y->payload[1] == ~y->order);
+                seen += y->order;
+
+                if(i == 0) continue;
+
+                const SortRecord *x MAYBE_UNUSED = array_at_const(a, i - 1);
+                assert(x->key <= y->key);
+                if(flags & ARRAY_SORT_STABLE)
+                {
+                    assert(x->key < y->key || x->order < y->order);
+                }
+            }
+
+            // a permutation of the input
+            assert(seen == (uint64_t)COUNT * (COUNT - 1) / 2);
+
+            array_destroy(&a);
+        }
+    }
+
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(SortRecord)) == 0);
+    assert(array_sort_parallel(a, sort_cmp_record_key, 4, 2) == EINVAL);
+    assert(array_sort_parallel(a, NULL, 4, 0) == EINVAL);
+    assert(array_sort_parallel(a, sort_cmp_record_key, 0, 0) == 0);
+    array_destroy(&a);
+}
+
+static void
+test_array_sort_invalid(void)
+{
+    Array *a = NULL;
+    assert(array_create(&a, 8) == 0);
+
+    assert(array_sort(NULL, sort_cmp_u64) == EINVAL);
+    assert(array_sort(a, NULL) == EINVAL);
+    assert(array_sort_u32(a) == EINVAL);
+    assert(array_sort_u64(NULL) == EINVAL);
+    assert(array_sort_by_key(a, NULL, NULL) == EINVAL);
+
+    // empty arrays of the right width are already sorted
+    assert(array_sort_u64(a) == 0);
+    assert(array_sort_i64(a) == 0);
+    assert(array_sort_f64(a) == 0);
+
+    array_destroy(&a);
+
+    assert(array_create(&a, 4) == 0);
+    assert(array_sort_u64(a) == EINVAL);
+    assert(array_sort_i64(a) == EINVAL);
+    assert(array_sort_f64(a) == EINVAL);
+    assert(array_sort_u32(a) == 0);
+    array_destroy(&a);
+}
+
+void
+run_array_sort_tests(void)
+{
+    test_array_sort_matches_qsort();
+    test_array_sort_radix();
+    test_array_sort_by_key_is_stable();
+    test_array_sort_parallel();
+    test_array_sort_invalid();
+}
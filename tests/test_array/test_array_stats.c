@@ -0,0 +1,141 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+#ifdef ARRAY_STATS
+static void
+test_array_stats_counts(void)
+{
+    Array *a = NULL;
+    assert(array_create_inline(&a, sizeof(int), 0, allocator_default()) == 0);
+
+    ArrayStats stats;
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.reallocations == 0);
+    assert(stats.bytes_moved == 0);
+    assert(stats.bytes_allocated > 0); // header
+
+    for(int i = 0; i < 100; ++i) assert(array_push_back(a, &i) == 0);
+
+    array_stats_reset(a);
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.reallocations == 0);
+    assert(stats.peak_size == 100);
+    assert(stats.peak_capacity == array_capacity(a));
+
+    // front insert moves every element, pop_front moves all but one
+    int v = -1;
+    assert(array_push_front(a, &v) == 0);
+    array_pop_front(a);
+
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.bytes_moved == 100 * sizeof(int) + 100 * sizeof(int));
+
+    size_t before = array_capacity(a);
+    assert(array_reserve(a, before * 4) == 0);
+    assert(array_reserve(a, before) == 0); // no reallocation
+
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.reallocations == 1);
+    assert(stats.bytes_allocated == before * 4 * sizeof(int));
+    assert(stats.bytes_freed == before * sizeof(int));
+    assert(stats.peak_capacity == before * 4);
+    assert(stats.peak_size == 101);
+
+    // the global totals cover every array
+    ArrayStats global;
+    assert(array_stats_get(NULL, &global) == 0);
+    assert(global.reallocations >= stats.reallocations);
+    assert(global.bytes_moved >= stats.bytes_moved);
+    assert(global.peak_capacity >= stats.peak_capacity);
+
+    array_stats_reset(NULL);
+    assert(array_stats_get(NULL, &global) == 0);
+    assert(global.reallocations == 0);
+
+    FILE *out = fopen("/dev/null", "w");
+    assert(out);
+    array_stats_dump(a, out);
+    array_stats_dump(NULL, out);
+    fclose(out);
+
+    array_destroy(&a);
+}
+
+static void
+test_array_stats_peaks(void)
+{
+    // capacity the array was created with counts without any growth
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+
+    ArrayStats stats;
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.reallocations == 0);
+    assert(stats.peak_capacity == array_capacity(a));
+    assert(stats.peak_capacity > 0);
+    assert(stats.peak_size == 0);
+
+    array_destroy(&a);
+
+    // a reopened file starts with its stored elements
+    char path[128];
+    snprintf(path, sizeof(path), "/tmp/ads_lib_test_stats_%ld.bin",
+        (long)getpid());
+    remove(path);
+
+    assert(array_open_mapped(&a, path, sizeof(int), ARRAY_MAPPED_CREATE) ==
+        0);
+    for(int i = 0; i < 20; ++i) assert(array_push_back(a, &i) == 0);
+    array_destroy(&a);
+
+    assert(array_open_mapped(&a, path, sizeof(int), 0) == 0);
+    assert(array_stats_get(a, &stats) == 0);
+    assert(stats.reallocations == 0);
+    assert(stats.peak_size == 20);
+    assert(stats.peak_capacity == array_capacity(a));
+
+    array_destroy(&a);
+    remove(path);
+}
+#else
+static void
+test_array_stats_counts(void)
+{
+    Array *a = NULL;
+    assert(array_create(&a, sizeof(int)) == 0);
+
+    ArrayStats stats MAYBE_UNUSED;
+    assert(array_stats_get(a, &stats) == ENOTSUP);
+    assert(array_stats_get(NULL, &stats) == ENOTSUP);
+    array_stats_reset(a);
+
+    array_destroy(&a);
+}
+#endif // ARRAY_STATS
+
+static void
+test_array_stats_invalid(void)
+{
+    assert(array_stats_get(NULL, NULL) == EINVAL);
+    array_stats_dump(NULL, NULL);
+}
+
+void
+run_array_stats_tests(void)
+{
+    test_array_stats_counts();
+#ifdef ARRAY_STATS
+    test_array_stats_peaks();
+#endif
+    test_array_stats_invalid();
+}
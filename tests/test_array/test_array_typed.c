@@ -0,0 +1,107 @@
+#include "../include/array_typed.h"
+#include "../include/arena.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+typedef struct TypedPoint
+{
+    int32_t x;
+    int32_t y;
+} TypedPoint;
+
+ARRAY_DEFINE(I64Array, int64_t)
+ARRAY_DEFINE(PointArray, TypedPoint)
+
+static void
+test_array_typed_push_get(void)
+{
+    I64Array a;
+    I64Array_init(&a);
+
+    assert(I64Array_size(&a) == 0);
+    assert(I64Array_capacity(&a) == 0);
+
+    for(int64_t i = 0; i < 1000; ++i) assert(I64Array_push_back(&a, i * 3) == 0);
+
+    assert(I64Array_size(&a) == 1000);
+    assert(I64Array_capacity(&a) >= 1000);
+
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        assert(I64Array_get(&a, i) == (int64_t)i * 3);
+    }
+
+    I64Array_set(&a, 10, -1);
+    assert(I64Array_get(&a, 10) == -1);
+
+    I64Array_pop_back(&a);
+    assert(I64Array_size(&a) == 999);
+
+    I64Array_destroy(&a);
+    assert(I64Array_data(&a) == NULL);
+    assert(I64Array_size(&a) == 0);
+}
+
+static void
+test_array_typed_at_checked(void)
+{
+    PointArray a;
+    PointArray_init(&a);
+
+    assert(PointArray_at(&a, 0) == NULL);
+
+    assert(PointArray_push_back(&a, (TypedPoint){1, 2}) == 0);
+    assert(PointArray_push_back(&a, (TypedPoint){3, 4}) == 0);
+
+    TypedPoint *p = PointArray_at(&a, 1);
+    assert(p);
+    p->x = 30;
+
+    assert(PointArray_get(&a, 1).x == 30);
+    assert(PointArray_get(&a, 1).y == 4);
+    assert(PointArray_at(&a, 2) == NULL);
+
+    PointArray_clear(&a);
+    assert(PointArray_size(&a) == 0);
+    assert(PointArray_capacity(&a) > 0);
+
+    PointArray_destroy(&a);
+}
+
+static void
+test_array_typed_push_back_n_arena(void)
+{
+    Arena *arena = NULL;
+    assert(arena_create(&arena, 0) == 0);
+
+    I64Array a;
+    I64Array_init_with_allocator(&a, arena_allocator(arena));
+
+    int64_t values[300];
+    for(int i = 0; i < 300; ++i) values[i] = 300 - i;
+
+    assert(I64Array_push_back_n(&a, values, 300) == 0);
+    assert(I64Array_push_back_n(&a, values, 300) == 0);
+
+    assert(I64Array_size(&a) == 600);
+    assert(I64Array_get(&a, 0) == 300);
+    assert(I64Array_get(&a, 599) == 1);
+
+    I64Array_destroy(&a);
+    arena_destroy(&arena);
+}
+
+void
+run_array_typed_tests(void)
+{
+    test_array_typed_push_get();
+    test_array_typed_at_checked();
+    test_array_typed_push_back_n_arena();
+}
@@ -0,0 +1,141 @@
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static int
+view_compare_int(const void *lhs, const void *rhs)
+{
+    int a = *(const int *)lhs;
+    int b = *(const int *)rhs;
+    return (a > b) - (a < b);
+}
+
+static void
+test_array_at_in_place(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    assert(array_at(a, 0) == NULL);
+    assert(array_at(NULL, 0) == NULL);
+
+    for(int i = 0; i < 10; ++i) assert(array_push_back(a, &i) == 0);
+
+    int *p = array_at(a, 4);
+    assert(p && *p == 4);
+    *p = 40;
+
+    int v MAYBE_UNUSED = 0;
+    assert(array_get(a, 4, &v) == 0);
+    assert(v == 40);
+
+    const int *cp MAYBE_UNUSED = array_at_const(a, 9);
+    assert(cp && *cp == 9);
+    assert(array_at_const(a, 10) == NULL);
+
+    array_delete(&a);
+}
+
+static void
+test_array_data_qsort(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    const int values[] = {5, 3, 9, 1, 7};
+    assert(array_push_back_n(a, values, 5) == 0);
+
+    qsort(array_data(a), array_size(a), array_element_size(a),
+        view_compare_int);
+
+    const int *data MAYBE_UNUSED = array_data_const(a);
+    assert(data[0] == 1 && data[1] == 3 && data[2] == 5);
+    assert(data[3] == 7 && data[4] == 9);
+
+    assert(array_data(NULL) == NULL);
+    assert(array_element_size(a) == sizeof(int));
+
+    array_delete(&a);
+}
+
+static void
+test_array_span_subspan(void)
+{
+    Array *a = array_init(sizeof(int));
+    assert(a);
+
+    for(int i = 0; i < 20; ++i) assert(array_push_back(a, &i) == 0);
+
+    ArraySpan span = array_span(a);
+    assert(span.len == 20);
+    assert(span.elem_size == sizeof(int));
+
+    ArraySpan sub = {NULL, 0, 0};
+    assert(array_span_subspan(span, 5, 10, &sub) == 0);
+    assert(sub.len == 10);
+    assert(*(int *)array_span_at(sub, 0) == 5);
+    assert(*(int *)array_span_at(sub, 9) == 14);
+    assert(array_span_at(sub, 10) == NULL);
+
+    ArraySpan inner = {NULL, 0, 0};
+    assert(array_span_subspan(sub, 2, 3, &inner) == 0);
+    assert(*(int *)array_span_at(inner, 0) == 7);
+
+    assert(array_span_subspan(span, 15, 6, &sub) == EINVAL);
+    assert(array_span_subspan(span, 21, 0, &sub) == EINVAL);
+    assert(array_span_subspan(span, 20, 0, &sub) == 0);
+    assert(sub.len == 0);
+
+    array_delete(&a);
+}
+
+static void
+test_array_iterator(void)
+{
+    Array *a = array_init(sizeof(double));
+    assert(a);
+
+    ArrayIterator it;
+    array_iter_init(&it, a);
+    assert(array_iter_next(&it) == NULL);
+
+    for(int i = 0; i < 100; ++i)
+    {
+        double d = i;
+        assert(array_push_back(a, &d) == 0);
+    }
+
+    double sum = 0;
+    size_t count = 0;
+
+    array_iter_init(&it, a);
+    for(double *p; (p = array_iter_next(&it));)
+    {
+        *p *= 2;
+        sum += *p;
+        ++count;
+    }
+
+    assert(count == 100);
+    assert(sum == 9900.0);
+    assert(array_iter_next(&it) == NULL);
+
+    array_delete(&a);
+}
+
+void
+run_array_view_tests(void)
+{
+    test_array_at_in_place();
+    test_array_data_qsort();
+    test_array_span_subspan();
+    test_array_iterator();
+}
@@ -0,0 +1,185 @@
+#include "../include/concurrent_array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+enum
+{
+    CONCURRENT_TEST_PRODUCERS = 4,
+    CONCURRENT_TEST_PER_PRODUCER = 20000,
+};
+
+static void
+test_concurrent_array_single_thread(void)
+{
+    ConcurrentArray *a = NULL;
+    assert(concurrent_array_create(&a, sizeof(uint64_t)) == 0);
+    assert(concurrent_array_size(a) == 0);
+    assert(concurrent_array_element_size(a) == sizeof(uint64_t));
+
+    const void *first = NULL;
+
+    // crosses several segment boundaries
+    for(uint64_t i = 0; i < 1000; ++i)
+    {
+        size_t index = SIZE_MAX;
+        assert(concurrent_array_push_back(a, &i, &index) == 0);
+        assert(index == i);
+
+        if(i == 0) first = concurrent_array_at(a, 0);
+    }
+
+    assert(concurrent_array_size(a) == 1000);
+
+    // elements never move
+    assert(concurrent_array_at(a, 0) == first);
+
+    for(size_t i = 0; i < 1000; ++i)
+    {
+        uint64_t value = 0;
+        assert(concurrent_array_get(a, i, &value) == 0);
+        assert(value == i);
+        assert(*(const uint64_t *)concurrent_array_at(a, i) == i);
+    }
+
+    uint64_t value MAYBE_UNUSED;
+    assert(concurrent_array_get(a, 1000, &value) == EINVAL);
+    assert(concurrent_array_at(a, 1000) == NULL);
+    assert(concurrent_array_push_back(a, NULL, NULL) == EINVAL);
+    assert(concurrent_array_push_back(NULL, &value, NULL) == EINVAL);
+
+    concurrent_array_destroy(&a);
+    assert(a == NULL);
+    concurrent_array_destroy(&a);
+
+    assert(concurrent_array_create(&a, 0) == EINVAL);
+    assert(a == NULL);
+}
+
+typedef struct ConcurrentTestProducer
+{
+    ConcurrentArray *array;
+    uint64_t id;
+    int error;
+} ConcurrentTestProducer;
+
+static void *
+concurrent_test_produce(void *argument)
+{
+    ConcurrentTestProducer *p = argument;
+
+    for(uint64_t seq = 0; seq < CONCURRENT_TEST_PER_PRODUCER; ++seq)
+    {
+        uint64_t value = p->id << 32 | seq;
+        if(concurrent_array_push_back(p->array, &value, NULL)) p->error = 1;
+    }
+
+    return NULL;
+}
+
+typedef struct ConcurrentTestReader
+{
+    ConcurrentArray *array;
+    atomic_bool *done;
+    int error;
+} ConcurrentTestReader;
+
+static void *
+concurrent_test_read(void *argument)
+{
+    ConcurrentTestReader *r = argument;
+
+    while(!atomic_load(r->done))
+    {
+        size_t size = concurrent_array_size(r->array);
+
+        for(size_t i = 0; i < size; ++i)
+        {
+            const uint64_t *v = concurrent_array_at(r->array, i);
+            if(!v) continue; // reserved, not yet written
+
+            if((*v >> 32) >= CONCURRENT_TEST_PRODUCERS ||
+                (*v & 0xFFFFFFFFu) >= CONCURRENT_TEST_PER_PRODUCER)
+            {
+                r->error = 1;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void
+test_concurrent_array_producers(void)
+{
+    ConcurrentArray *a = NULL;
+    assert(concurrent_array_create(&a, sizeof(uint64_t)) == 0);
+
+    atomic_bool done;
+    atomic_init(&done, false);
+
+    ConcurrentTestReader reader = {a, &done, 0};
+    pthread_t reader_thread;
+    assert(pthread_create(&reader_thread, NULL, concurrent_test_read,
+               &reader) == 0);
+
+    pthread_t threads[CONCURRENT_TEST_PRODUCERS];
+    ConcurrentTestProducer producers[CONCURRENT_TEST_PRODUCERS];
+
+    for(size_t i = 0; i < CONCURRENT_TEST_PRODUCERS; ++i)
+    {
+        producers[i] = (ConcurrentTestProducer){a, i, 0};
+        assert(pthread_create(&threads[i], NULL, concurrent_test_produce,
+                   &producers[i]) == 0);
+    }
+
+    for(size_t i = 0; i < CONCURRENT_TEST_PRODUCERS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        assert(producers[i].error == 0);
+    }
+
+    atomic_store(&done, true);
+    pthread_join(reader_thread, NULL);
+    assert(reader.error == 0);
+
+    size_t total = CONCURRENT_TEST_PRODUCERS * CONCURRENT_TEST_PER_PRODUCER;
+    assert(concurrent_array_size(a) == total);
+
+    // every value exactly once, each producer's values in push order
+    uint64_t next[CONCURRENT_TEST_PRODUCERS] = {0};
+    for(size_t i = 0; i < total; ++i)
+    {
+        uint64_t value = 0;
+        assert(concurrent_array_get(a, i, &value) == 0);
+
+        uint64_t id = value >> 32;
+        assert(id < CONCURRENT_TEST_PRODUCERS);
+        assert((value & 0xFFFFFFFFu) == next[id]);
+        ++next[id];
+    }
+
+    for(size_t i = 0; i < CONCURRENT_TEST_PRODUCERS; ++i)
+    {
+        assert(next[i] == CONCURRENT_TEST_PER_PRODUCER);
+    }
+
+    concurrent_array_destroy(&a);
+}
+
+void
+run_concurrent_array_tests(void)
+{
+    test_concurrent_array_single_thread();
+    test_concurrent_array_producers();
+}
@@ -0,0 +1,200 @@
+#include "../include/epoch_array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+enum
+{
+    EPOCH_TEST_READERS = 4,
+    EPOCH_TEST_COUNT = 100000,
+};
+
+static void
+test_epoch_array_single_thread(void)
+{
+    EpochArray *a = NULL;
+    assert(epoch_array_create(&a, sizeof(uint64_t), 2) == 0);
+    assert(epoch_array_size(a) == 0);
+    assert(epoch_array_element_size(a) == sizeof(uint64_t));
+
+    EpochArrayReader *r = NULL;
+    assert(epoch_array_reader_acquire(a, &r) == 0);
+
+    // every reader slot starts a cache line of its own
+    assert((uintptr_t)r % 64 == 0);
+
+    for(uint64_t i = 0; i < 100; ++i) assert(epoch_array_push_back(a, &i) == 0);
+
+    uint64_t values[] = {100, 101, 102};
+    assert(epoch_array_push_back_n(a, values, 3) == 0);
+    assert(epoch_array_size(a) == 103);
+
+    for(size_t i = 0; i < 103; ++i)
+    {
+        uint64_t value = 0;
+        assert(epoch_array_get(r, i, &value) == 0);
+        assert(value == i);
+    }
+
+    uint64_t value MAYBE_UNUSED;
+    assert(epoch_array_get(r, 103, &value) == EINVAL);
+
+    // only two reader slots
+    EpochArrayReader *r2 = NULL;
+    EpochArrayReader *r3 = NULL;
+    assert(epoch_array_reader_acquire(a, &r2) == 0);
+    assert(epoch_array_reader_acquire(a, &r3) == EAGAIN);
+    assert(r3 == NULL);
+    epoch_array_reader_release(&r2);
+    assert(r2 == NULL);
+    epoch_array_reader_release(&r2);
+
+    epoch_array_reader_release(&r);
+    epoch_array_destroy(&a);
+    assert(a == NULL);
+    epoch_array_destroy(&a);
+
+    assert(epoch_array_create(&a, 0, 1) == EINVAL);
+    assert(a == NULL);
+}
+
+static void
+test_epoch_array_snapshot_survives_growth(void)
+{
+    EpochArray *a = NULL;
+    assert(epoch_array_create(&a, sizeof(uint64_t), 0) == 0);
+
+    for(uint64_t i = 0; i < 8; ++i) assert(epoch_array_push_back(a, &i) == 0);
+
+    EpochArrayReader *r = NULL;
+    assert(epoch_array_reader_acquire(a, &r) == 0);
+
+    size_t size = 0;
+    const uint64_t *snapshot = epoch_array_read_begin(r, &size);
+    assert(size == 8);
+
+    // grow twice while the snapshot is held: both old buffers stay
+    assert(epoch_array_reserve(a, 64) == 0);
+    uint64_t more = 8;
+    assert(epoch_array_push_back(a, &more) == 0);
+    assert(epoch_array_reserve(a, 1024) == 0);
+    assert(epoch_array_collect(a) == 2);
+
+    for(size_t i = 0; i < size; ++i) assert(snapshot[i] == i);
+
+    epoch_array_read_end(r);
+    assert(epoch_array_collect(a) == 0);
+
+    // a reader that starts after the growth never pins old buffers
+    snapshot = epoch_array_read_begin(r, &size);
+    assert(size == 9 && snapshot[8] == 8);
+    assert(epoch_array_reserve(a, 4096) == 0);
+    assert(epoch_array_collect(a) == 1);
+    epoch_array_read_end(r);
+    assert(epoch_array_collect(a) == 0);
+
+    epoch_array_reader_release(&r);
+    epoch_array_destroy(&a);
+}
+
+typedef struct EpochTestReader
+{
+    EpochArray *array;
+    atomic_bool *done;
+    uint64_t reads;
+    int error;
+} EpochTestReader;
+
+static void *
+epoch_test_read(void *argument)
+{
+    EpochTestReader *t = argument;
+
+    EpochArrayReader *reader = NULL;
+    if(epoch_array_reader_acquire(t->array, &reader))
+    {
+        t->error = 1;
+        return NULL;
+    }
+
+    uint64_t state = (uint64_t)(uintptr_t)t | 1;
+
+    while(!atomic_load(t->done))
+    {
+        size_t size = epoch_array_size(t->array);
+        if(size == 0) continue;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        size_t index = (size_t)(state % size);
+        uint64_t value = 0;
+        if(epoch_array_get(reader, index, &value) || value != index)
+        {
+            t->error = 1;
+        }
+
+        ++t->reads;
+    }
+
+    epoch_array_reader_release(&reader);
+
+    return NULL;
+}
+
+static void
+test_epoch_array_writer_and_readers(void)
+{
+    EpochArray *a = NULL;
+    assert(epoch_array_create(&a, sizeof(uint64_t), 0) == 0);
+
+    atomic_bool done;
+    atomic_init(&done, false);
+
+    pthread_t threads[EPOCH_TEST_READERS];
+    EpochTestReader readers[EPOCH_TEST_READERS];
+
+    for(size_t i = 0; i < EPOCH_TEST_READERS; ++i)
+    {
+        readers[i] = (EpochTestReader){a, &done, 0, 0};
+        assert(pthread_create(&threads[i], NULL, epoch_test_read,
+                   &readers[i]) == 0);
+    }
+
+    for(uint64_t i = 0; i < EPOCH_TEST_COUNT; ++i)
+    {
+        assert(epoch_array_push_back(a, &i) == 0);
+    }
+
+    atomic_store(&done, true);
+
+    for(size_t i = 0; i < EPOCH_TEST_READERS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        assert(readers[i].error == 0);
+    }
+
+    // no reader left: every retired buffer can go
+    assert(epoch_array_collect(a) == 0);
+    assert(epoch_array_size(a) == EPOCH_TEST_COUNT);
+
+    epoch_array_destroy(&a);
+}
+
+void
+run_epoch_array_tests(void)
+{
+    test_epoch_array_single_thread();
+    test_epoch_array_snapshot_survives_growth();
+    test_epoch_array_writer_and_readers();
+}
@@ -0,0 +1,203 @@
+#include "../include/mpmc_queue.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+enum
+{
+    MPMC_TEST_PRODUCERS = 4,
+    MPMC_TEST_CONSUMERS = 4,
+    MPMC_TEST_PER_PRODUCER = 20000,
+};
+
+static void
+test_mpmc_single_thread(void)
+{
+    MpmcQueue *q = NULL;
+    assert(mpmc_create(&q, 24, 3) == 0);
+    assert(mpmc_capacity(q) == 4);
+    assert(mpmc_element_size(q) == 24);
+    assert(mpmc_size(q) == 0);
+
+    unsigned char value[24] = {0};
+    assert(mpmc_try_pop(q, value) == EAGAIN);
+
+    // several laps around the slots
+    for(unsigned char lap = 0; lap < 5; ++lap)
+    {
+        for(unsigned char i = 0; i < 4; ++i)
+        {
+            value[0] = lap;
+            value[23] = i;
+            assert(mpmc_try_push(q, value) == 0);
+        }
+        assert(mpmc_try_push(q, value) == EAGAIN);
+        assert(mpmc_size(q) == 4);
+
+        for(unsigned char i = 0; i < 4; ++i)
+        {
+            assert(mpmc_pop(q, value) == 0);
+            assert(value[0] == lap && value[23] == i);
+        }
+        assert(mpmc_size(q) == 0);
+    }
+
+    assert(mpmc_try_push(q, NULL) == EINVAL);
+    assert(mpmc_try_pop(NULL, value) == EINVAL);
+    assert(mpmc_push(q, NULL) == EINVAL);
+
+    mpmc_destroy(&q);
+    assert(q == NULL);
+    mpmc_destroy(&q);
+
+    // capacity 1 is rounded up: one slot cannot tell full from empty
+    assert(mpmc_create(&q, sizeof(uint64_t), 1) == 0);
+    assert(mpmc_capacity(q) == 2);
+    mpmc_destroy(&q);
+
+    assert(mpmc_create(&q, 0, 8) == EINVAL);
+    assert(q == NULL);
+    assert(mpmc_create(&q, 8, 0) == EINVAL);
+}
+
+typedef struct MpmcTestWorker
+{
+    MpmcQueue *queue;
+    uint64_t id;
+    bool blocking;
+    size_t received;
+    uint64_t sum;
+    int error;
+} MpmcTestWorker;
+
+static void *
+mpmc_test_produce(void *argument)
+{
+    MpmcTestWorker *w = argument;
+
+    for(uint64_t seq = 0; seq < MPMC_TEST_PER_PRODUCER; ++seq)
+    {
+        uint64_t value = w->id << 32 | seq;
+
+        if(w->blocking)
+        {
+            if(mpmc_push(w->queue, &value)) w->error = 1;
+            continue;
+        }
+
+        while(mpmc_try_push(w->queue, &value) == EAGAIN) sched_yield();
+    }
+
+    return NULL;
+}
+
+static void *
+mpmc_test_consume(void *argument)
+{
+    MpmcTestWorker *w = argument;
+
+    // each consumer sees every producer's values in push order
+    uint64_t last[MPMC_TEST_PRODUCERS];
+    for(size_t i = 0; i < MPMC_TEST_PRODUCERS; ++i) last[i] = UINT64_MAX;
+
+    size_t quota = MPMC_TEST_PRODUCERS * MPMC_TEST_PER_PRODUCER /
+        MPMC_TEST_CONSUMERS;
+
+    while(w->received < quota)
+    {
+        uint64_t value = 0;
+
+        if(w->blocking)
+        {
+            if(mpmc_pop(w->queue, &value)) w->error = 1;
+        }
+        else if(mpmc_try_pop(w->queue, &value) == EAGAIN)
+        {
+            sched_yield();
+            continue;
+        }
+
+        uint64_t id = value >> 32;
+        uint64_t seq = value & 0xFFFFFFFFu;
+
+        if(id >= MPMC_TEST_PRODUCERS) w->error = 1;
+        else if(last[id] != UINT64_MAX && seq <= last[id]) w->error = 1;
+        else last[id] = seq;
+
+        w->sum += value;
+        ++w->received;
+    }
+
+    return NULL;
+}
+
+static void
+test_mpmc_workers(bool blocking, size_t capacity)
+{
+    MpmcQueue *q = NULL;
+    assert(mpmc_create(&q, sizeof(uint64_t), capacity) == 0);
+
+    pthread_t threads[MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS];
+    MpmcTestWorker workers[MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS];
+
+    for(size_t i = 0; i < MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS; ++i)
+    {
+        bool producer = i < MPMC_TEST_PRODUCERS;
+
+        workers[i] = (MpmcTestWorker){q, i, blocking, 0, 0, 0};
+        assert(pthread_create(&threads[i], NULL,
+                   producer ? mpmc_test_produce : mpmc_test_consume,
+                   &workers[i]) == 0);
+    }
+
+    uint64_t sum = 0;
+    size_t received = 0;
+
+    for(size_t i = 0; i < MPMC_TEST_PRODUCERS + MPMC_TEST_CONSUMERS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        assert(workers[i].error == 0);
+
+        sum += workers[i].sum;
+        received += workers[i].received;
+    }
+
+    uint64_t expected = 0;
+    for(uint64_t id = 0; id < MPMC_TEST_PRODUCERS; ++id)
+    {
+        for(uint64_t seq = 0; seq < MPMC_TEST_PER_PRODUCER; ++seq)
+        {
+            expected += id << 32 | seq;
+        }
+    }
+
+    assert(received == MPMC_TEST_PRODUCERS * MPMC_TEST_PER_PRODUCER);
+    assert(sum == expected);
+    assert(mpmc_size(q) == 0);
+
+    uint64_t value MAYBE_UNUSED;
+    assert(mpmc_try_pop(q, &value) == EAGAIN);
+
+    mpmc_destroy(&q);
+}
+
+void
+run_mpmc_queue_tests(void)
+{
+    test_mpmc_single_thread();
+    test_mpmc_workers(false, 64);
+    // tiny capacity: both sides sleep often
+    test_mpmc_workers(true, 2);
+    test_mpmc_workers(true, 256);
+}
@@ -0,0 +1,138 @@
+#include "../include/spsc_ring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+enum
+{
+    SPSC_TEST_ITEMS = 200000,
+    SPSC_TEST_BATCH = 37,
+};
+
+static void
+test_spsc_single_thread(void)
+{
+    SpscRing *r = NULL;
+    assert(spsc_create(&r, sizeof(uint32_t), 5) == 0);
+    assert(spsc_capacity(r) == 8);
+    assert(spsc_element_size(r) == sizeof(uint32_t));
+    assert(spsc_size(r) == 0);
+
+    uint32_t value = 0;
+    assert(spsc_pop(r, &value) == EAGAIN);
+
+    for(uint32_t i = 0; i < 8; ++i) assert(spsc_push(r, &i) == 0);
+    assert(spsc_push(r, &value) == EAGAIN);
+    assert(spsc_size(r) == 8);
+
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        assert(spsc_pop(r, &value) == 0);
+        assert(value == i);
+    }
+    assert(spsc_size(r) == 0);
+
+    // batches that wrap around the end of the slots
+    uint32_t in[8] = {10, 11, 12, 13, 14, 15, 16, 17};
+    uint32_t out[8] = {0};
+    size_t moved = 0;
+
+    assert(spsc_push_n(r, in, 3, &moved) == 0 && moved == 3);
+    assert(spsc_pop_n(r, out, 3, &moved) == 0 && moved == 3);
+    assert(spsc_push_n(r, in, 8, &moved) == 0 && moved == 8);
+    assert(spsc_push_n(r, in, 1, &moved) == EAGAIN && moved == 0);
+
+    assert(spsc_pop_n(r, out, 5, &moved) == 0 && moved == 5);
+    assert(spsc_push_n(r, in, 8, &moved) == 0 && moved == 5);
+    assert(spsc_pop_n(r, out, 8, &moved) == 0 && moved == 8);
+    assert(out[0] == 15 && out[2] == 17 && out[3] == 10 && out[7] == 14);
+    assert(spsc_pop_n(r, out, 8, &moved) == EAGAIN && moved == 0);
+
+    assert(spsc_push_n(r, NULL, 1, NULL) == EINVAL);
+    assert(spsc_push_n(r, NULL, 0, NULL) == 0);
+    assert(spsc_pop(r, NULL) == EINVAL);
+
+    spsc_destroy(&r);
+    assert(r == NULL);
+    spsc_destroy(&r);
+
+    assert(spsc_create(&r, sizeof(uint32_t), 0) == EINVAL);
+    assert(r == NULL);
+    assert(spsc_create(&r, 0, 8) == EINVAL);
+}
+
+static void *
+spsc_test_produce(void *argument)
+{
+    SpscRing *r = argument;
+    uint32_t batch[SPSC_TEST_BATCH];
+    uint32_t next = 0;
+
+    while(next < SPSC_TEST_ITEMS)
+    {
+        size_t count = SPSC_TEST_ITEMS - next;
+        if(count > SPSC_TEST_BATCH) count = SPSC_TEST_BATCH;
+
+        for(size_t i = 0; i < count; ++i) batch[i] = next + (uint32_t)i;
+
+        size_t pushed = 0;
+        if(spsc_push_n(r, batch, count, &pushed) == EAGAIN) sched_yield();
+        next += (uint32_t)pushed;
+    }
+
+    return NULL;
+}
+
+static void
+test_spsc_producer_consumer(void)
+{
+    SpscRing *r = NULL;
+    assert(spsc_create(&r, sizeof(uint32_t), 64) == 0);
+
+    pthread_t producer;
+    assert(pthread_create(&producer, NULL, spsc_test_produce, r) == 0);
+
+    // odd batch sizes on both sides so copies wrap at varying offsets
+    uint32_t batch[SPSC_TEST_BATCH + 4];
+    uint32_t expected = 0;
+
+    while(expected < SPSC_TEST_ITEMS)
+    {
+        size_t popped = 0;
+        if(spsc_pop_n(r, batch, SPSC_TEST_BATCH + 4, &popped) == EAGAIN)
+        {
+            sched_yield();
+            continue;
+        }
+
+        for(size_t i = 0; i < popped; ++i)
+        {
+            assert(batch[i] == expected);
+            ++expected;
+        }
+    }
+
+    pthread_join(producer, NULL);
+
+    uint32_t value MAYBE_UNUSED;
+    assert(spsc_pop(r, &value) == EAGAIN);
+
+    spsc_destroy(&r);
+}
+
+void
+run_spsc_ring_tests(void)
+{
+    test_spsc_single_thread();
+    test_spsc_producer_consumer();
+}
@@ -0,0 +1,157 @@
+#include "../include/deque.h"
+
+#include <assert.h>
+#include <errno.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static int
+deque_get_int(const Deque *d, size_t index)
+{
+    int value = -1;
+    assert(deque_get(d, index, &value) == 0);
+    return value;
+}
+
+static void
+test_deque_create_destroy(void)
+{
+    Deque *d = NULL;
+
+    assert(deque_create(NULL, sizeof(int)) == EINVAL);
+    assert(deque_create(&d, 0) == EINVAL);
+    assert(d == NULL);
+
+    assert(deque_create(&d, sizeof(int)) == 0);
+    assert(d);
+    assert(deque_size(d) == 0);
+    assert(deque_capacity(d) > 0);
+
+    deque_destroy(&d);
+    assert(d == NULL);
+    deque_destroy(&d);
+    deque_destroy(NULL);
+}
+
+static void
+test_deque_fifo_wraps_around(void)
+{
+    Deque *d = NULL;
+    assert(deque_create(&d, sizeof(int)) == 0);
+
+    const size_t cap MAYBE_UNUSED = deque_capacity(d);
+
+    int next_in = 0;
+    int next_out = 0;
+
+    // steady-state queue: never exceeds initial capacity, head keeps moving
+    for(int round = 0; round < 100; ++round)
+    {
+        for(int k = 0; k < 5; ++k)
+        {
+            assert(deque_push_back(d, &next_in) == 0);
+            ++next_in;
+        }
+
+        for(int k = 0; k < 5; ++k)
+        {
+            assert(deque_get_int(d, 0) == next_out);
+            deque_pop_front(d);
+            ++next_out;
+        }
+    }
+
+    assert(deque_size(d) == 0);
+    assert(deque_capacity(d) == cap);
+
+    deque_destroy(&d);
+}
+
+static void
+test_deque_grow_while_wrapped(void)
+{
+    Deque *d = NULL;
+    assert(deque_create(&d, sizeof(int)) == 0);
+
+    for(int i = 0; i < 6; ++i) assert(deque_push_back(d, &i) == 0);
+    for(int i = 0; i < 4; ++i) deque_pop_front(d);
+
+    // live range now wraps once more elements are appended
+    for(int i = 6; i < 100; ++i) assert(deque_push_back(d, &i) == 0);
+
+    assert(deque_size(d) == 96);
+    for(size_t i = 0; i < 96; ++i) assert(deque_get_int(d, i) == (int)i + 4);
+
+    deque_destroy(&d);
+}
+
+static void
+test_deque_push_front_back(void)
+{
+    Deque *d = NULL;
+    assert(deque_create(&d, sizeof(int)) == 0);
+
+    for(int i = 0; i < 50; ++i)
+    {
+        assert(deque_push_back(d, &i) == 0);
+        int negative = -i - 1;
+        assert(deque_push_front(d, &negative) == 0);
+    }
+
+    assert(deque_size(d) == 100);
+    for(size_t i = 0; i < 100; ++i)
+    {
+        assert(deque_get_int(d, i) == (int)i - 50);
+    }
+
+    deque_pop_back(d);
+    deque_pop_front(d);
+    assert(deque_size(d) == 98);
+    assert(deque_get_int(d, 0) == -49);
+    assert(deque_get_int(d, 97) == 48);
+
+    assert(deque_set(d, 5, &(int){1000}) == 0);
+    assert(deque_get_int(d, 5) == 1000);
+    assert(deque_set(d, 98, &(int){0}) == EINVAL);
+
+    deque_destroy(&d);
+}
+
+static void
+test_deque_insert_erase(void)
+{
+    Deque *d = NULL;
+    assert(deque_create(&d, sizeof(int)) == 0);
+
+    for(int i = 0; i < 10; ++i) assert(deque_push_back(d, &i) == 0);
+
+    assert(deque_insert(d, &(int){100}, 2) == 0); // shifts front side
+    assert(deque_insert(d, &(int){200}, 9) == 0); // shifts back side
+
+    const int expected[] = {0, 1, 100, 2, 3, 4, 5, 6, 7, 200, 8, 9};
+    for(size_t i = 0; i < 12; ++i) assert(deque_get_int(d, i) == expected[i]);
+
+    assert(deque_erase(d, 2) == 0);
+    assert(deque_erase(d, 8) == 0);
+
+    for(size_t i = 0; i < 10; ++i) assert(deque_get_int(d, i) == (int)i);
+
+    assert(deque_insert(d, &(int){0}, 11) == EINVAL);
+    assert(deque_erase(d, 10) == EINVAL);
+
+    deque_destroy(&d);
+}
+
+void
+run_deque_tests(void)
+{
+    test_deque_create_destroy();
+    test_deque_fifo_wraps_around();
+    test_deque_grow_while_wrapped();
+    test_deque_push_front_back();
+    test_deque_insert_erase();
+}
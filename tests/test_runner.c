@@ -1,11 +1,34 @@
 #include "test_runner.h"
 
+#include "test_allocator/test_allocator_trace.c"
+#include "test_allocator/test_arena.c"
+#include "test_allocator/test_mmap_allocator.c"
+#include "test_allocator/test_pool.c"
 #include "test_array/test_array.c"
+#include "test_array/test_array_batch.c"
 #include "test_array/test_array_create_destroy.c"
 #include "test_array/test_array_erase.c"
 #include "test_array/test_array_init.c"
+#include "test_array/test_array_filter.c"
+#include "test_array/test_array_growth.c"
+#include "test_array/test_array_inline.c"
 #include "test_array/test_array_insert.c"
+#include "test_array/test_array_io.c"
+#include "test_array/test_array_mapped.c"
+#include "test_array/test_array_parallel.c"
+#include "test_array/test_array_range.c"
+#include "test_array/test_array_sort.c"
+#include "test_array/test_array_stats.c"
+#include "test_array/test_array_typed.c"
+#include "test_array/test_array_view.c"
 #include "test_array/test_overflow_detector.c"
+#include "test_concurrent/test_concurrent_array.c"
+#include "test_concurrent/test_epoch_array.c"
+#include "test_concurrent/test_mpmc_queue.c"
+#include "test_concurrent/test_spsc_ring.c"
+#include "test_deque/test_deque.c"
+#include "test_segmented_array/test_segmented_array.c"
+#include "test_thread_pool/test_thread_pool.c"
 
 #include <stdio.h>
 
@@ -14,13 +37,41 @@ test_runner(void)
 {
     printf("Running tests...\n");
 
+    run_array_batch_tests();
     run_array_create_destroy_tests();
     run_array_erase_tests();
     run_array_init_tests();
+    run_array_filter_tests();
+    run_array_growth_tests();
+    run_array_inline_tests();
     run_array_insert_tests();
+    run_array_io_tests();
+    run_array_mapped_tests();
+    run_array_parallel_tests();
+    run_array_range_tests();
+    run_array_sort_tests();
+    run_array_stats_tests();
+    run_array_typed_tests();
+    run_array_view_tests();
     run_array_smoke_tests();
 
     run_overflow_tests();
 
+    run_allocator_trace_tests();
+    run_arena_tests();
+    run_mmap_allocator_tests();
+    run_pool_tests();
+
+    run_concurrent_array_tests();
+    run_epoch_array_tests();
+    run_mpmc_queue_tests();
+    run_spsc_ring_tests();
+
+    run_deque_tests();
+
+    run_segmented_array_tests();
+
+    run_thread_pool_tests();
+
     printf("All tests passed\n");
 }
@@ -0,0 +1,184 @@
+#include "../include/segmented_array.h"
+
+#include "../include/array.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+static void
+test_segmented_array_basic(void)
+{
+    SegmentedArray *a = NULL;
+    assert(segmented_array_create(&a, sizeof(uint64_t)) == 0);
+    assert(segmented_array_size(a) == 0);
+    assert(segmented_array_capacity(a) == 0);
+    assert(segmented_array_element_size(a) == sizeof(uint64_t));
+    assert(segmented_array_at(a, 0) == NULL);
+
+    uint64_t *first = NULL;
+    uint64_t *middle = NULL;
+
+    // crosses several chunk boundaries (64, 192, 448, ...)
+    for(uint64_t i = 0; i < 5000; ++i)
+    {
+        assert(segmented_array_push_back(a, &i) == 0);
+        if(i == 0) first = segmented_array_at(a, 0);
+        if(i == 100) middle = segmented_array_at(a, 100);
+    }
+
+    assert(segmented_array_size(a) == 5000);
+    assert(segmented_array_capacity(a) >= 5000);
+
+    // growth never moves an element
+    assert(segmented_array_at(a, 0) == first && *first == 0);
+    assert(segmented_array_at(a, 100) == middle && *middle == 100);
+
+    for(size_t i = 0; i < 5000; ++i)
+    {
+        uint64_t value = 0;
+        assert(segmented_array_get(a, i, &value) == 0);
+        assert(value == i);
+        assert(*(const uint64_t *)segmented_array_at_const(a, i) == i);
+    }
+
+    uint64_t value = 7;
+    assert(segmented_array_set(a, 4999, &value) == 0);
+    assert(segmented_array_get(a, 4999, &value) == 0 && value == 7);
+    assert(segmented_array_get(a, 5000, &value) == EINVAL);
+    assert(segmented_array_set(a, 5000, &value) == EINVAL);
+
+    segmented_array_pop_back(a);
+    assert(segmented_array_size(a) == 4999);
+
+    // the chunk walk visits every element in order
+    size_t seen = 0;
+    size_t count = 0;
+    uint64_t *chunk;
+    for(size_t k = 0; (chunk = segmented_array_chunk(a, k, &count)); ++k)
+    {
+        for(size_t i = 0; i < count; ++i) assert(chunk[i] == seen + i);
+        seen += count;
+    }
+    assert(seen == 4999 && count == 0);
+
+    size_t capacity MAYBE_UNUSED = segmented_array_capacity(a);
+    segmented_array_clear(a);
+    assert(segmented_array_size(a) == 0);
+    assert(segmented_array_capacity(a) == capacity);
+    assert(segmented_array_shrink_fit(a) == 0);
+    assert(segmented_array_capacity(a) == 0);
+
+    assert(segmented_array_push_back(a, NULL) == EINVAL);
+    assert(segmented_array_push_back(NULL, &value) == EINVAL);
+
+    segmented_array_destroy(&a);
+    assert(a == NULL);
+    segmented_array_destroy(&a);
+
+    assert(segmented_array_create(&a, 0) == EINVAL);
+    assert(a == NULL);
+}
+
+static void
+test_segmented_array_push_n(void)
+{
+    SegmentedArray *a = NULL;
+    assert(segmented_array_create(&a, sizeof(uint32_t)) == 0);
+
+    uint32_t values[1000];
+    for(uint32_t i = 0; i < 1000; ++i) values[i] = i;
+
+    // batches straddling chunk boundaries at varying offsets
+    for(size_t round = 0; round < 7; ++round)
+    {
+        assert(segmented_array_push_back_n(a, values, 1000 - round * 97) ==
+            0);
+    }
+
+    size_t index = 0;
+    for(size_t round = 0; round < 7; ++round)
+    {
+        for(uint32_t i = 0; i < 1000 - round * 97; ++i, ++index)
+        {
+            uint32_t value = 0;
+            assert(segmented_array_get(a, index, &value) == 0);
+            assert(value == i);
+        }
+    }
+    assert(segmented_array_size(a) == index);
+
+    assert(segmented_array_reserve(a, 100000) == 0);
+    assert(segmented_array_capacity(a) >= 100000);
+    assert(segmented_array_size(a) == index);
+
+    assert(segmented_array_push_back_n(a, NULL, 0) == 0);
+    assert(segmented_array_push_back_n(a, NULL, 1) == EINVAL);
+
+    // shrink keeps every chunk that holds an element
+    assert(segmented_array_shrink_fit(a) == 0);
+    assert(segmented_array_capacity(a) >= index);
+    assert(segmented_array_capacity(a) < 2 * index + 64);
+    assert(*(uint32_t *)segmented_array_at(a, index - 1) ==
+        1000 - 6 * 97 - 1);
+
+    segmented_array_destroy(&a);
+}
+
+static void
+test_segmented_array_flatten(void)
+{
+    SegmentedArray *a = NULL;
+    assert(segmented_array_create(&a, sizeof(uint64_t)) == 0);
+
+    for(uint64_t i = 0; i < 3000; ++i)
+    {
+        uint64_t value = i * i;
+        assert(segmented_array_push_back(a, &value) == 0);
+    }
+
+    Array *flat = NULL;
+    assert(array_create(&flat, sizeof(uint64_t)) == 0);
+
+    // grows a short destination
+    uint64_t stale = 99;
+    assert(array_push_back(flat, &stale) == 0);
+    assert(segmented_array_flatten(a, flat) == 0);
+    assert(array_size(flat) == 3000);
+
+    const uint64_t *data = array_data_const(flat);
+    for(uint64_t i = 0; i < 3000; ++i) assert(data[i] == i * i);
+
+    // shrinks a long one
+    for(size_t i = 0; i < 2500; ++i) segmented_array_pop_back(a);
+    assert(segmented_array_flatten(a, flat) == 0);
+    assert(array_size(flat) == 500);
+
+    segmented_array_clear(a);
+    assert(segmented_array_flatten(a, flat) == 0);
+    assert(array_size(flat) == 0);
+
+    Array *wrong = NULL;
+    assert(array_create(&wrong, sizeof(uint32_t)) == 0);
+    assert(segmented_array_flatten(a, wrong) == EINVAL);
+    assert(segmented_array_flatten(a, NULL) == EINVAL);
+
+    array_destroy(&wrong);
+    array_destroy(&flat);
+    segmented_array_destroy(&a);
+}
+
+void
+run_segmented_array_tests(void)
+{
+    test_segmented_array_basic();
+    test_segmented_array_push_n();
+    test_segmented_array_flatten();
+}
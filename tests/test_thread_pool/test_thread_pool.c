@@ -0,0 +1,185 @@
+#include "../include/thread_pool.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef __GNUC__
+#define MAYBE_UNUSED __attribute__((unused))
+#else
+#define MAYBE_UNUSED
+#endif
+
+typedef struct PoolVisit
+{
+    atomic_uchar *seen;
+    size_t grain;
+    atomic_size_t calls;
+    atomic_int bad_range;
+} PoolVisit;
+
+static void
+pool_visit_range(void *context, size_t begin, size_t end)
+{
+    PoolVisit *visit = context;
+
+    if(begin >= end || end - begin > visit->grain)
+    {
+        atomic_store(&visit->bad_range, 1);
+    }
+
+    for(size_t i = begin; i < end; ++i) atomic_fetch_add(&visit->seen[i], 1);
+
+    atomic_fetch_add(&visit->calls, 1);
+}
+
+static void
+pool_check_visit(ThreadPool *pool, size_t count, size_t grain)
+{
+    PoolVisit visit = {.grain = grain ? grain : 1};
+    visit.seen = calloc(count + 1, sizeof(*visit.seen));
+    assert(visit.seen);
+    atomic_init(&visit.calls, 0);
+    atomic_init(&visit.bad_range, 0);
+
+    assert(thread_pool_for(pool, count, grain, pool_visit_range, &visit) == 0);
+
+    assert(!atomic_load(&visit.bad_range));
+    for(size_t i = 0; i < count; ++i) assert(atomic_load(&visit.seen[i]) == 1);
+
+    free(visit.seen);
+}
+
+static void
+test_thread_pool_for_visits_once(void)
+{
+    static const size_t threads[] = {1, 3, 8};
+
+    for(size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+    {
+        ThreadPool *pool = NULL;
+        assert(thread_pool_create(&pool, threads[t]) == 0);
+        assert(thread_pool_size(pool) == threads[t]);
+
+        pool_check_visit(pool, 0, 1);
+        pool_check_visit(pool, 1, 0);
+        pool_check_visit(pool, 1000, 1);
+        pool_check_visit(pool, 100000, 333);
+        pool_check_visit(pool, 12345, 100000);
+
+        thread_pool_destroy(&pool);
+        assert(pool == NULL);
+        thread_pool_destroy(&pool);
+    }
+}
+
+typedef struct PoolNested
+{
+    ThreadPool *pool;
+    atomic_size_t total;
+} PoolNested;
+
+static void
+pool_nested_inner(void *context, size_t begin, size_t end)
+{
+    PoolNested *nested = context;
+    atomic_fetch_add(&nested->total, end - begin);
+}
+
+static void
+pool_nested_outer(void *context, size_t begin, size_t end)
+{
+    PoolNested *nested = context;
+
+    for(size_t i = begin; i < end; ++i)
+    {
+        int error MAYBE_UNUSED = thread_pool_for(nested->pool, 100, 7,
+            pool_nested_inner, nested);
+        assert(error == 0);
+    }
+}
+
+typedef struct PoolCaller
+{
+    ThreadPool *pool;
+    PoolNested nested;
+} PoolCaller;
+
+static void *
+pool_caller_thread(void *argument)
+{
+    PoolCaller *caller = argument;
+
+    int error MAYBE_UNUSED = thread_pool_for(caller->pool, 50, 1,
+        pool_nested_outer, &caller->nested);
+    assert(error == 0);
+
+    return NULL;
+}
+
+static void
+test_thread_pool_nested_and_concurrent(void)
+{
+    ThreadPool *pool = NULL;
+    assert(thread_pool_create(&pool, 3) == 0);
+
+    // loops started from inside a loop body
+    PoolNested nested = {.pool = pool};
+    atomic_init(&nested.total, 0);
+    assert(thread_pool_for(pool, 64, 1, pool_nested_outer, &nested) == 0);
+    assert(atomic_load(&nested.total) == 64 * 100);
+
+    // several outside threads sharing the pool
+    enum
+    {
+        CALLERS = 4
+    };
+    pthread_t threads[CALLERS];
+    PoolCaller callers[CALLERS];
+
+    for(size_t i = 0; i < CALLERS; ++i)
+    {
+        callers[i].pool = pool;
+        callers[i].nested.pool = pool;
+        atomic_init(&callers[i].nested.total, 0);
+        assert(pthread_create(&threads[i], NULL, pool_caller_thread,
+                   &callers[i]) == 0);
+    }
+
+    for(size_t i = 0; i < CALLERS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        assert(atomic_load(&callers[i].nested.total) == 50 * 100);
+    }
+
+    thread_pool_destroy(&pool);
+}
+
+static void
+test_thread_pool_invalid(void)
+{
+    ThreadPool *pool = NULL;
+
+    assert(thread_pool_create(NULL, 1) == EINVAL);
+    assert(thread_pool_create(&pool, 100000) == EINVAL);
+    assert(pool == NULL);
+    assert(thread_pool_for(NULL, 1, 1, pool_nested_inner, NULL) == EINVAL);
+
+    assert(thread_pool_create(&pool, 0) == 0);
+    assert(thread_pool_for(pool, 1, 1, NULL, NULL) == EINVAL);
+    thread_pool_destroy(&pool);
+
+    assert(thread_pool_default() != NULL);
+    assert(thread_pool_default() == thread_pool_default());
+    assert(thread_pool_size(NULL) == 0);
+}
+
+void
+run_thread_pool_tests(void)
+{
+    test_thread_pool_for_visits_once();
+    test_thread_pool_nested_and_concurrent();
+    test_thread_pool_invalid();
+}